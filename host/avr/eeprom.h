@@ -0,0 +1,25 @@
+/**
+ * @brief 主机编译用EEPROM头文件
+ * @file host/avr/eeprom.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<avr/eeprom.h>。EEMEM变量放在普通数据区，读写函数直接访问，见sim.c
+ */
+#ifndef SIM_AVR_EEPROM_H
+#define SIM_AVR_EEPROM_H
+#include <stddef.h>
+#include <stdint.h>
+
+#define EEMEM __attribute__ ((section (".eeprom"))) /**<EEPROM变量*/
+#define E2END 0x3ffU /**<EEPROM最高地址*/
+#define eeprom_is_ready() (1) /**<仿真EEPROM写入立即完成*/
+
+uint8_t eeprom_read_byte(const uint8_t *p);
+void eeprom_write_byte(uint8_t *p,uint8_t value);
+void eeprom_update_byte(uint8_t *p,uint8_t value);
+void eeprom_read_block(void *dst,const void *src,size_t n);
+void eeprom_write_block(const void *src,void *dst,size_t n);
+void eeprom_update_block(const void *src,void *dst,size_t n);
+#endif
@@ -0,0 +1,17 @@
+/**
+ * @brief 主机编译用中断头文件
+ * @file host/avr/interrupt.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<avr/interrupt.h>。ISR(vector)定义为普通函数void vector(void)，测试程序可直接调用中断服务程序；sei()/cli()只改变仿真SREG的I位
+ */
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+#include <avr/io.h>
+
+#define ISR(vector, ...) void vector(void); void vector(void) /**<中断服务程序定义为普通函数*/
+#define sei() __builtin_avr_sei() /**<开总中断*/
+#define cli() __builtin_avr_cli() /**<关总中断*/
+#endif
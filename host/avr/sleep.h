@@ -0,0 +1,20 @@
+/**
+ * @brief 主机编译用睡眠头文件
+ * @file host/avr/sleep.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<avr/sleep.h>，睡眠设置写入仿真SMCR，睡眠指令立即返回
+ */
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE  0x00U
+#define set_sleep_mode(m) (SMCR = (uint8_t)((SMCR & _BV(SE)) | (m)))
+#define sleep_enable()   (SMCR |= _BV(SE))
+#define sleep_disable()  (SMCR &= (uint8_t)~_BV(SE))
+#define sleep_cpu()      ((void)0)
+#define sleep_mode()     ((void)0)
+#endif
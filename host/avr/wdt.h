@@ -0,0 +1,26 @@
+/**
+ * @brief 主机编译用看门狗头文件
+ * @file host/avr/wdt.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<avr/wdt.h>，看门狗设置写入仿真WDTCSR，复位看门狗不执行
+ */
+#ifndef SIM_AVR_WDT_H
+#define SIM_AVR_WDT_H
+#include <avr/io.h>
+
+#define WDTO_15MS   0
+#define WDTO_30MS   1
+#define WDTO_60MS   2
+#define WDTO_120MS  3
+#define WDTO_250MS  4
+#define WDTO_500MS  5
+#define WDTO_1S     6
+#define WDTO_2S     7
+
+#define wdt_reset() __builtin_avr_wdr()
+#define wdt_enable(t) (WDTCSR = (uint8_t)(0x08U | ((t) & 0x07U) | (((t) & 0x08U) << 2)))
+#define wdt_disable() (WDTCSR = 0)
+#endif
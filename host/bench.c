@@ -0,0 +1,354 @@
+/**
+ * @brief simavr仿真基准测试
+ * @file host/bench.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 在simavr中运行pulse.elf（自动模式），每次开放触发后在PD2注入一个下降沿触发，触发时刻相对
+ * 定时器2中断（显示刷新）的相位逐次扫过一个刷新周期；记录PB1脉冲的两个边沿，统计：\n
+ * - 触发到延时边沿的时延误差分布（实测延时减去预定延时）\n
+ * - @ref tims 每组参数的延时、脉宽误差\n
+ * - 各中断服务程序从中断向量到reti执行完的最坏周期数\n
+ * 结果按JSON Lines逐行输出到标准输出，每行一个对象，type为shot、latency、isr、timeout之一，时间
+ * 单位为CPU周期（16MHz）。OC0A（PD6）的时基接到T1（PD5），与开发板上的连线相同。每次触发从上一次
+ * 脉冲完成起限 @ref BENCH_SHOT_CYCLES 个周期，超时时输出timeout及停在哪一步，返回非零。
+ * 用法：bench pulse.elf [触发次数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+#define BENCH_FCPU        16000000UL /**<CPU时钟*/
+#define BENCH_T2_PERIOD   32000U     /**<定时器2比较匹配周期，128分频×250*/
+#define BENCH_SETTLE      (BENCH_FCPU / 20U) /**<开放触发后到注入触发的最短时间，50ms*/
+#define BENCH_TRIG_LOW    1600U      /**<触发低电平保持时间，100us*/
+#define BENCH_TICK        1600U      /**<0.1ms时基对应的周期数*/
+#define BENCH_SHOTS       40U        /**<缺省触发次数，自动模式两轮*/
+#define BENCH_NVECT       26U        /**<atmega328p中断向量数*/
+#define BENCH_RETI        0x9518U    /**<reti指令码*/
+#define BENCH_SHOT_CYCLES (BENCH_FCPU * 12U) /**<每次触发的周期预算，最长延时10s加脉宽1s，留1s余量*/
+
+/**
+ * @brief 单次触发的测量结果
+ */
+typedef struct bench_shot
+{
+  uint32_t dly_exp;      /**<预定延时，单位0.1ms*/
+  uint32_t wtd_exp;      /**<预定脉宽，单位0.1ms*/
+  uint32_t phase;        /**<触发时刻相对定时器2中断的相位，周期数*/
+  avr_cycle_count_t trig;/**<触发时刻*/
+  avr_cycle_count_t rise;/**<延时边沿时刻*/
+  avr_cycle_count_t fall;/**<脉宽边沿时刻*/
+}sbshot_t;
+
+/**
+ * @brief 中断服务程序周期统计
+ */
+typedef struct bench_isr
+{
+  uint32_t count;        /**<次数*/
+  uint32_t min;          /**<最少周期数*/
+  uint32_t max;          /**<最多周期数*/
+  uint64_t sum;          /**<周期数累计*/
+}sbisr_t;
+
+static const char *bench_vname[BENCH_NVECT] =
+{
+  "RESET","INT0_vect","INT1_vect","PCINT0_vect","PCINT1_vect","PCINT2_vect","WDT_vect",
+  "TIMER2_COMPA_vect","TIMER2_COMPB_vect","TIMER2_OVF_vect","TIMER1_CAPT_vect",
+  "TIMER1_COMPA_vect","TIMER1_COMPB_vect","TIMER1_OVF_vect","TIMER0_COMPA_vect",
+  "TIMER0_COMPB_vect","TIMER0_OVF_vect","SPI_STC_vect","USART_RX_vect","USART_UDRE_vect",
+  "USART_TX_vect","ADC_vect","EE_READY_vect","ANALOG_COMP_vect","TWI_vect","SPM_READY_vect"
+};
+
+static avr_t *bench_avr;
+static avr_irq_t *bench_trig_irq;     /*PD2，触发输入*/
+static sbshot_t *bench_shots;
+static uint32_t bench_nshots;         /*计划触发次数*/
+static uint32_t bench_cur;            /*当前触发序号*/
+static int bench_waiting;             /*已注入触发，等待脉冲完成*/
+static avr_cycle_count_t bench_t2;    /*最近一次定时器2中断的时刻*/
+static char bench_line[64];           /*串口接收行*/
+static uint32_t bench_linelen;
+static int bench_armed;               /*上一行为“Start generate”*/
+static sbisr_t bench_isr[BENCH_NVECT];
+static avr_cycle_count_t bench_shot_t0; /*上一次脉冲完成的时刻，当前触发的预算起点*/
+
+/**
+ *@brief 触发线恢复高电平
+ */
+static avr_cycle_count_t bench_trig_release(avr_t *avr,avr_cycle_count_t when,void *param)
+{
+  avr_raise_irq(bench_trig_irq,1);
+  return 0;
+}
+
+/**
+ *@brief 注入触发，PD2下降沿
+ */
+static avr_cycle_count_t bench_trig_fire(avr_t *avr,avr_cycle_count_t when,void *param)
+{
+  bench_shots[bench_cur].trig = avr->cycle;
+  bench_shots[bench_cur].phase = (uint32_t)((avr->cycle - bench_t2) % BENCH_T2_PERIOD);
+  avr_raise_irq(bench_trig_irq,0);
+  avr_cycle_timer_register(avr,BENCH_TRIG_LOW,bench_trig_release,NULL);
+  return 0;
+}
+
+/**
+ *@brief 开放触发后安排下一次触发
+ *
+ *触发时刻取开放触发BENCH_SETTLE之后、以最近定时器2中断为基准的相位点，相位按触发序号在一个
+ *刷新周期内均匀扫描；步长为奇数，同时扫过定时器0/1的8分频预分频器相位
+ */
+static void bench_schedule(void)
+{
+  avr_cycle_count_t at;
+  uint32_t phase;
+  phase = (uint32_t)(((uint64_t)bench_cur * BENCH_T2_PERIOD) / bench_nshots) | 1U;
+  at = bench_t2 + phase;
+  while(at < (bench_avr->cycle + BENCH_SETTLE))
+  {
+    at += BENCH_T2_PERIOD;
+  }
+  bench_waiting = 1;
+  avr_cycle_timer_register(bench_avr,at - bench_avr->cycle,bench_trig_fire,NULL);
+}
+
+/**
+ *@brief 串口输出，“Start generate”之后一行为“d.dddd,w.wwww”（单位s），记录预定参数并安排触发
+ */
+static void bench_uart(avr_irq_t *irq,uint32_t value,void *param)
+{
+  unsigned di,df,wi,wf;
+  char ch = (char)value;
+  if(('\n' == ch) || ('\r' == ch))
+  {
+    if(0 == bench_linelen)
+    {
+      return;
+    }
+    bench_line[bench_linelen] = '\0';
+    bench_linelen = 0;
+    if((0 != bench_armed) && (0 == bench_waiting) && (bench_cur < bench_nshots)
+       && (4 == sscanf(bench_line,"%u.%u,%u.%u",&di,&df,&wi,&wf)))
+    {
+      bench_shots[bench_cur].dly_exp = di * 10000U + df;
+      bench_shots[bench_cur].wtd_exp = wi * 10000U + wf;
+      bench_schedule();
+    }
+    bench_armed = (0 == strcmp(bench_line,"Start generate"));
+  }
+  else if(bench_linelen < (sizeof(bench_line) - 1U))
+  {
+    bench_line[bench_linelen++] = ch;
+  }
+}
+
+/**
+ *@brief 脉冲输出PB1边沿
+ */
+static void bench_pulse(avr_irq_t *irq,uint32_t value,void *param)
+{
+  if(0 != bench_waiting)
+  {
+    if(0 != value)
+    {
+      bench_shots[bench_cur].rise = bench_avr->cycle;
+    }
+    else if(0 != bench_shots[bench_cur].rise)
+    {
+      bench_shots[bench_cur].fall = bench_avr->cycle;
+      bench_waiting = 0;
+      bench_cur++;
+      bench_shot_t0 = bench_avr->cycle;
+    }
+  }
+}
+
+/**
+ *@brief 记录一次中断服务程序的周期数
+ */
+static void bench_isr_add(uint32_t vect,uint32_t cycles)
+{
+  sbisr_t *p = &bench_isr[vect];
+  if((0 == p->count) || (cycles < p->min))
+  {
+    p->min = cycles;
+  }
+  if(cycles > p->max)
+  {
+    p->max = cycles;
+  }
+  p->sum += cycles;
+  p->count++;
+}
+
+/**
+ *@brief 输出超时的触发停在哪一步
+ *
+ *arm未开放触发（串口没有“Start generate”及参数行），delay已注入触发但没有延时边沿，
+ *width有延时边沿但没有脉宽边沿
+ */
+static void bench_timeout(void)
+{
+  const char *stage;
+  if(0 == bench_waiting)
+  {
+    stage = "arm";
+  }
+  else if(0 == bench_shots[bench_cur].rise)
+  {
+    stage = "delay";
+  }
+  else
+  {
+    stage = "width";
+  }
+  printf("{\"type\":\"timeout\",\"n\":%u,\"stage\":\"%s\",\"cycle\":%llu,\"budget\":%llu}\n",
+         bench_cur,stage,(unsigned long long)bench_avr->cycle,(unsigned long long)BENCH_SHOT_CYCLES);
+}
+
+/**
+ *@brief 输出结果
+ */
+static void bench_report(void)
+{
+  uint32_t i;
+  int64_t err,emin = 0,emax = 0;
+  double esum = 0.0,esq = 0.0;
+  int64_t dexp,dmeas,wexp,wmeas;
+  for(i = 0;i < bench_cur;i++)
+  {
+    dexp = (int64_t)bench_shots[i].dly_exp * BENCH_TICK;
+    wexp = (int64_t)bench_shots[i].wtd_exp * BENCH_TICK;
+    dmeas = (int64_t)(bench_shots[i].rise - bench_shots[i].trig);
+    wmeas = (int64_t)(bench_shots[i].fall - bench_shots[i].rise);
+    err = dmeas - dexp;
+    printf("{\"type\":\"shot\",\"n\":%u,\"phase\":%u,\"delay_set\":%u,\"width_set\":%u,"
+           "\"delay_cycles\":%lld,\"width_cycles\":%lld,\"delay_err\":%lld,\"width_err\":%lld}\n",
+           i,bench_shots[i].phase,bench_shots[i].dly_exp,bench_shots[i].wtd_exp,
+           (long long)dmeas,(long long)wmeas,(long long)err,(long long)(wmeas - wexp));
+    if((0 == i) || (err < emin))
+    {
+      emin = err;
+    }
+    if((0 == i) || (err > emax))
+    {
+      emax = err;
+    }
+    esum += (double)err;
+    esq += (double)err * (double)err;
+  }
+  if(0 != bench_cur)
+  {
+    esum /= bench_cur;
+    printf("{\"type\":\"latency\",\"shots\":%u,\"min\":%lld,\"max\":%lld,\"mean\":%.1f,"
+           "\"jitter_pp\":%lld,\"stddev\":%.1f}\n",
+           bench_cur,(long long)emin,(long long)emax,esum,(long long)(emax - emin),
+           (esq / bench_cur > esum * esum) ? __builtin_sqrt(esq / bench_cur - esum * esum) : 0.0);
+  }
+  for(i = 1;i < BENCH_NVECT;i++)
+  {
+    if(0 != bench_isr[i].count)
+    {
+      printf("{\"type\":\"isr\",\"vector\":\"%s\",\"count\":%u,\"min\":%u,\"max\":%u,\"mean\":%.1f}\n",
+             bench_vname[i],bench_isr[i].count,bench_isr[i].min,bench_isr[i].max,
+             (double)bench_isr[i].sum / bench_isr[i].count);
+    }
+  }
+}
+
+int main(int argc,char *argv[])
+{
+  elf_firmware_t fw;
+  uint32_t flags = 0;
+  uint32_t vect = 0;
+  int in_isr = 0;
+  avr_cycle_count_t entry = 0;
+  uint16_t op;
+  int state;
+
+  if(argc < 2)
+  {
+    fprintf(stderr,"usage: %s pulse.elf [shots]\n",argv[0]);
+    return 2;
+  }
+  bench_nshots = (argc > 2) ? (uint32_t)strtoul(argv[2],NULL,0) : BENCH_SHOTS;
+  if(0 == bench_nshots)
+  {
+    bench_nshots = BENCH_SHOTS;
+  }
+  bench_shots = calloc(bench_nshots,sizeof(sbshot_t));
+
+  memset(&fw,0,sizeof(fw));
+  if(0 != elf_read_firmware(argv[1],&fw))
+  {
+    fprintf(stderr,"cannot read %s\n",argv[1]);
+    return 1;
+  }
+  bench_avr = avr_make_mcu_by_name("atmega328p");
+  if(NULL == bench_avr)
+  {
+    fprintf(stderr,"simavr has no atmega328p core\n");
+    return 1;
+  }
+  avr_init(bench_avr);
+  avr_load_firmware(bench_avr,&fw);
+  bench_avr->frequency = BENCH_FCPU;
+
+  /*串口输出不回显到终端，只用于识别开放触发*/
+  avr_ioctl(bench_avr,AVR_IOCTL_UART_GET_FLAGS('0'),&flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(bench_avr,AVR_IOCTL_UART_SET_FLAGS('0'),&flags);
+  avr_irq_register_notify(avr_io_getirq(bench_avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_OUTPUT),
+                          bench_uart,NULL);
+  avr_irq_register_notify(avr_io_getirq(bench_avr,AVR_IOCTL_IOPORT_GETIRQ('B'),1),
+                          bench_pulse,NULL);
+  bench_trig_irq = avr_io_getirq(bench_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),2);
+  avr_raise_irq(bench_trig_irq,1);
+
+  /*时基：OC0A（PD6）接T1（PD5），定时器1由此计数*/
+  avr_connect_irq(avr_io_getirq(bench_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),6),
+                  avr_io_getirq(bench_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),5));
+
+  /*逐条指令运行：PC到达中断向量时记为进入，执行reti后记为退出*/
+  do
+  {
+    if(0 == in_isr)
+    {
+      if((bench_avr->pc > 0) && (bench_avr->pc < (BENCH_NVECT * 4U)) && (0 == (bench_avr->pc & 3U)))
+      {
+        vect = bench_avr->pc / 4U;
+        entry = bench_avr->cycle;
+        in_isr = 1;
+        if(7U == vect)
+        {
+          bench_t2 = bench_avr->cycle;
+        }
+      }
+    }
+    op = (uint16_t)(bench_avr->flash[bench_avr->pc] | (bench_avr->flash[bench_avr->pc + 1U] << 8));
+    state = avr_run(bench_avr);
+    if((0 != in_isr) && (BENCH_RETI == op))
+    {
+      bench_isr_add(vect,(uint32_t)(bench_avr->cycle - entry));
+      in_isr = 0;
+    }
+  }
+  while((state != cpu_Done) && (state != cpu_Crashed) && (bench_cur < bench_nshots)
+        && ((bench_avr->cycle - bench_shot_t0) < BENCH_SHOT_CYCLES));
+
+  bench_report();
+  if(bench_cur < bench_nshots)
+  {
+    bench_timeout();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,858 @@
+/**
+ * @brief 单脉冲发生器主机客户端库
+ * @file host/client.cpp
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 串口设置为原始方式，接收按 msg.def 解析：代码字节及二进制参数直接解码；文本方式在接收的字节中
+ * 查找消息文本（回车忽略，输入回显的数字作为文本行返回），带参数的消息再解析其后的参数\n
+ * 函数列表：
+ *@sa pulse_client::next() 接收下一条消息
+ *@sa pulse_client::wait_for() 等待指定消息
+ *@sa pulse_client::status() 查询工作模式和状态
+ *@sa pulse_client::set_manual() 手动模式设置时间参数并开放触发
+ *@sa pulse_client::upload() 上传脉冲程序
+ *@sa pulse_client::read_log() 读取运行记录
+ *@sa pulse_client::overrun() 读取溢出触发计数
+ *@sa pulse_client::echo() 读取响应测量统计
+ *@sa pulse_client::target() 选择多机总线上的目标地址
+ *@sa pulse_client::broadcast() 向多机总线上的全部发生器发送
+ *@sa pulse_client::set_address() 设置发生器的串口地址
+ *@sa pulse_client::set_sync() 设置同步主从角色
+ *@sa pulse_client::scan() 查找多机总线上的发生器
+ */
+#include "client.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MSG(id,arg,text) text,
+static const char *const client_text[MSG_NUM] =
+{
+#include "msg.def"
+};
+#undef MSG
+
+#define MSG(id,arg,text) arg,
+static const uint8_t client_arg[MSG_NUM] =
+{
+#include "msg.def"
+};
+#undef MSG
+
+/**
+ *@brief 单调时钟，ms
+ */
+static long client_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (long)ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+ *@brief 波特率转换为termios常数
+ */
+static speed_t client_speed(unsigned baud)
+{
+  switch(baud)
+  {
+    case 9600U:
+      return B9600;
+    case 19200U:
+      return B19200;
+    case 38400U:
+      return B38400;
+    case 57600U:
+      return B57600;
+    case 115200U:
+      return B115200;
+    default:
+      throw pulse_error("unsupported baud rate");
+  }
+}
+
+/**
+ *@brief 打开串口或伪终端，设置为原始方式
+ *@param[in] path 设备路径，如/dev/ttyUSB0或仿真器的/dev/pts/N
+ *@param[in] baud 波特率，伪终端忽略
+ */
+pulse_client::pulse_client(const std::string &path,unsigned baud) : addr_(0)
+{
+  struct termios tio;
+  fd_ = open(path.c_str(),O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if(fd_ < 0)
+  {
+    throw pulse_error(path + ": " + strerror(errno));
+  }
+  if(0 == tcgetattr(fd_,&tio))
+  {
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio,client_speed(baud));
+    cfsetospeed(&tio,client_speed(baud));
+    tcsetattr(fd_,TCSANOW,&tio);
+    tcflush(fd_,TCIFLUSH);
+  }
+}
+
+pulse_client::~pulse_client()
+{
+  close(fd_);
+}
+
+/**
+ *@brief 发送字符串
+ */
+void pulse_client::send(const std::string &str)
+{
+  send(reinterpret_cast<const uint8_t *>(str.data()),str.size());
+}
+
+/**
+ *@brief 发送数据，已选择目标地址时加地址选择字节
+ */
+void pulse_client::send(const uint8_t *data,size_t n)
+{
+  if(0 == addr_)
+  {
+    write_raw(data,n);
+  }
+  else
+  {
+    send_to(addr_,data,n);
+  }
+}
+
+/**
+ *@brief 按多机方式发送：地址选择字节、地址，数据中的选择字节和前缀字节加前缀
+ *@param[in] addr 地址，0为广播
+ */
+void pulse_client::send_to(unsigned addr,const uint8_t *data,size_t n)
+{
+  std::vector<uint8_t> out;
+  out.reserve(2U * n + 2U);
+  out.push_back(PULSE_ADDR_MARK);
+  out.push_back((uint8_t)addr);
+  for(size_t i = 0;i < n;i++)
+  {
+    if((PULSE_ADDR_MARK == data[i]) || (PULSE_ADDR_ESC == data[i]))
+    {
+      out.push_back(PULSE_ADDR_ESC);
+    }
+    out.push_back(data[i]);
+  }
+  write_raw(&out[0],out.size());
+}
+
+/**
+ *@brief 原样发送数据
+ */
+void pulse_client::write_raw(const uint8_t *data,size_t n)
+{
+  ssize_t w;
+  while(n > 0)
+  {
+    w = write(fd_,data,n);
+    if(w < 0)
+    {
+      if(EINTR == errno)
+      {
+        continue;
+      }
+      throw pulse_error(std::string("write: ") + strerror(errno));
+    }
+    data += w;
+    n -= (size_t)w;
+  }
+}
+
+/**
+ *@brief 接收已到达的字节
+ *@param[in] timeout_ms 没有数据时的等待时间
+ *@return 接收到数据返回true
+ */
+bool pulse_client::fill(int timeout_ms)
+{
+  struct pollfd pfd;
+  char tmp[256];
+  ssize_t n;
+  pfd.fd = fd_;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if(poll(&pfd,1,(timeout_ms < 0) ? 0 : timeout_ms) <= 0)
+  {
+    return false;
+  }
+  n = read(fd_,tmp,sizeof(tmp));
+  if(n <= 0)
+  {
+    return false;
+  }
+  buf_.append(tmp,(size_t)n);
+  return true;
+}
+
+/**
+ *@brief 比较缓冲区开头与消息文本，忽略缓冲区中的回车
+ *@param[in] text 消息文本
+ *@param[out] len 完全相同时缓冲区中对应的字节数
+ *@return 1完全相同；0不同；-1缓冲区是文本的前一部分
+ */
+int pulse_client::match(const char *text,size_t &len) const
+{
+  size_t i = 0;
+  while('\0' != *text)
+  {
+    while((i < buf_.size()) && ('\r' == buf_[i]))
+    {
+      i++;
+    }
+    if(i >= buf_.size())
+    {
+      return -1;
+    }
+    if(buf_[i] != *text)
+    {
+      return 0;
+    }
+    i++;
+    text++;
+  }
+  len = i;
+  return 1;
+}
+
+/**
+ *@brief 从缓冲区解析一条消息
+ *@param[out] msg 消息
+ *@return 解析出一条消息返回true；数据不完整返回false
+ */
+bool pulse_client::parse(pulse_msg &msg)
+{
+  uint8_t c;
+  uint8_t id;
+  size_t need;
+  size_t width;
+  size_t len = 0;
+  size_t n = 0;
+  size_t nl;
+  size_t pos;
+  int best = -1;
+  int m;
+  std::string line;
+
+  while(!buf_.empty())
+  {
+    c = (uint8_t)buf_[0];
+    id = (uint8_t)(c & ~MSG_TOKEN);
+    msg.a = 0;
+    msg.b = 0;
+    msg.text.clear();
+    if((0 != (c & MSG_TOKEN)) && (id < MSG_NUM))
+    {
+      /*代码方式*/
+      width = (MSG_ARG_HEX1 == client_arg[id]) ? 1U
+            : (MSG_ARG_NUM2 == client_arg[id]) ? 2U
+            : (MSG_ARG_NONE == client_arg[id]) ? 0 : 3U;
+      need = ((MSG_ARG_TIME2 == client_arg[id]) || (MSG_ARG_NUM2 == client_arg[id]) ||
+              (MSG_ARG_DEC2 == client_arg[id])) ? 2U * width : width;
+      if(buf_.size() < (1U + need))
+      {
+        return false;
+      }
+      msg.id = id;
+      for(size_t i = 0;i < need;i++)
+      {
+        if(i < width)
+        {
+          msg.a |= (uint32_t)(uint8_t)buf_[1U + i] << (8U * i);
+        }
+        else
+        {
+          msg.b |= (uint32_t)(uint8_t)buf_[1U + i] << (8U * (i - width));
+        }
+      }
+      buf_.erase(0,1U + need);
+      return true;
+    }
+    if(('\r' == c) || (0 != (c & 0x80U)))
+    {
+      buf_.erase(0,1);
+      continue;
+    }
+
+    /*文本方式：在下一个换行之前查找消息文本的开头*/
+    nl = buf_.find('\n');
+    if(std::string::npos == nl)
+    {
+      nl = buf_.size();
+    }
+    for(pos = 0;(pos <= nl) && (best < 0);pos++)
+    {
+      if(pos >= buf_.size())
+      {
+        return false;/*还没有换行，等待后续字节*/
+      }
+      std::string rest = buf_.substr(pos);
+      std::swap(rest,buf_);
+      /*取最长的完整匹配，"Echo "是"Echo min,max us "等的前缀*/
+      for(id = 0;(id < MSG_NUM) && (MSG_NUM != best);id++)
+      {
+        m = match(client_text[id],n);
+        if(-1 == m)
+        {
+          best = MSG_NUM;
+        }
+        else if((1 == m) && ((best < 0) || (n > len)))
+        {
+          best = id;
+          len = n;
+        }
+        else
+        {
+          ;/*no deal with*/
+        }
+      }
+      std::swap(rest,buf_);
+      if(best >= 0)
+      {
+        break;
+      }
+    }
+    if(best < 0)
+    {
+      if(nl >= buf_.size())
+      {
+        return false;
+      }
+      pos = nl + 1U;
+    }
+    if(pos > 0)
+    {
+      /*消息文本之前的字节（输入回显等）作为文本行*/
+      line = buf_.substr(0,pos);
+      buf_.erase(0,pos);
+      while(!line.empty() && (('\n' == line[line.size() - 1U]) || ('\r' == line[line.size() - 1U])))
+      {
+        line.erase(line.size() - 1U);
+      }
+      if(line.empty())
+      {
+        best = -1;
+        continue;
+      }
+      msg.id = PULSE_ID_TEXT;
+      msg.text = line;
+      return true;
+    }
+    if(MSG_NUM == best)
+    {
+      return false;
+    }
+
+    /*消息文本完整，解析参数行*/
+    id = (uint8_t)best;
+    if(MSG_ARG_NONE != client_arg[id])
+    {
+      nl = buf_.find('\n',len);
+      if(std::string::npos == nl)
+      {
+        return false;
+      }
+      line = buf_.substr(len,nl - len);
+      len = nl + 1U;
+      if(MSG_ARG_HEX1 == client_arg[id])
+      {
+        msg.a = (uint32_t)strtoul(line.c_str(),NULL,16);
+      }
+      else if((MSG_ARG_NUM2 == client_arg[id]) || (MSG_ARG_DEC2 == client_arg[id]))
+      {
+        unsigned n0 = 0;
+        unsigned n1 = 0;
+        sscanf(line.c_str(),"%u,%u",&n0,&n1);
+        msg.a = n0;
+        msg.b = n1;
+      }
+      else
+      {
+        unsigned d0 = 0;
+        unsigned d1 = 0;
+        unsigned w0 = 0;
+        unsigned w1 = 0;
+        sscanf(line.c_str(),"%u.%u,%u.%u",&d0,&d1,&w0,&w1);
+        msg.a = d0 * 10000U + d1;
+        msg.b = w0 * 10000U + w1;
+      }
+    }
+    msg.id = id;
+    buf_.erase(0,len);
+    return true;
+  }
+  return false;
+}
+
+/**
+ *@brief 接收下一条消息
+ *@param[out] msg 消息
+ *@param[in] timeout_ms 等待时间
+ *@return 超时返回false
+ */
+bool pulse_client::next(pulse_msg &msg,int timeout_ms)
+{
+  long end = client_ms() + timeout_ms;
+  while(!parse(msg))
+  {
+    if(!fill((int)(end - client_ms())))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *@brief 等待指定消息，之前的消息丢弃
+ *@param[in] id 消息编号
+ *@param[out] msg 消息，可为NULL
+ *@param[in] timeout_ms 等待时间
+ *@return 超时返回false
+ */
+bool pulse_client::wait_for(int id,pulse_msg *msg,int timeout_ms)
+{
+  pulse_msg tmp;
+  long end = client_ms() + timeout_ms;
+  while(next(tmp,(int)(end - client_ms())))
+  {
+    if(tmp.id == id)
+    {
+      if(NULL != msg)
+      {
+        *msg = tmp;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *@brief 丢弃接收的数据，直到quiet_ms内没有数据
+ */
+void pulse_client::drain(int quiet_ms)
+{
+  while(fill(quiet_ms))
+  {
+    ;
+  }
+  buf_.clear();
+}
+
+/**
+ *@brief 查询工作模式和主控制状态
+ *@param[out] mode 工作模式， @ref pulse_mode
+ *@param[out] state 主控制状态， @ref pulse_state
+ *@return 超时返回false。手动模式输入时间参数期间'?'结束一个数的输入，不回答
+ */
+bool pulse_client::status(unsigned &mode,unsigned &state,int timeout_ms)
+{
+  pulse_msg msg;
+  send("?");
+  if(!wait_for(MSG_STATUS,&msg,timeout_ms))
+  {
+    return false;
+  }
+  mode = (msg.a >> 4) & 0x0fU;
+  state = msg.a & 0x0fU;
+  return true;
+}
+
+/**
+ *@brief 切换工作模式
+ */
+bool pulse_client::switch_mode(unsigned mode,int timeout_ms)
+{
+  static const char key[3] = {'a','m','g'};
+  static const int ack[3] = {MSG_AUTO,MSG_MAN,MSG_PROG};
+  send(std::string(1,key[mode]));
+  return wait_for(ack[mode],NULL,timeout_ms);
+}
+
+/**
+ *@brief 返回自动模式
+ */
+bool pulse_client::set_auto(int timeout_ms)
+{
+  unsigned mode;
+  unsigned state;
+  if(!status(mode,state))
+  {
+    return false;
+  }
+  return (PULSE_AUTO == mode) || switch_mode(PULSE_AUTO,timeout_ms);
+}
+
+/**
+ *@brief 手动模式设置时间参数并开放触发
+ *@param[in] delay 延时数，单位0.1ms
+ *@param[in] width 脉宽数，单位0.1ms
+ *@param[out] got_delay 发生器采用的延时数，可为NULL
+ *@param[out] got_width 发生器采用的脉宽数，可为NULL
+ *@param[in] timeout_ms 每一步的等待时间
+ *@return 超时返回false
+ *
+ *已在手动模式时先返回自动模式再进入，使发生器重新提示输入
+ */
+bool pulse_client::set_manual(uint32_t delay,uint32_t width,uint32_t *got_delay,uint32_t *got_width,
+                              int timeout_ms)
+{
+  pulse_msg msg;
+  unsigned mode = 0;
+  unsigned state = 0;
+  bool ok = false;
+  char num[16];
+  int i;
+
+  /*正在输入时间参数时回答不了状态查询，以回车结束输入*/
+  for(i = 0;(i < 3) && !ok;i++)
+  {
+    ok = status(mode,state);
+    if(!ok)
+    {
+      send("\r");
+    }
+  }
+  if(!ok)
+  {
+    return false;
+  }
+  if((PULSE_MAN == mode) && !switch_mode(PULSE_AUTO,timeout_ms))
+  {
+    return false;
+  }
+  if(!switch_mode(PULSE_MAN,timeout_ms) || !wait_for(MSG_DELAY,NULL,timeout_ms))
+  {
+    return false;
+  }
+  snprintf(num,sizeof(num),"%u\r",(unsigned)delay);
+  send(num);
+  if(!wait_for(MSG_WIDTH,NULL,timeout_ms))
+  {
+    return false;
+  }
+  snprintf(num,sizeof(num),"%u\r",(unsigned)width);
+  send(num);
+  if(!wait_for(MSG_START,&msg,timeout_ms))
+  {
+    return false;
+  }
+  if(NULL != got_delay)
+  {
+    *got_delay = msg.a;
+  }
+  if(NULL != got_width)
+  {
+    *got_width = msg.b;
+  }
+  return true;
+}
+
+/**
+ *@brief 计算脉冲程序的CRC-8校验，与固件的_crc8_ccitt_update()相同
+ *@param[in] code 程序
+ *@return 长度及程序各字节的校验
+ */
+uint8_t pulse_client::crc8(const std::vector<uint8_t> &code)
+{
+  uint8_t crc = 0;
+  uint8_t data;
+  size_t i;
+  int b;
+  for(i = 0;i <= code.size();i++)
+  {
+    data = (0 == i) ? (uint8_t)code.size() : code[i - 1U];
+    crc ^= data;
+    for(b = 0;b < 8;b++)
+    {
+      crc = (0 != (crc & 0x80U)) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ *@brief 上传脉冲程序，发生器校验正确后写入EEPROM
+ *@param[in] code 程序，不超过64字节
+ *@param[in] timeout_ms 等待时间
+ *@return 超时或校验错误返回false
+ */
+bool pulse_client::upload(const std::vector<uint8_t> &code,int timeout_ms)
+{
+  unsigned mode;
+  unsigned state;
+  pulse_msg msg;
+  std::vector<uint8_t> frame;
+  if(!status(mode,state))
+  {
+    return false;
+  }
+  if((PULSE_PROG != mode) && !switch_mode(PULSE_PROG,timeout_ms))
+  {
+    return false;
+  }
+  send("u");
+  if(!wait_for(MSG_LOAD,NULL,timeout_ms))
+  {
+    return false;
+  }
+  frame.push_back((uint8_t)code.size());
+  frame.insert(frame.end(),code.begin(),code.end());
+  frame.push_back(crc8(code));
+  send(frame.data(),frame.size());
+  while(next(msg,timeout_ms))
+  {
+    if((MSG_LOADOK == msg.id) || (MSG_LOADERR == msg.id))
+    {
+      return MSG_LOADOK == msg.id;
+    }
+  }
+  return false;
+}
+
+/**
+ *@brief 进入程序模式并从头执行程序
+ */
+bool pulse_client::run_program(int timeout_ms)
+{
+  unsigned mode;
+  unsigned state;
+  if(!status(mode,state))
+  {
+    return false;
+  }
+  if(PULSE_PROG == mode)
+  {
+    send("g");
+    return true;
+  }
+  return switch_mode(PULSE_PROG,timeout_ms);
+}
+
+/**
+ *@brief 读取复位原因及运行记录
+ *@param[out] lines 复位原因行及各条记录“事件 数据”
+ *@param[in] timeout_ms 记录之间的最长间隔
+ *@return 超时返回false
+ */
+bool pulse_client::read_log(std::vector<std::string> &lines,int timeout_ms)
+{
+  pulse_msg msg;
+  char tmp[16];
+  lines.clear();
+  send("l");
+  if(!wait_for(MSG_RESET,&msg,timeout_ms))
+  {
+    return false;
+  }
+  snprintf(tmp,sizeof(tmp),"Reset %02x",(unsigned)msg.a);
+  lines.push_back(tmp);
+  while(next(msg,timeout_ms))
+  {
+    if(PULSE_ID_TEXT == msg.id)
+    {
+      lines.push_back(msg.text);
+    }
+  }
+  return true;
+}
+
+/**
+ *@brief 读取溢出触发计数
+ *@param[out] overrun 未开放触发时到达的触发次数
+ *@param[out] dropped 丢失的触发次数
+ *@param[out] queued 排队等待的触发数
+ *@param[out] qwait_ms 排队触发的最长等待时间，ms
+ *@param[out] ignored 抑制期内忽略的触发次数，不需要时为0
+ *@param[in] timeout_ms 消息之间的最长间隔
+ *@return 超时返回false
+ */
+bool pulse_client::overrun(uint32_t &overrun,uint32_t &dropped,uint32_t &queued,uint32_t &qwait_ms,
+                           uint32_t *ignored,int timeout_ms)
+{
+  pulse_msg msg;
+  send("o");
+  if(!wait_for(MSG_OVERRUN,&msg,timeout_ms))
+  {
+    return false;
+  }
+  overrun = msg.a;
+  dropped = msg.b;
+  if(!wait_for(MSG_QUEUE,&msg,timeout_ms))
+  {
+    return false;
+  }
+  queued = msg.a;
+  qwait_ms = msg.b;
+  if(!wait_for(MSG_IGNORED,&msg,timeout_ms))
+  {
+    return false;
+  }
+  if(0 != ignored)
+  {
+    *ignored = msg.a;
+  }
+  return true;
+}
+
+/**
+ *@brief 读取响应测量统计
+ *@param[out] st 统计，直方图为 @ref ECHO_BINS 格
+ *@param[in] timeout_ms 消息之间的最长间隔
+ *@return 超时返回false
+ */
+bool pulse_client::echo(pulse_echo &st,int timeout_ms)
+{
+  pulse_msg msg;
+  st = pulse_echo();
+  st.bins.assign(16U,0);
+  send("h");
+  if(!wait_for(MSG_ECHO,&msg,timeout_ms))
+  {
+    return false;
+  }
+  st.count = msg.a;
+  st.timeouts = msg.b;
+  while(next(msg,timeout_ms))
+  {
+    if(MSG_ECHOMM == msg.id)
+    {
+      st.min = msg.a;
+      st.max = msg.b;
+    }
+    else if(MSG_ECHOAVG == msg.id)
+    {
+      st.mean = msg.a;
+      st.last = msg.b;
+    }
+    else if(MSG_ECHOWIN == msg.id)
+    {
+      st.window = msg.a;
+      st.bin = msg.b;
+    }
+    else if((MSG_ECHOBIN == msg.id) && (msg.a < st.bins.size()))
+    {
+      st.bins[msg.a] = msg.b;
+    }
+    else
+    {
+      break;
+    }
+  }
+  return true;
+}
+
+/**
+ *@brief 选择多机总线上的目标地址
+ *@param[in] addr 1～ @ref PULSE_ADDR_MAX ；0为单机方式，不加地址选择字节
+ *
+ *此后的每次发送都先选择该地址，发生器复位后不需要重新选择
+ */
+void pulse_client::target(unsigned addr)
+{
+  addr_ = (addr > PULSE_ADDR_MAX) ? 0 : addr;
+}
+
+/**
+ *@brief 向多机总线上的全部发生器发送，发生器都不应答
+ */
+void pulse_client::broadcast(const std::string &str)
+{
+  send_to(0,reinterpret_cast<const uint8_t *>(str.data()),str.size());
+}
+
+/**
+ *@brief 设置发生器的串口地址
+ *@param[in] addr 新地址，0改为单机方式
+ *@param[in] timeout_ms 每一步的等待时间
+ *@return 超时或地址未被接受返回false
+ *
+ *发给当前目标（单机方式时为唯一连接的发生器），成功后以新地址为目标
+ */
+bool pulse_client::set_address(unsigned addr,int timeout_ms)
+{
+  pulse_msg msg;
+  char num[16];
+  send("n");
+  if(!wait_for(MSG_ADDR,NULL,timeout_ms))
+  {
+    return false;
+  }
+  snprintf(num,sizeof(num),"%u\r",addr);
+  send(num);
+  if(!wait_for(MSG_UNIT,&msg,timeout_ms) || (msg.a != addr))
+  {
+    return false;
+  }
+  target(addr);
+  return true;
+}
+
+/**
+ *@brief 设置同步主从角色
+ *@param[in] slave true从机，false主机
+ *@param[in] timeout_ms 每一步的等待时间
+ *@return 超时返回false
+ *
+ *发生器每收到一次's'切换一次角色，角色不符时再发一次
+ */
+bool pulse_client::set_sync(bool slave,int timeout_ms)
+{
+  pulse_msg msg;
+  int i;
+  for(i = 0;i < 2;i++)
+  {
+    send("s");
+    if(!wait_for(MSG_UNIT,&msg,timeout_ms))
+    {
+      return false;
+    }
+    if((0 != msg.b) == slave)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *@brief 查找多机总线上的发生器
+ *@param[in] last 查找的最大地址
+ *@param[in] timeout_ms 每个地址等待应答的时间
+ *@return 应答状态查询的地址
+ */
+std::vector<unsigned> pulse_client::scan(unsigned last,int timeout_ms)
+{
+  std::vector<unsigned> found;
+  unsigned saved = addr_;
+  unsigned mode;
+  unsigned state;
+  for(unsigned a = 1U;(a <= last) && (a <= PULSE_ADDR_MAX);a++)
+  {
+    target(a);
+    if(status(mode,state,timeout_ms))
+    {
+      found.push_back(a);
+    }
+  }
+  target(saved);
+  return found;
+}
@@ -0,0 +1,140 @@
+/**
+ * @brief 单脉冲发生器主机客户端库头文件
+ * @file host/client.hpp
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * Linux下经串口或连接仿真器的伪终端控制发生器。接收的输出按 msg.def 解析为消息，文本方式和
+ * 代码方式都能识别，不能识别的行作为文本消息返回。多台共用一条串口总线时以 target() 选择地址，
+ * 每次发送前加地址选择字节\n
+ * 类列表：
+ *@sa pulse_msg 接收的消息
+ *@sa pulse_echo 响应测量统计
+ *@sa pulse_client 客户端
+ */
+#ifndef PULSE_CLIENT_HPP
+#define PULSE_CLIENT_HPP
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+extern "C"
+{
+#include "msg.h"
+}
+
+#define PULSE_ID_TEXT   (-1) /**<不能识别的文本行*/
+#define PULSE_ADDR_MARK 0xffU /**<地址选择字节，与uart.h一致*/
+#define PULSE_ADDR_ESC  0xfeU /**<数据前缀字节，与uart.h一致*/
+#define PULSE_ADDR_MAX  127U  /**<最大地址，与uart.h一致*/
+
+/**
+ *@brief 主控制状态，与main.c一致
+ */
+enum pulse_state
+{
+  PULSE_WAIT = 0,  /**<等待触发端口空闲*/
+  PULSE_DELAY = 1, /**<手动模式，等待延时数*/
+  PULSE_WIDTH = 2, /**<手动模式，等待脉宽数*/
+  PULSE_ARMED = 3, /**<已开放触发*/
+  PULSE_LOAD = 4,  /**<程序模式，接收程序*/
+  PULSE_ADDR = 5   /**<接收串口地址*/
+};
+
+/**
+ *@brief 工作模式，与main.c一致
+ */
+enum pulse_mode
+{
+  PULSE_AUTO = 0,
+  PULSE_MAN = 1,
+  PULSE_PROG = 2
+};
+
+/**
+ *@brief 接收的消息
+ */
+struct pulse_msg
+{
+  int id;           /**<消息编号， @ref PULSE_ID_TEXT 为不能识别的文本行*/
+  uint32_t a;       /**<第一个参数*/
+  uint32_t b;       /**<第二个参数*/
+  std::string text; /**<文本行，只对不能识别的文本行有效*/
+};
+
+/**
+ *@brief 响应测量统计，时间单位us
+ */
+struct pulse_echo
+{
+  uint32_t count;    /**<测得响应次数*/
+  uint32_t timeouts; /**<超时次数*/
+  uint32_t min;      /**<最小值*/
+  uint32_t max;      /**<最大值*/
+  uint32_t mean;     /**<平均值*/
+  uint32_t last;     /**<最近一次*/
+  uint32_t window;   /**<测量窗口，0不测量*/
+  uint32_t bin;      /**<直方图每格宽度*/
+  std::vector<uint32_t> bins; /**<直方图，以脉冲后沿为起点*/
+};
+
+/**
+ *@brief 串口错误
+ */
+struct pulse_error : std::runtime_error
+{
+  explicit pulse_error(const std::string &what) : std::runtime_error(what) {}
+};
+
+/**
+ *@brief 客户端
+ *
+ *除构造函数外，等待类函数超时返回false，不抛出异常
+ */
+class pulse_client
+{
+public:
+  pulse_client(const std::string &path,unsigned baud = 115200U);
+  ~pulse_client();
+
+  void send(const std::string &str);
+  void send(const uint8_t *data,size_t n);
+  bool next(pulse_msg &msg,int timeout_ms);
+  bool wait_for(int id,pulse_msg *msg,int timeout_ms);
+  void drain(int quiet_ms);
+  void target(unsigned addr);
+  void broadcast(const std::string &str);
+
+  bool status(unsigned &mode,unsigned &state,int timeout_ms = 500);
+  bool set_auto(int timeout_ms = 2000);
+  bool set_manual(uint32_t delay,uint32_t width,uint32_t *got_delay = 0,uint32_t *got_width = 0,
+                  int timeout_ms = 2000);
+  bool upload(const std::vector<uint8_t> &code,int timeout_ms = 3000);
+  bool run_program(int timeout_ms = 2000);
+  bool read_log(std::vector<std::string> &lines,int timeout_ms = 500);
+  bool overrun(uint32_t &overrun,uint32_t &dropped,uint32_t &queued,uint32_t &qwait_ms,uint32_t *ignored = 0,
+               int timeout_ms = 500);
+  bool echo(pulse_echo &st,int timeout_ms = 500);
+  bool set_address(unsigned addr,int timeout_ms = 1000);
+  bool set_sync(bool slave,int timeout_ms = 500);
+  std::vector<unsigned> scan(unsigned last = PULSE_ADDR_MAX,int timeout_ms = 50);
+
+  static uint8_t crc8(const std::vector<uint8_t> &code);
+
+private:
+  pulse_client(const pulse_client &);
+  pulse_client &operator=(const pulse_client &);
+  bool fill(int timeout_ms);
+  bool parse(pulse_msg &msg);
+  int match(const char *text,size_t &len) const;
+  bool switch_mode(unsigned mode,int timeout_ms);
+  void write_raw(const uint8_t *data,size_t n);
+  void send_to(unsigned addr,const uint8_t *data,size_t n);
+
+  int fd_;
+  unsigned addr_;    /*目标地址，0单机方式*/
+  std::string buf_;  /*已接收未解析的字节*/
+};
+#endif
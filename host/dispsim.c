@@ -0,0 +1,179 @@
+/**
+ * @brief simavr中的MAX7219显示控制器模型
+ * @file host/dispsim.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 在simavr中运行DISPLAY=max7219编译的pulse.elf，接收SPI输出的字节，PB2（LOAD）上升沿按
+ * MAX7219的规则锁存最后16位，维护各寄存器。显示内容或关断状态变化时输出一行
+ * “时间ms 开/关 显示内容”，结束时输出JSON统计行：锁存次数、显示变化次数、每次锁存的位数错误
+ * 次数。译码方式不为0、扫描位数不为4或位数错误时返回1\n
+ * 用法：dispsim pulse.elf 仿真时间ms
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_spi.h>
+
+#define DISPSIM_FCPU  16000000UL /**<CPU时钟*/
+#define DISPSIM_MS    (DISPSIM_FCPU / 1000U) /**<1ms对应的周期数*/
+
+static avr_t *dispsim_avr;
+static uint8_t dispsim_shift[2];    /*最后移入的两个字节，[0]为地址*/
+static uint32_t dispsim_bytes;      /*本次LOAD低电平期间移入的字节数*/
+static uint8_t dispsim_reg[16];     /*MAX7219寄存器*/
+static char dispsim_shown[16];      /*上次输出的显示内容*/
+static uint32_t dispsim_latches;
+static uint32_t dispsim_frames;
+static uint32_t dispsim_errors;
+static uint32_t dispsim_load = 1;
+
+/*七段编码（位0～6为a～g）对应的数字*/
+static const uint8_t dispsim_digit[10] =
+{0x3f,0x06,0x5b,0x4f,0x66,0x6d,0x7d,0x07,0x7f,0x6f};
+
+/**
+ *@brief MAX7219不译码编码转换为显示字符
+ */
+static char dispsim_char(uint8_t code)
+{
+  uint8_t segs = 0;
+  int i;
+  for(i = 0;i < 7;i++)
+  {
+    if(0 != (code & (0x40 >> i)))
+    {
+      segs |= (uint8_t)(1U << i);
+    }
+  }
+  if(0 == segs)
+  {
+    return ' ';
+  }
+  if(0x40 == segs)
+  {
+    return '-';
+  }
+  for(i = 0;i < 10;i++)
+  {
+    if(dispsim_digit[i] == segs)
+    {
+      return (char)('0' + i);
+    }
+  }
+  return '?';
+}
+
+/**
+ *@brief 显示内容有变化时输出一行
+ */
+static void dispsim_show(void)
+{
+  char line[16];
+  int n = 0;
+  int d;
+  for(d = 5;d > 0;d--)
+  {
+    line[n++] = dispsim_char(dispsim_reg[d]);
+    if(0 != (dispsim_reg[d] & 0x80))
+    {
+      line[n++] = '.';
+    }
+  }
+  line[n] = '\0';
+  n = (0 != (dispsim_reg[0x0C] & 1)) ? 1 : 0;
+  if((0 != strcmp(line,dispsim_shown)) || (n != dispsim_shown[15]))
+  {
+    strcpy(dispsim_shown,line);
+    dispsim_shown[15] = (char)n;
+    dispsim_frames++;
+    printf("%8.1f %s [%s]\n",(double)dispsim_avr->cycle / DISPSIM_MS,(0 != n) ? "on " : "off",line);
+  }
+}
+
+/**
+ *@brief SPI输出一个字节
+ */
+static void dispsim_spi(avr_irq_t *irq,uint32_t value,void *param)
+{
+  dispsim_shift[0] = dispsim_shift[1];
+  dispsim_shift[1] = (uint8_t)value;
+  dispsim_bytes++;
+}
+
+/**
+ *@brief LOAD（PB2）电平变化，上升沿锁存
+ */
+static void dispsim_loadpin(avr_irq_t *irq,uint32_t value,void *param)
+{
+  if((0 == dispsim_load) && (0 != value))
+  {
+    dispsim_latches++;
+    if(2U != dispsim_bytes)
+    {
+      dispsim_errors++;
+    }
+    dispsim_reg[dispsim_shift[0] & 0x0f] = dispsim_shift[1];
+    dispsim_show();
+  }
+  if(0 == value)
+  {
+    dispsim_bytes = 0;
+  }
+  dispsim_load = value;
+}
+
+int main(int argc,char *argv[])
+{
+  elf_firmware_t fw;
+  avr_cycle_count_t end;
+  int state = cpu_Running;
+  int ret = 0;
+
+  if(argc < 3)
+  {
+    fprintf(stderr,"usage: %s pulse.elf ms\n",argv[0]);
+    return 2;
+  }
+  memset(&fw,0,sizeof(fw));
+  if(0 != elf_read_firmware(argv[1],&fw))
+  {
+    fprintf(stderr,"cannot read %s\n",argv[1]);
+    return 1;
+  }
+  dispsim_avr = avr_make_mcu_by_name("atmega328p");
+  if(NULL == dispsim_avr)
+  {
+    fprintf(stderr,"simavr has no atmega328p core\n");
+    return 1;
+  }
+  avr_init(dispsim_avr);
+  avr_load_firmware(dispsim_avr,&fw);
+  dispsim_avr->frequency = DISPSIM_FCPU;
+
+  avr_irq_register_notify(avr_io_getirq(dispsim_avr,AVR_IOCTL_SPI_GETIRQ(0),SPI_IRQ_OUTPUT),
+                          dispsim_spi,NULL);
+  avr_irq_register_notify(avr_io_getirq(dispsim_avr,AVR_IOCTL_IOPORT_GETIRQ('B'),2),
+                          dispsim_loadpin,NULL);
+  /*触发端口保持空闲高电平*/
+  avr_raise_irq(avr_io_getirq(dispsim_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),2),1);
+
+  end = (avr_cycle_count_t)strtoul(argv[2],NULL,0) * DISPSIM_MS;
+  while((dispsim_avr->cycle < end) && (state != cpu_Done) && (state != cpu_Crashed))
+  {
+    state = avr_run(dispsim_avr);
+  }
+
+  if((0 != dispsim_reg[0x09]) || (4 != dispsim_reg[0x0B]) || (0 != dispsim_errors))
+  {
+    ret = 1;
+  }
+  printf("{\"latches\":%u,\"frames\":%u,\"errors\":%u,\"decode\":%u,\"scanlimit\":%u}\n",
+         (unsigned)dispsim_latches,(unsigned)dispsim_frames,(unsigned)dispsim_errors,
+         (unsigned)dispsim_reg[0x09],(unsigned)dispsim_reg[0x0B]);
+  return ret;
+}
@@ -0,0 +1,419 @@
+/**
+ * @brief 主机参数解析与限幅的随机测试
+ * @file host/fuzz.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 与主机库（make host）链接，以参考模型对照检查：\n
+ * - pls_set_pulse() 的延时、脉宽限幅和时基选择，两种脉冲产生方式，读回的延时数、脉宽数及
+ *   OCR0A、OCR1A、ICR1\n
+ * - pls_strtou() 的数字字符串转换\n
+ * - uart_getnum()、 uart_readnum() 对数字、退格和结束字符的处理\n
+ * 输入为边界值加随机值，随机数由种子决定，可重复。发现不一致时输出输入和两边的结果，有不一致时
+ * 返回非零。用法：fuzz [次数] [种子]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include "pulse.h"
+#include "uart.h"
+
+#define FUZZ_RUNS    200000UL /**<缺省随机次数*/
+#define FUZZ_REPORT  20U      /**<最多输出的不一致数*/
+#define FUZZ_STRLEN  8U       /**<随机字符串最大长度*/
+
+extern volatile uint8_t sim_sfr[0x100];
+void USART_RX_vect(void);
+
+static uint32_t fuzz_state;/**<随机数状态*/
+static unsigned long fuzz_failed;/**<不一致数*/
+
+/**
+ * @brief 参考模型的时间参数
+ */
+typedef struct fuzz_pulse
+{
+  uint32_t delay;   /**<读回的延时数，单位0.1ms*/
+  uint32_t width;   /**<读回的脉宽数，单位0.1ms*/
+  uint8_t ocr0a;    /**<时基*/
+  uint16_t ocr1a;   /**<延时比较值*/
+  uint16_t icr1;    /**<硬件边沿方式的TOP，中断方式为0*/
+}sfpulse_t;
+
+/**
+ *@brief xorshift32随机数
+ *@return 32位随机数
+ */
+static uint32_t fuzz_rand(void)
+{
+  uint32_t x;
+  x = fuzz_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  fuzz_state = x;
+  return x;
+}
+
+/**
+ *@brief 记录一次不一致，只输出前 @ref FUZZ_REPORT 次
+ *@return 非零须输出详情
+ */
+static int fuzz_fail(void)
+{
+  fuzz_failed++;
+  return (fuzz_failed <= FUZZ_REPORT);
+}
+
+/**
+ *@brief 取值限制在范围内
+ */
+static uint32_t fuzz_clamp(uint32_t v,uint32_t lo,uint32_t hi)
+{
+  return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/**
+ *@brief 两数之差的绝对值
+ */
+static uint32_t fuzz_diff(uint32_t a,uint32_t b)
+{
+  return (a > b) ? (a - b) : (b - a);
+}
+
+/**
+ *@brief 延时、脉宽限幅的参考模型
+ *@param dly 延时数
+ *@param wtd 脉宽数
+ *@param hw 非零硬件边沿方式
+ *@param[out] m 结果
+ *
+ *延时5000～99999，超过65535时时基0.2ms并按偶数取整；脉宽4000～10000，按所选时基取整。硬件
+ *边沿方式的延时加脉宽超过16位时再改用0.2ms时基
+ */
+static void fuzz_model(uint32_t dly,uint32_t wtd,int hw,sfpulse_t *m)
+{
+  uint32_t ocr1a;
+  uint32_t w;
+  uint32_t pre;
+  w = (wtd > 10000UL) ? 10000UL : wtd;
+  if(dly < 65536UL)
+  {
+    ocr1a = fuzz_clamp(dly,5000UL,65535UL);
+    w = fuzz_clamp(w,4000UL,10000UL);
+    pre = 1U;
+  }
+  else
+  {
+    ocr1a = (dly < 100000UL) ? (dly / 2U) : 49999UL;
+    w = fuzz_clamp(w / 2U,2000UL,5000UL);
+    pre = 2U;
+  }
+  m->icr1 = 0;
+  if(0 != hw)
+  {
+    if((ocr1a + w) > 65536UL)
+    {
+      ocr1a /= 2U;
+      w /= 2U;
+      pre = 2U;
+    }
+    m->icr1 = (uint16_t)(ocr1a + w - 1U);
+  }
+  m->ocr1a = (uint16_t)ocr1a;
+  m->ocr0a = (2U == pre) ? 199U : 99U;
+  m->delay = ocr1a * pre;
+  m->width = w * pre;
+}
+
+/**
+ *@brief 检查一组延时、脉宽
+ *@param dly 延时数
+ *@param wtd 脉宽数
+ *@param hw 非零硬件边沿方式
+ *
+ *除与参考模型比较外，独立检查读回值在有效范围内，且与限幅后的输入最多差一个取整单位
+ */
+static void fuzz_pulse_one(uint32_t dly,uint32_t wtd,int hw)
+{
+  sfpulse_t m;
+  uint32_t d;
+  uint32_t w;
+  fuzz_model(dly,wtd,hw,&m);
+  pls_set_pulse(dly,wtd);
+  pls_set_param();
+  d = pls_get_delay();
+  w = pls_get_width();
+  if((d != m.delay) || (w != m.width) || (OCR0A != m.ocr0a) || (OCR1A != m.ocr1a)
+     || ((0 != hw) && (ICR1 != m.icr1))
+     || (d < 5000UL) || (d > 99999UL) || (w < 4000UL) || (w > 10000UL)
+     || (fuzz_diff(fuzz_clamp(dly,5000UL,99999UL),d) > 1U)
+     || (fuzz_diff(fuzz_clamp(wtd,4000UL,10000UL),w) > 1U))
+  {
+    if(0 != fuzz_fail())
+    {
+      printf("pulse %s dly=%lu wtd=%lu: got %lu,%lu OCR0A=%u OCR1A=%u ICR1=%u;"
+             " model %lu,%lu OCR0A=%u OCR1A=%u ICR1=%u\n",(0 != hw) ? "hw" : "isr",
+             (unsigned long)dly,(unsigned long)wtd,(unsigned long)d,(unsigned long)w,
+             (unsigned)OCR0A,(unsigned)OCR1A,(unsigned)ICR1,(unsigned long)m.delay,
+             (unsigned long)m.width,(unsigned)m.ocr0a,(unsigned)m.ocr1a,(unsigned)m.icr1);
+    }
+  }
+}
+
+/**
+ *@brief 延时、脉宽限幅：边界值的组合加随机值，两种脉冲产生方式
+ *@param runs 随机次数
+ */
+static void fuzz_pulse(unsigned long runs)
+{
+  static const uint32_t edge[] =
+  {
+    0UL,1UL,1999UL,2000UL,3999UL,4000UL,4001UL,4999UL,5000UL,5001UL,9999UL,10000UL,10001UL,
+    20000UL,32767UL,32768UL,55535UL,55536UL,60000UL,65535UL,65536UL,65537UL,70000UL,99998UL,
+    99999UL,100000UL,100001UL,131071UL,131072UL,0xffffUL + 4464UL,0x7fffffffUL,0xffffffffUL,
+  };
+  unsigned i;
+  unsigned j;
+  unsigned long n;
+  int hw;
+  uint32_t dly;
+  uint32_t wtd;
+  for(hw = 0;hw < 2;hw++)
+  {
+    memset((void *)sim_sfr,0,sizeof(sim_sfr));
+    pls_init();
+    pls_set_mode(1U);
+    pls_set_out((0 != hw) ? PLS_OUT_HW : PLS_OUT_ISR);
+    for(i = 0;i < (sizeof(edge) / sizeof(edge[0]));i++)
+    {
+      for(j = 0;j < (sizeof(edge) / sizeof(edge[0]));j++)
+      {
+        fuzz_pulse_one(edge[i],edge[j],hw);
+      }
+    }
+    for(n = 0;n < runs;n++)
+    {
+      /*一半落在有效范围附近，一半为任意32位值*/
+      dly = (0 != (n & 1U)) ? fuzz_rand() : (fuzz_rand() % 140000UL);
+      wtd = (0 != (n & 2U)) ? fuzz_rand() : (fuzz_rand() % 14000UL);
+      fuzz_pulse_one(dly,wtd,hw);
+    }
+  }
+}
+
+/**
+ *@brief 随机字符串，偏向数字、退格和回车
+ *@param[out] str 字符串，至少 @ref FUZZ_STRLEN 加1字节
+ *@return 长度
+ */
+static unsigned fuzz_string(uint8_t str[])
+{
+  unsigned len;
+  unsigned i;
+  uint32_t r;
+  len = fuzz_rand() % (FUZZ_STRLEN + 1U);
+  for(i = 0;i < len;i++)
+  {
+    r = fuzz_rand();
+    if((r & 3U) != 0)
+    {
+      str[i] = (uint8_t)('0' + ((r >> 8) % 10U));
+    }
+    else if(((r >> 2) & 7U) == 0)
+    {
+      str[i] = 0x08U;
+    }
+    else
+    {
+      str[i] = (uint8_t)(r >> 16);
+    }
+  }
+  str[len] = 0;
+  return len;
+}
+
+/**
+ *@brief pls_strtou() 的参考模型：最多转换5位，遇到非数字字符结束
+ */
+static uint32_t fuzz_strtou_model(const uint8_t str[])
+{
+  uint32_t ret = 0;
+  unsigned i;
+  for(i = 0;(i < 5U) && (str[i] >= '0') && (str[i] <= '9');i++)
+  {
+    ret = ret * 10U + (uint32_t)(str[i] - '0');
+  }
+  return ret;
+}
+
+/**
+ *@brief 数字字符串转换
+ *@param runs 随机次数
+ */
+static void fuzz_strtou(unsigned long runs)
+{
+  static const char *const edge[] =
+  {
+    "","0","5","00000","99999","999999","65535","65536","123456789","12a45","/",":","9:",
+  };
+  uint8_t str[FUZZ_STRLEN + 1U];
+  unsigned long n;
+  uint32_t got;
+  uint32_t exp;
+  for(n = 0;n < (runs + (sizeof(edge) / sizeof(edge[0])));n++)
+  {
+    if(n < (sizeof(edge) / sizeof(edge[0])))
+    {
+      strcpy((char *)str,edge[n]);
+    }
+    else
+    {
+      (void)fuzz_string(str);
+    }
+    got = pls_strtou(str);
+    exp = fuzz_strtou_model(str);
+    if(got != exp)
+    {
+      if(0 != fuzz_fail())
+      {
+        printf("strtou \"%s\": got %lu, model %lu\n",(const char *)str,(unsigned long)got,
+               (unsigned long)exp);
+      }
+    }
+  }
+}
+
+/**
+ *@brief 数字输入的参考模型：数字最多收5位，退格删去一位，其它字符结束
+ *@param[in] in 输入字符
+ *@param len 输入长度
+ *@param[out] str 收到的数字字符串
+ *@param[out] used 消耗的字符数
+ *@return 数字个数，未结束时-1
+ */
+static int fuzz_num_model(const uint8_t in[],unsigned len,uint8_t str[],unsigned *used)
+{
+  unsigned i;
+  unsigned n = 0;
+  int ret = -1;
+  for(i = 0;(i < len) && (ret < 0);i++)
+  {
+    if((in[i] >= '0') && (in[i] <= '9'))
+    {
+      if(n < 5U)
+      {
+        str[n] = in[i];
+        n++;
+      }
+    }
+    else if(0x08U == in[i])
+    {
+      if(n > 0)
+      {
+        n--;
+      }
+    }
+    else
+    {
+      ret = (int)n;
+    }
+  }
+  str[n] = 0;
+  *used = i;
+  return ret;
+}
+
+/**
+ *@brief 由接收中断送入一个字节
+ */
+static void fuzz_rx(uint8_t ch)
+{
+  UDR0 = ch;
+  USART_RX_vect();
+}
+
+/**
+ *@brief 阻塞和非阻塞数字输入
+ *@param runs 随机次数
+ */
+static void fuzz_num(unsigned long runs)
+{
+  uint8_t in[FUZZ_STRLEN + 2U];
+  uint8_t exp[8];
+  uint8_t got[8];
+  unsigned long n;
+  unsigned len;
+  unsigned used;
+  unsigned i;
+  int ret;
+  int8_t r;
+  for(n = 0;n < runs;n++)
+  {
+    len = fuzz_string(in);
+    /*以回车结束，保证阻塞接收能返回*/
+    in[len] = '\r';
+    len++;
+    ret = fuzz_num_model(in,len,exp,&used);
+
+    uart_flush();
+    for(i = 0;i < len;i++)
+    {
+      fuzz_rx(in[i]);
+    }
+    memset(got,0xaa,sizeof(got));
+    r = uart_getnum(got);
+    if((r != ret) || (0 != strcmp((const char *)got,(const char *)exp)))
+    {
+      if(0 != fuzz_fail())
+      {
+        printf("getnum run %lu: got %d \"%s\", model %d \"%s\"\n",n,r,(const char *)got,ret,
+               (const char *)exp);
+      }
+    }
+
+    /*非阻塞接收逐字节送入，结束后剩余字符留在缓冲区*/
+    uart_flush();
+    memset(got,0xaa,sizeof(got));
+    r = -1;
+    for(i = 0;(i < len) && (r < 0);i++)
+    {
+      fuzz_rx(in[i]);
+      r = uart_readnum(got);
+    }
+    if((r != ret) || (i != used) || (0 != strcmp((const char *)got,(const char *)exp)))
+    {
+      if(0 != fuzz_fail())
+      {
+        printf("readnum run %lu: got %d \"%s\" after %u, model %d \"%s\" after %u\n",n,r,
+               (const char *)got,i,ret,(const char *)exp,used);
+      }
+    }
+  }
+}
+
+/**
+ *@brief 运行全部随机测试
+ *@return 0全部一致，1有不一致
+ */
+int main(int argc,char *argv[])
+{
+  unsigned long runs = FUZZ_RUNS;
+  if(argc > 1)
+  {
+    runs = strtoul(argv[1],NULL,0);
+  }
+  fuzz_state = (argc > 2) ? (uint32_t)strtoul(argv[2],NULL,0) : 0x2016a10cUL;
+  if(0 == fuzz_state)
+  {
+    fuzz_state = 1U;
+  }
+  printf("seed 0x%08lx, %lu runs\n",(unsigned long)fuzz_state,runs);
+  fuzz_pulse(runs);
+  fuzz_strtou(runs);
+  fuzz_num(runs);
+  printf("%lu mismatches\n",fuzz_failed);
+  return (0 == fuzz_failed) ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+# @brief 中断服务程序最坏执行周期静态分析
+# @file host/isrcycles.awk
+# @author shenxf 380406785@@qq.com
+# @version V1.2.0
+# @date 2016-10-24
+#
+# 输入为avr-objdump -d的反汇编，变量budget给出待检查的中断，形如
+#   "1:INT0_vect 7:TIMER2_COMPA_vect:300"
+# 即“向量号:名称[:最多周期数]”。从向量表入口（向量号×4）开始沿所有路径求最长周期数：
+# 包括中断响应4周期、向量表jmp、序言、函数体、被调用函数和reti。条件转移、跳过指令按
+# 两个分支取最大，call/rcall计入被调用函数到ret的最坏值。没有给出周期数的中断只报告结果，
+# 用于按实际编译结果确定预算。\n
+# 循环由变量loops给出次数上限，形如"__vector_7:5 max_write+0x12:8 0x3a0:4"，即“循环入口:最多
+# 次数”，入口为向后转移的目标，写作“函数名+偏移”或绝对地址；只写函数名时该函数内全部向后转移的
+# 目标都按此次数计，不需要反汇编中的偏移，内联到中断服务程序的循环写中断的函数名。循环按“次数×一次循环最长路径＋
+# 离开循环的最长路径”计。-mcall-prologues的__prologue_saves__以ijmp返回到调用处下一条
+# 指令，按直线代码计入；__epilogue_restores__以ret结束，按转移处理。\n
+# 没有标注的循环、其余间接转移或调用无法定界，按不通过处理，并给出需要标注的入口。
+# 任一中断超出预算或无法定界时退出码为1。
+#
+# 周期数按ATmega328P（AVRe+，16位PC）指令表。
+
+function hex(s,    i, c, v)
+{
+  v = 0
+  s = tolower(s)
+  sub(/^0x/, "", s)
+  for (i = 1; i <= length(s); i++) {
+    c = index("0123456789abcdef", substr(s, i, 1))
+    if (c == 0)
+      break
+    v = v * 16 + c - 1
+  }
+  return v
+}
+
+# 指令本身（不转移、不跳过时）的周期数
+function cycles(m)
+{
+  if (m in cyc)
+    return cyc[m]
+  return 1
+}
+
+# 两个分支取最大；-1无法定界，-2路径不可能（回到循环入口或到达被排除的入口）
+function alt(x, y)
+{
+  if (x == -1 || y == -1)
+    return -1
+  if (x == -2)
+    return y
+  if (y == -2)
+    return x
+  return (x > y) ? x : y
+}
+
+# 先执行c个周期再接续t
+function seq(c, t)
+{
+  return (t < 0) ? t : c + t
+}
+
+# 地址的“函数名+偏移”写法
+function where(a)
+{
+  return sprintf("%s+0x%x", fn[a], a - fnaddr[a])
+}
+
+# 从地址a执行到ret/reti（或当前循环入口goal）的最坏周期数，-1表示无法定界，-2表示不可能
+function worst(a,    w, it, ex, g, x)
+{
+  if (a == goal)
+    return 0
+  if (a in ban || a in inloop)
+    return -2
+  if ((ctx, a) in memo)
+    return memo[ctx, a]
+  if (!(a in op)) {
+    why = sprintf("no code at 0x%x", a)
+    return -1
+  }
+  if (a in bound) {
+    g = goal
+    x = ctx
+    inloop[a] = 1
+    goal = a
+    ctx = x "<" a
+    it = step(a)
+    goal = g
+    ban[a] = 1
+    ctx = x ">" a
+    ex = step(a)
+    delete ban[a]
+    delete inloop[a]
+    ctx = x
+    if (it == -1 || ex == -1)
+      w = -1
+    else if (ex == -2)
+      w = -2
+    else if (it == -2)
+      w = ex
+    else
+      w = bound[a] * it + ex
+  } else if (a in busy) {
+    why = sprintf("loop at 0x%x, annotate loops=\"%s:N\"", a, where(a))
+    return -1
+  } else {
+    busy[a] = 1
+    w = step(a)
+    delete busy[a]
+  }
+  if (w != -1)
+    memo[ctx, a] = w
+  return w
+}
+
+# 执行地址a的指令，再沿其后继求最坏周期数。被调用函数在循环之外单独计算，循环中的ret/reti
+# 离开了循环所在的函数，不算一次循环
+function step(a,    m, n, c, t, s, g, x)
+{
+  m = op[a]
+  n = a + len[a]
+  c = cycles(m)
+  if (m == "ret" || m == "reti") {
+    s = (goal == -1) ? c : -2
+  } else if ((m == "rjmp" || m == "jmp") && fn[tgt[a]] != "__prologue_saves__") {
+    s = seq(c, worst(tgt[a]))
+  } else if (m == "rcall" || m == "call" || m == "rjmp" || m == "jmp") {
+    g = goal
+    x = ctx
+    goal = -1
+    ctx = ""
+    t = worst(tgt[a])
+    goal = g
+    ctx = x
+    s = (t < 0) ? -1 : seq(c + t, worst(n))
+  } else if (m ~ /^br/) {
+    s = alt(seq(1, worst(n)), seq(2, worst(tgt[a])))
+  } else if (m == "cpse" || m ~ /^sb[ri][cs]$/) {
+    t = (n in op) ? worst(n + len[n]) : -1
+    s = alt(seq(1, worst(n)), seq(1 + len[n] / 2, t))
+  } else if (m == "ijmp" && fn[a] == "__prologue_saves__") {
+    s = c
+  } else if (m == "ijmp" || m == "icall" || m == "eijmp" || m == "eicall") {
+    why = sprintf("indirect %s at 0x%x (%s)", m, a, where(a))
+    s = -1
+  } else {
+    s = seq(c, worst(n))
+  }
+  return s
+}
+
+BEGIN {
+  FS = "\t"
+  split("adiw sbiw mul muls mulsu fmul fmuls fmulsu cbi sbi ld st ldd std lds sts push pop rjmp ijmp", l2, " ")
+  for (i in l2)
+    cyc[l2[i]] = 2
+  split("lpm elpm rcall icall jmp", l3, " ")
+  for (i in l3)
+    cyc[l3[i]] = 3
+  split("call ret reti eicall", l4, " ")
+  for (i in l4)
+    cyc[l4[i]] = 4
+  cur = ""
+  goal = -1
+  ctx = ""
+}
+
+# 函数标号行：0000009a <__vector_1>:
+/^[0-9a-f]+ <[^>]+>:$/ {
+  cur = $0
+  sub(/^[0-9a-f]+ </, "", cur)
+  sub(/>:$/, "", cur)
+  sym[cur] = hex($1)
+  next
+}
+
+# 指令行：  9a:<TAB>1f 92       <TAB>push<TAB>r1
+/^ *[0-9a-f]+:\t/ && NF >= 3 {
+  a = $1
+  sub(/^ */, "", a)
+  sub(/:$/, "", a)
+  a = hex(a)
+  b = $2
+  gsub(/ +$/, "", b)
+  m = $3
+  gsub(/ /, "", m)
+  if (m == "" || m == ".word")
+    next
+  op[a] = m
+  len[a] = int((length(b) + 1) / 3)
+  fn[a] = cur
+  fnaddr[a] = sym[cur]
+  if (match($0, /; 0x[0-9a-f]+/))
+    tgt[a] = hex(substr($0, RSTART + 2, RLENGTH - 2))
+  else if (NF >= 4 && $4 ~ /^0x[0-9a-f]+/)
+    tgt[a] = hex($4)
+}
+
+END {
+  fail = 0
+  n = split(loops, item, " ")
+  for (i = 1; i <= n; i++) {
+    split(item[i], f, ":")
+    if (split(f[1], g, "+") == 2) {
+      bound[sym[g[1]] + hex(g[2])] = f[2]
+    } else if (f[1] ~ /^0x/) {
+      bound[hex(f[1])] = f[2]
+    } else {
+      for (a in op)
+        if (fn[a] == f[1] && (op[a] ~ /^br/ || op[a] == "rjmp" || op[a] == "jmp") && tgt[a] <= a && fn[tgt[a]] == f[1])
+          bound[tgt[a]] = f[2]
+    }
+  }
+  n = split(budget, item, " ")
+  for (i = 1; i <= n; i++) {
+    split(item[i], f, ":")
+    why = ""
+    w = worst(f[1] * 4)
+    if (w < 0) {
+      printf "%-20s unbounded: %s\n", f[2], (w == -2) ? "no path to reti" : why
+      fail = 1
+    } else if (f[3] == "") {
+      printf "%-20s %5d cycles\n", f[2], w + 4
+    } else {
+      w += 4
+      printf "%-20s %5d cycles  budget %5d  %s\n", f[2], w, f[3], (w > f[3]) ? "OVER" : "ok"
+      if (w > f[3])
+        fail = 1
+    }
+  }
+  exit fail
+}
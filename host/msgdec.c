@@ -0,0 +1,134 @@
+/**
+ * @brief 消息代码解码
+ * @file host/msgdec.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 把代码方式的串口输出还原为文本方式的输出：代码字节（0x80加消息编号）及其二进制参数按 msg.def
+ * 展开，其它字节原样输出，回车丢弃。与固件包含同一个消息表，增加消息后重新编译即可\n
+ * 用法：msgdec [文件]，无文件时从标准输入读取，例如 msgdec < /dev/ttyUSB0
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "msg.h"
+
+#define MSG(id,arg,text) text,
+static const char *const msgdec_text[MSG_NUM] =
+{
+#include "msg.def"
+};
+#undef MSG
+
+#define MSG(id,arg,text) arg,
+static const uint8_t msgdec_arg[MSG_NUM] =
+{
+#include "msg.def"
+};
+#undef MSG
+
+/**
+ *@brief 读取低字节在前的二进制参数
+ *@return 参数，数据不足时返回-1
+ */
+static long msgdec_bin(FILE *in,int n)
+{
+  long num = 0;
+  int i;
+  int ch;
+  for(i = 0;i < n;i++)
+  {
+    ch = getc(in);
+    if(EOF == ch)
+    {
+      return -1;
+    }
+    num |= (long)ch << (8 * i);
+  }
+  return num;
+}
+
+/**
+ *@brief 按固件格式“d.dddd”输出时间参数
+ */
+static void msgdec_times(long num)
+{
+  printf("%ld.%04ld",(num / 10000L) % 10L,num % 10000L);
+}
+
+int main(int argc,char *argv[])
+{
+  FILE *in = stdin;
+  int ch;
+  uint8_t id;
+  long a;
+  long b;
+
+  if(argc > 1)
+  {
+    in = fopen(argv[1],"rb");
+    if(NULL == in)
+    {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  while(EOF != (ch = getc(in)))
+  {
+    id = (uint8_t)(ch & ~MSG_TOKEN);
+    if((0 == (ch & MSG_TOKEN)) || (id >= MSG_NUM))
+    {
+      if('\r' != ch)
+      {
+        putchar(ch);
+      }
+      continue;
+    }
+    fputs(msgdec_text[id],stdout);
+    a = 0;
+    b = 0;
+    if(MSG_ARG_HEX1 == msgdec_arg[id])
+    {
+      a = msgdec_bin(in,1);
+    }
+    else if(MSG_ARG_NUM2 == msgdec_arg[id])
+    {
+      a = msgdec_bin(in,2);
+      b = msgdec_bin(in,2);
+    }
+    else if(MSG_ARG_NONE != msgdec_arg[id])
+    {
+      a = msgdec_bin(in,3);
+      if((MSG_ARG_TIME2 == msgdec_arg[id]) || (MSG_ARG_DEC2 == msgdec_arg[id]))
+      {
+        b = msgdec_bin(in,3);
+      }
+    }
+    if((a < 0) || (b < 0))
+    {
+      break;
+    }
+    if(MSG_ARG_HEX1 == msgdec_arg[id])
+    {
+      printf("%02lx\n",a);
+    }
+    else if((MSG_ARG_NUM2 == msgdec_arg[id]) || (MSG_ARG_DEC2 == msgdec_arg[id]))
+    {
+      printf("%ld,%ld\n",a,b);
+    }
+    else if(MSG_ARG_TIME1 == msgdec_arg[id])
+    {
+      msgdec_times(a);
+      putchar('\n');
+    }
+    else if(MSG_ARG_TIME2 == msgdec_arg[id])
+    {
+      msgdec_times(a);
+      putchar(',');
+      msgdec_times(b);
+      putchar('\n');
+    }
+    fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,478 @@
+/**
+ * @brief simavr多机总线及同步仿真
+ * @file host/multi.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 在simavr中同时运行多份pulse.elf（自动模式），按多机方式连接：主机发送的字节送到各台的串口输入，
+ * 各台的串口输出合并；第1台为同步主机，其PD6（时基输出）接到各台的PD5（时基输入）。先逐台点对点
+ * 设置地址（第k台为k）及从机角色，再在总线上：\n
+ * - 逐个地址发送状态查询，检查只有被选中的一台应答，两台的发送间隔小于一个字节时计为冲突\n
+ * - 在主机PD2注入触发，记录各台PB1的两个边沿相对主机的偏差\n
+ * 结果按JSON Lines逐行输出，type为addr、shot、skew之一，时间单位为CPU周期（16MHz）。最后一个参数
+ * 为pty时测试后继续运行，总线经伪终端连接 pulsectl 等主机程序。各台按周期数最小者先执行的方式
+ * 交替运行，睡眠时每步最多前进 @ref MULTI_QUANTUM 个周期，偏差的测量分辨率与此相当\n
+ * 用法：multi pulse.elf [台数] [触发次数] [pty]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pty.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+#define MULTI_FCPU      16000000UL /**<CPU时钟*/
+#define MULTI_MS        (MULTI_FCPU / 1000U) /**<1ms对应的周期数*/
+#define MULTI_MAX       8U         /**<最多台数*/
+#define MULTI_UNITS     3U         /**<缺省台数*/
+#define MULTI_SHOTS     4U         /**<缺省触发次数*/
+#define MULTI_QUANTUM   4U         /**<睡眠时每步最多前进的周期数*/
+#define MULTI_BYTE      (MULTI_FCPU * 10U / 115200U) /**<一个字节的传输时间*/
+#define MULTI_TRIG_LOW  1600U      /**<触发低电平保持时间，100us*/
+#define MULTI_BOOT      (20U * MULTI_FCPU) /**<等待上电自检结束的最长时间*/
+#define MULTI_STEP      (2U * MULTI_FCPU)  /**<等待一次应答的最长时间*/
+#define MULTI_PULSE     (15U * MULTI_FCPU) /**<等待一个脉冲的最长时间*/
+#define MULTI_MARK      0xffU      /**<地址选择字节，与uart.h一致*/
+
+/**
+ * @brief 一台发生器
+ */
+typedef struct multi_unit
+{
+  avr_t *avr;
+  avr_irq_t *rx;             /**<串口输入*/
+  avr_irq_t *trig;           /**<PD2，触发输入*/
+  char line[64];             /**<串口输出的当前行*/
+  uint32_t linelen;
+  const char *want;          /**<等待的字符串*/
+  int seen;                  /**<等待的字符串已出现*/
+  uint32_t bytes;            /**<串口输出的字节数*/
+  avr_cycle_count_t rise;    /**<本次脉冲的延时边沿*/
+  avr_cycle_count_t fall;    /**<本次脉冲的脉宽边沿*/
+}smunit_t;
+
+static smunit_t multi_unit[MULTI_MAX];
+static uint32_t multi_n;
+static int multi_bus;                  /*0逐台设置，1总线*/
+static int multi_pty = -1;             /*伪终端主设备*/
+static int multi_last = -1;            /*最近输出字节的台*/
+static avr_cycle_count_t multi_last_tx;/*最近输出字节的时刻*/
+static uint32_t multi_collisions;
+
+/**
+ *@brief 当前时刻，各台周期数的最小值
+ */
+static avr_cycle_count_t multi_now(void)
+{
+  avr_cycle_count_t t = multi_unit[0].avr->cycle;
+  uint32_t i;
+  for(i = 1;i < multi_n;i++)
+  {
+    if(multi_unit[i].avr->cycle < t)
+    {
+      t = multi_unit[i].avr->cycle;
+    }
+  }
+  return t;
+}
+
+/**
+ *@brief 限制睡眠步长的周期定时器，使睡眠的一台不会超前其它台
+ */
+static avr_cycle_count_t multi_quantum(avr_t *avr,avr_cycle_count_t when,void *param)
+{
+  return when + MULTI_QUANTUM;
+}
+
+/**
+ *@brief 串口输出：按行匹配等待的字符串，总线上检查冲突并转发到伪终端
+ */
+static void multi_uart(avr_irq_t *irq,uint32_t value,void *param)
+{
+  smunit_t *u = (smunit_t *)param;
+  int k = (int)(u - multi_unit);
+  uint8_t ch = (uint8_t)value;
+  u->bytes++;
+  if(0 != multi_bus)
+  {
+    if((multi_last >= 0) && (multi_last != k) && ((u->avr->cycle - multi_last_tx) < MULTI_BYTE))
+    {
+      multi_collisions++;
+    }
+    multi_last = k;
+    multi_last_tx = u->avr->cycle;
+    if(multi_pty >= 0)
+    {
+      (void)write(multi_pty,&ch,1);
+    }
+  }
+  if(('\n' == ch) || ('\r' == ch) || (u->linelen >= (sizeof(u->line) - 1U)))
+  {
+    u->linelen = 0;
+  }
+  else
+  {
+    u->line[u->linelen++] = (char)ch;
+  }
+  u->line[u->linelen] = '\0';
+  if((NULL != u->want) && (NULL != strstr(u->line,u->want)))
+  {
+    u->seen = 1;
+    u->want = NULL;
+  }
+}
+
+/**
+ *@brief 脉冲输出PB1边沿
+ */
+static void multi_pb1(avr_irq_t *irq,uint32_t value,void *param)
+{
+  smunit_t *u = (smunit_t *)param;
+  if(0 != value)
+  {
+    u->rise = u->avr->cycle;
+  }
+  else if(0 != u->rise)
+  {
+    u->fall = u->avr->cycle;
+  }
+}
+
+/**
+ *@brief 触发线恢复高电平
+ */
+static avr_cycle_count_t multi_trig_release(avr_t *avr,avr_cycle_count_t when,void *param)
+{
+  avr_raise_irq((avr_irq_t *)param,1);
+  return 0;
+}
+
+/**
+ *@brief 发送字节
+ *@param[in] k 台号，负数为总线上的全部
+ */
+static void multi_send(int k,const uint8_t *data,size_t n)
+{
+  uint32_t i;
+  size_t j;
+  for(i = 0;i < multi_n;i++)
+  {
+    if((k < 0) || ((uint32_t)k == i))
+    {
+      for(j = 0;j < n;j++)
+      {
+        avr_raise_irq(multi_unit[i].rx,data[j]);
+      }
+    }
+  }
+}
+
+/**
+ *@brief 执行一步：周期数最小的一台执行一条指令或睡眠一步
+ *@return 0有一台停止或崩溃
+ */
+static int multi_step(void)
+{
+  uint32_t i;
+  uint32_t k = 0;
+  int state;
+  for(i = 1;i < multi_n;i++)
+  {
+    if(multi_unit[i].avr->cycle < multi_unit[k].avr->cycle)
+    {
+      k = i;
+    }
+  }
+  state = avr_run(multi_unit[k].avr);
+  return (cpu_Done != state) && (cpu_Crashed != state);
+}
+
+/**
+ *@brief 运行一段时间
+ */
+static int multi_run(avr_cycle_count_t cycles)
+{
+  avr_cycle_count_t until = multi_now() + cycles;
+  while(multi_now() < until)
+  {
+    if(0 == multi_step())
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ *@brief 运行到第k台（负数为全部）的串口输出出现字符串
+ *@return 0超时
+ */
+static int multi_wait_text(int k,const char *want,avr_cycle_count_t timeout)
+{
+  avr_cycle_count_t until = multi_now() + timeout;
+  uint32_t i;
+  int done;
+  for(i = 0;i < multi_n;i++)
+  {
+    multi_unit[i].seen = ((k >= 0) && ((uint32_t)k != i));
+    multi_unit[i].want = (0 != multi_unit[i].seen) ? NULL : want;
+  }
+  do
+  {
+    done = 1;
+    for(i = 0;i < multi_n;i++)
+    {
+      done &= multi_unit[i].seen;
+    }
+    if(0 != done)
+    {
+      return 1;
+    }
+  }
+  while((multi_now() < until) && (0 != multi_step()));
+  return 0;
+}
+
+/**
+ *@brief 逐台点对点设置地址，第1台以外设为从机
+ */
+static int multi_setup(void)
+{
+  char cmd[8];
+  uint32_t i;
+  for(i = 0;i < multi_n;i++)
+  {
+    multi_send((int)i,(const uint8_t *)"n",1U);
+    if(0 == multi_wait_text((int)i,"Address",MULTI_STEP))
+    {
+      return 0;
+    }
+    snprintf(cmd,sizeof(cmd),"%u\r",i + 1U);
+    multi_send((int)i,(const uint8_t *)cmd,strlen(cmd));
+    if(0 == multi_wait_text((int)i,"Unit,sync",MULTI_STEP))
+    {
+      return 0;
+    }
+    if(0 != i)
+    {
+      (void)multi_run(5U * MULTI_MS);
+      multi_send((int)i,(const uint8_t *)"s",1U);
+      if(0 == multi_wait_text((int)i,"Unit,sync",MULTI_STEP))
+      {
+        return 0;
+      }
+    }
+  }
+  return multi_run(50U * MULTI_MS);
+}
+
+/**
+ *@brief 逐个地址发送状态查询，只应有被选中的一台应答
+ *@return 全部正确返回1
+ */
+static int multi_addr_test(void)
+{
+  static const uint8_t none[2] = {MULTI_MARK,0};
+  uint8_t query[3] = {MULTI_MARK,0,'?'};
+  uint32_t i;
+  uint32_t j;
+  int ok;
+  int all = 1;
+  multi_send(-1,none,sizeof(none));
+  (void)multi_run(20U * MULTI_MS);
+  for(i = 0;i < multi_n;i++)
+  {
+    for(j = 0;j < multi_n;j++)
+    {
+      multi_unit[j].bytes = 0;
+    }
+    multi_collisions = 0;
+    query[1] = (uint8_t)(i + 1U);
+    multi_send(-1,query,sizeof(query));
+    (void)multi_run(20U * MULTI_MS);
+    ok = (0 == multi_collisions);
+    printf("{\"type\":\"addr\",\"unit\":%u,\"bytes\":[",i + 1U);
+    for(j = 0;j < multi_n;j++)
+    {
+      printf("%s%u",(0 == j) ? "" : ",",multi_unit[j].bytes);
+      ok &= ((j == i) == (0 != multi_unit[j].bytes));
+    }
+    printf("],\"collisions\":%u,\"ok\":%s}\n",multi_collisions,(0 != ok) ? "true" : "false");
+    all &= ok;
+  }
+  multi_send(-1,none,sizeof(none));
+  return all;
+}
+
+/**
+ *@brief 在主机注入触发，记录各台的脉冲边沿
+ *@return 偏差的最大绝对值，周期数；有一台没有产生脉冲时为-1
+ */
+static long long multi_shot(uint32_t n)
+{
+  smunit_t *m = &multi_unit[0];
+  avr_cycle_count_t t0;
+  avr_cycle_count_t until;
+  long long d;
+  long long worst = 0;
+  uint32_t i;
+  int done;
+  for(i = 0;i < multi_n;i++)
+  {
+    multi_unit[i].rise = 0;
+    multi_unit[i].fall = 0;
+  }
+  t0 = m->avr->cycle;
+  avr_raise_irq(m->trig,0);
+  avr_cycle_timer_register(m->avr,MULTI_TRIG_LOW,multi_trig_release,m->trig);
+  until = multi_now() + MULTI_PULSE;
+  do
+  {
+    done = 1;
+    for(i = 0;i < multi_n;i++)
+    {
+      done &= (0 != multi_unit[i].fall);
+    }
+  }
+  while((0 == done) && (multi_now() < until) && (0 != multi_step()));
+  printf("{\"type\":\"shot\",\"n\":%u,\"delay_cycles\":%lld,\"rise_skew\":[",
+         n,(0 != m->rise) ? (long long)(m->rise - t0) : -1LL);
+  for(i = 0;i < multi_n;i++)
+  {
+    d = (0 != multi_unit[i].rise) ? (long long)multi_unit[i].rise - (long long)m->rise : 0;
+    printf("%s%lld",(0 == i) ? "" : ",",d);
+    worst = (llabs(d) > worst) ? llabs(d) : worst;
+  }
+  printf("],\"fall_skew\":[");
+  for(i = 0;i < multi_n;i++)
+  {
+    d = (0 != multi_unit[i].fall) ? (long long)multi_unit[i].fall - (long long)m->fall : 0;
+    printf("%s%lld",(0 == i) ? "" : ",",d);
+    worst = (llabs(d) > worst) ? llabs(d) : worst;
+  }
+  printf("]}\n");
+  return (0 != done) ? worst : -1;
+}
+
+/**
+ *@brief 总线经伪终端连接主机程序，一直运行
+ */
+static void multi_serve(void)
+{
+  uint8_t buf[64];
+  ssize_t n;
+  int fd;
+  if(0 != openpty(&multi_pty,&fd,NULL,NULL,NULL))
+  {
+    perror("openpty");
+    return;
+  }
+  fcntl(multi_pty,F_SETFL,O_NONBLOCK);
+  printf("{\"type\":\"pty\",\"path\":\"%s\"}\n",ttyname(fd));
+  fflush(stdout);
+  while(0 != multi_run(MULTI_MS))
+  {
+    n = read(multi_pty,buf,sizeof(buf));
+    if(n > 0)
+    {
+      multi_send(-1,buf,(size_t)n);
+    }
+  }
+}
+
+int main(int argc,char *argv[])
+{
+  elf_firmware_t fw;
+  uint32_t flags = 0;
+  uint32_t shots;
+  uint32_t i;
+  long long worst = 0;
+  long long w;
+  int ok;
+  avr_irq_t *clk;
+  smunit_t *u;
+
+  if(argc < 2)
+  {
+    fprintf(stderr,"usage: %s pulse.elf [units] [shots] [pty]\n",argv[0]);
+    return 2;
+  }
+  multi_n = (argc > 2) ? (uint32_t)strtoul(argv[2],NULL,0) : MULTI_UNITS;
+  if((multi_n < 2U) || (multi_n > MULTI_MAX))
+  {
+    multi_n = MULTI_UNITS;
+  }
+  shots = (argc > 3) ? (uint32_t)strtoul(argv[3],NULL,0) : MULTI_SHOTS;
+
+  memset(&fw,0,sizeof(fw));
+  if(0 != elf_read_firmware(argv[1],&fw))
+  {
+    fprintf(stderr,"cannot read %s\n",argv[1]);
+    return 1;
+  }
+  for(i = 0;i < multi_n;i++)
+  {
+    u = &multi_unit[i];
+    u->avr = avr_make_mcu_by_name("atmega328p");
+    if(NULL == u->avr)
+    {
+      fprintf(stderr,"simavr has no atmega328p core\n");
+      return 1;
+    }
+    avr_init(u->avr);
+    avr_load_firmware(u->avr,&fw);
+    u->avr->frequency = MULTI_FCPU;
+    avr_cycle_timer_register(u->avr,MULTI_QUANTUM,multi_quantum,NULL);
+
+    avr_ioctl(u->avr,AVR_IOCTL_UART_GET_FLAGS('0'),&flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(u->avr,AVR_IOCTL_UART_SET_FLAGS('0'),&flags);
+    avr_irq_register_notify(avr_io_getirq(u->avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_OUTPUT),multi_uart,u);
+    u->rx = avr_io_getirq(u->avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(u->avr,AVR_IOCTL_IOPORT_GETIRQ('B'),1),multi_pb1,u);
+    u->trig = avr_io_getirq(u->avr,AVR_IOCTL_IOPORT_GETIRQ('D'),2);
+    avr_raise_irq(u->trig,1);
+  }
+
+  /*各台的D6连在一起，主机驱动；各台D5与D6相连*/
+  clk = avr_io_getirq(multi_unit[0].avr,AVR_IOCTL_IOPORT_GETIRQ('D'),6);
+  for(i = 0;i < multi_n;i++)
+  {
+    avr_connect_irq(clk,avr_io_getirq(multi_unit[i].avr,AVR_IOCTL_IOPORT_GETIRQ('D'),5));
+  }
+
+  if((0 == multi_wait_text(-1,"Start generate",MULTI_BOOT)) || (0 == multi_setup()))
+  {
+    fprintf(stderr,"setup failed\n");
+    return 1;
+  }
+  multi_bus = 1;
+  ok = multi_addr_test();
+
+  /*各台重新开放触发后在主机注入触发*/
+  for(i = 0;i < shots;i++)
+  {
+    (void)multi_run(300U * MULTI_MS);
+    w = multi_shot(i);
+    if(w < 0)
+    {
+      ok = 0;
+      break;
+    }
+    worst = (w > worst) ? w : worst;
+  }
+  printf("{\"type\":\"skew\",\"units\":%u,\"shots\":%u,\"max_cycles\":%lld,\"resolution\":%u}\n",
+         multi_n,i,worst,MULTI_QUANTUM);
+  fflush(stdout);
+
+  if((argc > 4) && (0 == strcmp(argv[4],"pty")))
+  {
+    multi_serve();
+  }
+  return (0 != ok) ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+/**
+ * @brief 单脉冲发生器命令行控制程序
+ * @file host/pulsectl.cpp
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 经 pulse_client 控制发生器。ping 和 throughput 以状态查询'?'测量串口往返时间及每秒应答数，
+ * 结果为JSON行，与 bench 的输出格式相同。throughput 同时未应答的查询不超过窗口数，
+ * 避免发生器16字节的接收缓冲溢出\n
+ * 多台共用一条串口总线时以-a选择地址，broadcast向全部发生器发送，发生器都不应答\n
+ * 用法：pulsectl [-p 端口] [-b 波特率] [-a 地址] 命令 [参数]\n
+ * 命令：status | auto | manual 延时数 脉宽数 | upload 文件 | run | log | overrun | echo | ping [次数] |
+ * throughput [秒数] [窗口] | monitor [秒数] | address 新地址 | sync master|slave | scan [最大地址] |
+ * broadcast 字符串
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "client.hpp"
+
+static const char *const pulsectl_mode[3] = {"auto","manual","program"};
+static const char *const pulsectl_state[6] = {"wait","delay","width","armed","load","address"};
+
+#define MSG(id,arg,text) #id,
+static const char *const pulsectl_name[MSG_NUM] =
+{
+#include "msg.def"
+};
+#undef MSG
+
+/**
+ *@brief 单调时钟，us
+ */
+static double pulsectl_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int pulsectl_usage(const char *prog)
+{
+  fprintf(stderr,"usage: %s [-p port] [-b baud] [-a address] command [args]\n"
+                 "  status | auto | manual DELAY WIDTH | upload FILE | run | log | overrun | echo\n"
+                 "  ping [N] | throughput [SECONDS] [WINDOW] | monitor [SECONDS]\n"
+                 "  address NEW | sync master|slave | scan [LAST] | broadcast STRING\n",prog);
+  return 2;
+}
+
+/**
+ *@brief 读取程序文件：二进制字节
+ */
+static bool pulsectl_load(const char *path,std::vector<uint8_t> &code)
+{
+  FILE *fp = fopen(path,"rb");
+  int c;
+  if(NULL == fp)
+  {
+    return false;
+  }
+  while(EOF != (c = fgetc(fp)))
+  {
+    code.push_back((uint8_t)c);
+  }
+  fclose(fp);
+  return true;
+}
+
+/**
+ *@brief 输出一条消息
+ */
+static void pulsectl_print(const pulse_msg &msg)
+{
+  if(PULSE_ID_TEXT == msg.id)
+  {
+    printf("TEXT %s\n",msg.text.c_str());
+  }
+  else
+  {
+    printf("%s %lu %lu\n",pulsectl_name[msg.id],(unsigned long)msg.a,(unsigned long)msg.b);
+  }
+  fflush(stdout);
+}
+
+/**
+ *@brief 往返时间：逐次发送状态查询，等待应答
+ */
+static int pulsectl_ping(pulse_client &cli,unsigned n)
+{
+  unsigned mode;
+  unsigned state;
+  unsigned i;
+  unsigned lost = 0;
+  double t;
+  double min = 1e12;
+  double max = 0;
+  double sum = 0;
+  for(i = 0;i < n;i++)
+  {
+    t = pulsectl_us();
+    if(!cli.status(mode,state))
+    {
+      lost++;
+      continue;
+    }
+    t = pulsectl_us() - t;
+    sum += t;
+    min = (t < min) ? t : min;
+    max = (t > max) ? t : max;
+  }
+  if(lost >= n)
+  {
+    printf("{\"test\":\"ping\",\"n\":%u,\"lost\":%u}\n",n,lost);
+    return 1;
+  }
+  printf("{\"test\":\"ping\",\"n\":%u,\"lost\":%u,\"min_us\":%.0f,\"mean_us\":%.0f,\"max_us\":%.0f}\n",
+         n,lost,min,sum / (n - lost),max);
+  return (0 == lost) ? 0 : 1;
+}
+
+/**
+ *@brief 吞吐量：保持window个未应答的状态查询
+ */
+static int pulsectl_throughput(pulse_client &cli,double seconds,unsigned window)
+{
+  pulse_msg msg;
+  unsigned pending = 0;
+  unsigned long replies = 0;
+  double start = pulsectl_us();
+  double end = start + seconds * 1e6;
+  while(pulsectl_us() < end)
+  {
+    while(pending < window)
+    {
+      cli.send("?");
+      pending++;
+    }
+    if(!cli.next(msg,500))
+    {
+      break;/*应答丢失*/
+    }
+    if(MSG_STATUS == msg.id)
+    {
+      pending--;
+      replies++;
+    }
+  }
+  cli.drain(100);
+  seconds = (pulsectl_us() - start) / 1e6;
+  printf("{\"test\":\"throughput\",\"window\":%u,\"seconds\":%.2f,\"replies\":%lu,\"per_s\":%.0f}\n",
+         window,seconds,replies,replies / seconds);
+  return (0 != replies) ? 0 : 1;
+}
+
+int main(int argc,char *argv[])
+{
+  std::string port = "/dev/ttyUSB0";
+  unsigned baud = 115200U;
+  unsigned addr = 0;
+  int opt;
+  const char *cmd;
+  unsigned mode;
+  unsigned state;
+  pulse_msg msg;
+
+  while(-1 != (opt = getopt(argc,argv,"p:b:a:")))
+  {
+    switch(opt)
+    {
+      case 'p':
+        port = optarg;
+        break;
+      case 'b':
+        baud = (unsigned)strtoul(optarg,NULL,0);
+        break;
+      case 'a':
+        addr = (unsigned)strtoul(optarg,NULL,0);
+        break;
+      default:
+        return pulsectl_usage(argv[0]);
+    }
+  }
+  if(optind >= argc)
+  {
+    return pulsectl_usage(argv[0]);
+  }
+  cmd = argv[optind++];
+
+  try
+  {
+    pulse_client cli(port,baud);
+    cli.target(addr);
+    cli.drain(50);
+    if(0 == strcmp(cmd,"status"))
+    {
+      if(!cli.status(mode,state))
+      {
+        fprintf(stderr,"no reply\n");
+        return 1;
+      }
+      printf("%s %s\n",(mode < 3U) ? pulsectl_mode[mode] : "?",(state < 6U) ? pulsectl_state[state] : "?");
+    }
+    else if(0 == strcmp(cmd,"auto"))
+    {
+      if(!cli.set_auto())
+      {
+        fprintf(stderr,"cannot enter auto mode\n");
+        return 1;
+      }
+    }
+    else if(0 == strcmp(cmd,"manual"))
+    {
+      uint32_t delay;
+      uint32_t width;
+      if((argc - optind) < 2)
+      {
+        return pulsectl_usage(argv[0]);
+      }
+      if(!cli.set_manual((uint32_t)strtoul(argv[optind],NULL,0),(uint32_t)strtoul(argv[optind + 1],NULL,0),
+                         &delay,&width))
+      {
+        fprintf(stderr,"cannot set manual parameters\n");
+        return 1;
+      }
+      printf("delay %lu width %lu\n",(unsigned long)delay,(unsigned long)width);
+    }
+    else if(0 == strcmp(cmd,"upload"))
+    {
+      std::vector<uint8_t> code;
+      if((optind >= argc) || !pulsectl_load(argv[optind],code))
+      {
+        return pulsectl_usage(argv[0]);
+      }
+      if(!cli.upload(code))
+      {
+        fprintf(stderr,"upload failed\n");
+        return 1;
+      }
+    }
+    else if(0 == strcmp(cmd,"run"))
+    {
+      if(!cli.run_program())
+      {
+        fprintf(stderr,"cannot enter program mode\n");
+        return 1;
+      }
+    }
+    else if(0 == strcmp(cmd,"log"))
+    {
+      std::vector<std::string> lines;
+      if(!cli.read_log(lines))
+      {
+        fprintf(stderr,"no reply\n");
+        return 1;
+      }
+      for(size_t i = 0;i < lines.size();i++)
+      {
+        printf("%s\n",lines[i].c_str());
+      }
+    }
+    else if(0 == strcmp(cmd,"overrun"))
+    {
+      uint32_t ovr;
+      uint32_t dropped;
+      uint32_t queued;
+      uint32_t qwait;
+      uint32_t ignored;
+      if(!cli.overrun(ovr,dropped,queued,qwait,&ignored))
+      {
+        fprintf(stderr,"no reply\n");
+        return 1;
+      }
+      printf("{\"overrun\":%lu,\"dropped\":%lu,\"queued\":%lu,\"qwait_ms\":%lu,\"ignored\":%lu}\n",
+             (unsigned long)ovr,(unsigned long)dropped,(unsigned long)queued,(unsigned long)qwait,
+             (unsigned long)ignored);
+    }
+    else if(0 == strcmp(cmd,"echo"))
+    {
+      pulse_echo st;
+      if(!cli.echo(st))
+      {
+        fprintf(stderr,"no reply\n");
+        return 1;
+      }
+      printf("{\"count\":%lu,\"timeouts\":%lu,\"min_us\":%lu,\"max_us\":%lu,\"mean_us\":%lu,"
+             "\"last_us\":%lu,\"window_us\":%lu,\"bin_us\":%lu,\"bins\":[",
+             (unsigned long)st.count,(unsigned long)st.timeouts,(unsigned long)st.min,(unsigned long)st.max,
+             (unsigned long)st.mean,(unsigned long)st.last,(unsigned long)st.window,(unsigned long)st.bin);
+      for(size_t i = 0;i < st.bins.size();i++)
+      {
+        printf("%s%lu",(0 == i) ? "" : ",",(unsigned long)st.bins[i]);
+      }
+      printf("]}\n");
+    }
+    else if(0 == strcmp(cmd,"address"))
+    {
+      if(optind >= argc)
+      {
+        return pulsectl_usage(argv[0]);
+      }
+      if(!cli.set_address((unsigned)strtoul(argv[optind],NULL,0)))
+      {
+        fprintf(stderr,"cannot set address\n");
+        return 1;
+      }
+    }
+    else if(0 == strcmp(cmd,"sync"))
+    {
+      if((optind >= argc) || ((0 != strcmp(argv[optind],"master")) && (0 != strcmp(argv[optind],"slave"))))
+      {
+        return pulsectl_usage(argv[0]);
+      }
+      if(!cli.set_sync(0 == strcmp(argv[optind],"slave")))
+      {
+        fprintf(stderr,"cannot set sync role\n");
+        return 1;
+      }
+    }
+    else if(0 == strcmp(cmd,"scan"))
+    {
+      std::vector<unsigned> found = cli.scan((optind < argc) ? (unsigned)strtoul(argv[optind],NULL,0)
+                                                             : PULSE_ADDR_MAX);
+      for(size_t i = 0;i < found.size();i++)
+      {
+        printf("%u\n",found[i]);
+      }
+      return found.empty() ? 1 : 0;
+    }
+    else if(0 == strcmp(cmd,"broadcast"))
+    {
+      if(optind >= argc)
+      {
+        return pulsectl_usage(argv[0]);
+      }
+      cli.broadcast(argv[optind]);
+    }
+    else if(0 == strcmp(cmd,"ping"))
+    {
+      return pulsectl_ping(cli,(optind < argc) ? (unsigned)strtoul(argv[optind],NULL,0) : 100U);
+    }
+    else if(0 == strcmp(cmd,"throughput"))
+    {
+      return pulsectl_throughput(cli,(optind < argc) ? strtod(argv[optind],NULL) : 5.0,
+                                 ((optind + 1) < argc) ? (unsigned)strtoul(argv[optind + 1],NULL,0) : 4U);
+    }
+    else if(0 == strcmp(cmd,"monitor"))
+    {
+      double end = pulsectl_us() + ((optind < argc) ? strtod(argv[optind],NULL) : 1e9) * 1e6;
+      while(pulsectl_us() < end)
+      {
+        if(cli.next(msg,200))
+        {
+          pulsectl_print(msg);
+        }
+      }
+    }
+    else
+    {
+      return pulsectl_usage(argv[0]);
+    }
+  }
+  catch(const pulse_error &e)
+  {
+    fprintf(stderr,"%s\n",e.what());
+    return 1;
+  }
+  return 0;
+}
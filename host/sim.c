@@ -0,0 +1,127 @@
+/**
+ * @brief 主机编译用仿真寄存器文件及EEPROM
+ * @file host/sim.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译（make host）时与各模块一起编译成库。寄存器只是存储单元，没有硬件动作，
+ * 测试程序通过写寄存器（如PIND、UDR0）模拟输入，读寄存器（如OCR1A、PORTB）检查输出，
+ * 直接调用中断服务程序（如INT0_vect()）模拟中断。.init段的函数在主机上不执行。OCR1A按数据手册
+ * 分为缓冲器和比较寄存器，PWM模式下写入的值不立即生效，由 sim_ocr1a_cmp() 读出实际比较的值
+ */
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+
+volatile uint8_t sim_sfr[0x100] __attribute__ ((aligned (2)));/**<仿真寄存器文件*/
+static uint16_t sim_ocr1a_reg;/**<OCR1A比较寄存器，定时器实际比较的值*/
+static uint8_t sim_ocr1a_direct;/**<上次访问OCR1A时没有双缓冲*/
+
+/**
+ *@brief 定时器1当前模式下OCR1A是否双缓冲
+ *@return 非零PWM模式，写入缓冲器，到BOTTOM或TOP才进入比较寄存器；0一般模式或CTC模式，直接写入
+ */
+static uint8_t sim_t1_buffered(void)
+{
+  uint8_t wgm;
+  wgm = (uint8_t)(((TCCR1B >> WGM12) & 3U) << 2) | (TCCR1A & 3U);
+  return (0 != wgm) && (4U != wgm) && (12U != wgm);
+}
+
+/**
+ *@brief 上次访问在没有双缓冲的模式下时，写入的值已进入比较寄存器
+ */
+static void sim_ocr1a_commit(void)
+{
+  if(0 != sim_ocr1a_direct)
+  {
+    sim_ocr1a_reg = *(volatile uint16_t *)&sim_sfr[0x88];
+  }
+}
+
+/**
+ *@brief OCR1A的访问，寄存器文件中的OCR1A是CPU读写的缓冲器
+ *@return 缓冲器地址
+ *
+ *每次访问记下当时的模式，写入的值在下一次访问或 sim_ocr1a_cmp() 时按写入时的模式处理
+ */
+volatile uint16_t *sim_ocr1a(void)
+{
+  sim_ocr1a_commit();
+  sim_ocr1a_direct = (0 == sim_t1_buffered());
+  return (volatile uint16_t *)&sim_sfr[0x88];
+}
+
+/**
+ *@brief 定时器1实际比较的OCR1A
+ *@return 比较寄存器的值，PWM模式下写入的值在计数到BOTTOM前不生效
+ */
+uint16_t sim_ocr1a_cmp(void)
+{
+  sim_ocr1a_commit();
+  return sim_ocr1a_reg;
+}
+
+/**
+ *@brief 读EEPROM一个字节
+ *@param p EEMEM变量地址
+ *@return 数据
+ */
+uint8_t eeprom_read_byte(const uint8_t *p)
+{
+  return *p;
+}
+
+/**
+ *@brief 写EEPROM一个字节
+ *@param p EEMEM变量地址
+ *@param value 数据
+ */
+void eeprom_write_byte(uint8_t *p,uint8_t value)
+{
+  *p = value;
+}
+
+/**
+ *@brief 更新EEPROM一个字节
+ *@param p EEMEM变量地址
+ *@param value 数据
+ */
+void eeprom_update_byte(uint8_t *p,uint8_t value)
+{
+  *p = value;
+}
+
+/**
+ *@brief 读EEPROM数据块
+ *@param dst 目的地址
+ *@param src EEMEM变量地址
+ *@param n 字节数
+ */
+void eeprom_read_block(void *dst,const void *src,size_t n)
+{
+  memcpy(dst,src,n);
+}
+
+/**
+ *@brief 写EEPROM数据块
+ *@param src 源地址
+ *@param dst EEMEM变量地址
+ *@param n 字节数
+ */
+void eeprom_write_block(const void *src,void *dst,size_t n)
+{
+  memcpy(dst,src,n);
+}
+
+/**
+ *@brief 更新EEPROM数据块
+ *@param src 源地址
+ *@param dst EEMEM变量地址
+ *@param n 字节数
+ */
+void eeprom_update_block(const void *src,void *dst,size_t n)
+{
+  memcpy(dst,src,n);
+}
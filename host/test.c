@@ -0,0 +1,585 @@
+/**
+ * @brief 主机单元测试
+ * @file host/test.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 与主机库（make host）链接，在仿真寄存器文件上调用pls_*函数，并直接调用中断服务程序模拟触发、
+ * 比较匹配等中断，检查OCR1A、ICR1、TCCR1x、PORTB等寄存器和模块状态；另检查参数保存模块的
+ * 请求登记和下标推迟写入。每个检查失败时输出行号和表达式，有失败时返回非零。用法：test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "pulse.h"
+#include "sched.h"
+#include "cfg.h"
+#include "uart.h"
+#include "disp.h"
+
+#define TEST_CHECK(c) test_check((c),#c,__LINE__) /**<检查表达式，失败时记录*/
+
+extern volatile uint8_t sim_sfr[0x100];
+extern scfg_t cfg_ring[CFG_SLOTS];
+extern uint8_t disp_buf[5];
+extern const uint8_t digitcode[10];
+
+void INT0_vect(void);
+void TIMER1_COMPA_vect(void);
+void TIMER1_COMPB_vect(void);
+void TIMER1_CAPT_vect(void);
+void TIMER2_COMPB_vect(void);
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+void USART_TX_vect(void);
+
+static unsigned test_total;/**<检查次数*/
+static unsigned test_failed;/**<失败次数*/
+
+/**
+ *@brief 记录一次检查
+ *@param ok 非零通过
+ *@param expr 表达式文本
+ *@param line 行号
+ */
+static void test_check(int ok,const char *expr,int line)
+{
+  test_total++;
+  if(!ok)
+  {
+    test_failed++;
+    printf("host/test.c:%d: check failed: %s\n",line,expr);
+  }
+}
+
+/**
+ *@brief 清零仿真寄存器文件后初始化脉冲模块
+ */
+static void test_reset(void)
+{
+  memset((void *)sim_sfr,0,sizeof(sim_sfr));
+  pls_init();
+}
+
+/**
+ *@brief 触发端口置为电平
+ *@param lvl 0低电平，非零高电平
+ */
+static void test_trig_level(uint8_t lvl)
+{
+  if(0 != lvl)
+  {
+    SPARK_PINS |= _BV(SPARK_PIN);
+  }
+  else
+  {
+    SPARK_PINS &= (uint8_t)~_BV(SPARK_PIN);
+  }
+}
+
+/**
+ *@brief 下降沿外部触发一次
+ */
+static void test_fall(void)
+{
+  test_trig_level(0);
+  INT0_vect();
+}
+
+/**
+ *@brief 定时器1时钟位
+ *@return TCCR1B的CS12～CS10
+ */
+static uint8_t test_t1_clock(void)
+{
+  return TCCR1B & (_BV(CS12)|_BV(CS11)|_BV(CS10));
+}
+
+/**
+ *@brief 初始化后的寄存器状态
+ */
+static void test_init(void)
+{
+  test_reset();
+  TEST_CHECK(TCCR0A == (_BV(COM0A0)|_BV(WGM01)));
+  TEST_CHECK(OCR0A == 99U);
+  TEST_CHECK(TCCR1A == _BV(COM1A0));
+  TEST_CHECK(TCCR1B == _BV(WGM12));
+  TEST_CHECK(OCR1A == 5000U);
+  TEST_CHECK(EICRA == _BV(ISC01));
+  TEST_CHECK(EIMSK == 0);
+  TEST_CHECK(0 != (PULSE_DDR & _BV(PULSE_PIN)));
+  TEST_CHECK(0 != (LED_DDR & _BV(LED_PIN)));
+  TEST_CHECK(0 != (CLKOUT_DDR & _BV(CLKOUT_PIN)));
+  TEST_CHECK(0 == (CLKIN_DDR & _BV(CLKIN_PIN)));
+  TEST_CHECK(PULSE_STA_COMPLETE == pls_get_sta());
+  TEST_CHECK(0 == pls_get_busy());
+}
+
+/**
+ *@brief 中断方式的一个手动脉冲：开放触发、触发、延时边沿、脉宽边沿
+ */
+static void test_isr_pulse(void)
+{
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(12345UL,6000UL);
+  pls_set_param();
+  TEST_CHECK(OCR0A == 99U);
+  TEST_CHECK(OCR1A == 12345U);
+  TEST_CHECK(TCCR1A == _BV(COM1A0));
+  TEST_CHECK(TCCR1B == _BV(WGM12));
+  TEST_CHECK(0 == test_t1_clock());
+  TEST_CHECK(PULSE_STA_DELAY == pls_get_sta());
+
+  pls_arm();
+  TEST_CHECK(0 != (EIMSK & _BV(INT0)));
+  GPIOR0 = 0;
+  LED_PORT |= _BV(LED_PIN);
+  test_fall();
+  TEST_CHECK(TCCR0B == _BV(CS01));
+  TEST_CHECK(TCCR1B == (_BV(WGM12)|_BV(CS12)|_BV(CS11)|_BV(CS10)));
+  TEST_CHECK(TIMSK1 == _BV(OCIE1A));
+  TEST_CHECK(0 != pls_get_busy());
+  TEST_CHECK(0 != (GPIOR0 & SCHED_EV_TRIG));
+  TEST_CHECK(0 == (LED_PORT & _BV(LED_PIN)));
+
+  TIMER1_COMPA_vect();
+  TEST_CHECK(PULSE_STA_WIDTH == pls_get_sta());
+  TEST_CHECK(OCR1A == 6000U);
+  TEST_CHECK(0 != (LED_PORT & _BV(LED_PIN)));
+
+  TIMER1_COMPA_vect();
+  TEST_CHECK(PULSE_STA_COMPLETE == pls_get_sta());
+  TEST_CHECK(0 == pls_get_busy());
+  TEST_CHECK(0 == test_t1_clock());
+  TEST_CHECK(TCCR0B == 0);
+  TEST_CHECK(TIMSK1 == 0);
+  TEST_CHECK(0 == (LED_PORT & _BV(LED_PIN)));
+  TEST_CHECK(0 != (GPIOR0 & SCHED_EV_DONE));
+}
+
+/**
+ *@brief 超过16位的延时改用0.2ms时基，延时、脉宽减半
+ */
+static void test_long_delay(void)
+{
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(80000UL,9000UL);
+  pls_set_param();
+  TEST_CHECK(OCR0A == 199U);
+  TEST_CHECK(OCR1A == 40000U);
+  TEST_CHECK(pls_get_delay() == 80000UL);
+  TEST_CHECK(pls_get_width() == 9000U);
+  pls_arm();
+  test_fall();
+  TIMER1_COMPA_vect();
+  TEST_CHECK(OCR1A == 4500U);
+}
+
+/**
+ *@brief 硬件边沿方式：快速PWM模式14，TOP为ICR1，比较匹配B结束
+ */
+static void test_hw_pulse(void)
+{
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_out(PLS_OUT_HW);
+  pls_set_pulse(20000UL,5000UL);
+  pls_set_param();
+  TEST_CHECK(OCR1A == 20000U);
+  TEST_CHECK(ICR1 == 24999U);
+  TEST_CHECK(OCR1B == 0);
+  TEST_CHECK(TCCR1A == (_BV(COM1A1)|_BV(COM1A0)|_BV(WGM11)));
+  TEST_CHECK(TCCR1B == (_BV(WGM13)|_BV(WGM12)));
+  pls_arm();
+  test_fall();
+  TEST_CHECK(TCCR1B == (_BV(WGM13)|_BV(WGM12)|_BV(CS12)|_BV(CS11)|_BV(CS10)));
+  TEST_CHECK(TIMSK1 == _BV(OCIE1B));
+  TIMER1_COMPB_vect();
+  TEST_CHECK(0 == pls_get_busy());
+  TEST_CHECK(0 == test_t1_clock());
+
+  /*开放触发后更新参数：模式14下OCR1A双缓冲，新的延时须在一般模式写入*/
+  pls_set_pulse(20000UL,5000UL);
+  pls_set_param();
+  pls_arm();
+  pls_set_pulse(10000UL,4000UL);
+  test_fall();
+  TEST_CHECK(sim_ocr1a_cmp() == 10000U);
+  TEST_CHECK(ICR1 == 13999U);
+  TEST_CHECK(TCCR1A == (_BV(COM1A1)|_BV(COM1A0)|_BV(WGM11)));
+  TIMER1_COMPB_vect();
+
+  /*延时加脉宽超过16位时改用0.2ms时基*/
+  pls_set_pulse(62000UL,8000UL);
+  pls_set_param();
+  TEST_CHECK(OCR0A == 199U);
+  TEST_CHECK(OCR1A == 31000U);
+  TEST_CHECK(ICR1 == 34999U);
+}
+
+/**
+ *@brief 毛刺、分频和抑制期
+ */
+static void test_qualify(void)
+{
+  uint8_t div;
+  uint16_t holdoff;
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(5000UL,4000UL);
+  pls_set_param();
+  pls_arm();
+
+  /*下降沿触发后仍为高电平，视为毛刺*/
+  test_trig_level(1U);
+  INT0_vect();
+  TEST_CHECK(0 == pls_get_busy());
+
+  /*每3次触发产生一个脉冲*/
+  pls_set_trig(PLS_EDGE_FALL,3U,0);
+  TEST_CHECK(EICRA == _BV(ISC01));
+  test_fall();
+  test_fall();
+  TEST_CHECK(0 == pls_get_busy());
+  test_fall();
+  TEST_CHECK(0 != pls_get_busy());
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+  TEST_CHECK(0 == pls_get_busy());
+
+  /*上升沿触发*/
+  pls_set_trig(PLS_EDGE_RISE,1U,0);
+  TEST_CHECK(EICRA == (_BV(ISC01)|_BV(ISC00)));
+  pls_set_trig(PLS_EDGE_BOTH,0,7U);
+  TEST_CHECK(EICRA == _BV(ISC00));
+  TEST_CHECK(PLS_EDGE_BOTH == pls_get_trig(&div,&holdoff));
+  TEST_CHECK(1U == div);
+  TEST_CHECK(7U == holdoff);
+
+  /*抑制10ms，即5个定时器2比较匹配B周期，期间的触发只计数*/
+  pls_set_trig(PLS_EDGE_FALL,1U,10U);
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+  TEST_CHECK(0 != (TIMSK2 & _BV(OCIE2B)));
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  TEST_CHECK(0 == pls_get_busy());
+  TEST_CHECK(1U == pls_get_ignored());
+  TIMER2_COMPB_vect();
+  TIMER2_COMPB_vect();
+  TIMER2_COMPB_vect();
+  TIMER2_COMPB_vect();
+  TIMER2_COMPB_vect();
+  TEST_CHECK(0 == (TIMSK2 & _BV(OCIE2B)));
+  test_fall();
+  TEST_CHECK(0 != pls_get_busy());
+  TEST_CHECK(1U == pls_get_ignored());
+}
+
+/**
+ *@brief 程序要求的单次内部触发不改变内部触发的设置
+ */
+static void test_emit(void)
+{
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(5000UL,4000UL);
+  pls_set_itrig(1000U,3U);
+  pls_set_param();
+  pls_emit();
+  TIMER2_COMPB_vect();
+  TEST_CHECK(0 == pls_get_busy());
+  pls_arm();
+  pls_emit();
+  TIMER2_COMPB_vect();
+  TEST_CHECK(0 != pls_get_busy());
+  TEST_CHECK(3U == pls_get_itrig());
+  TEST_CHECK(0 != (TIMSK2 & _BV(OCIE2B)));
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+  pls_set_itrig(0,0);
+  pls_set_param();
+  pls_arm();
+  pls_emit();
+  TEST_CHECK(0 != pls_disarm());
+  TIMER2_COMPB_vect();
+  TEST_CHECK(0 == pls_get_busy());
+  TEST_CHECK(0 == (TIMSK2 & _BV(OCIE2B)));
+}
+
+/**
+ *@brief 溢出触发的丢弃、排队和重新开始
+ */
+static void test_overrun(void)
+{
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(5000UL,4000UL);
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  test_fall();
+  TEST_CHECK(1U == pls_get_overrun());
+  TEST_CHECK(1U == pls_get_dropped());
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+
+  /*排队：脉冲期间的触发在下一次开放触发时立即产生*/
+  pls_set_ovr(PLS_OVR_QUEUE);
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  test_fall();
+  TEST_CHECK(1U == pls_get_queued());
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+  TEST_CHECK(0 == pls_get_busy());
+  pls_set_param();
+  pls_arm();
+  TEST_CHECK(0 != pls_get_busy());
+  TEST_CHECK(0 == pls_get_queued());
+  TEST_CHECK(0 != test_t1_clock());
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+
+  /*重新开始：脉宽态的触发使脉冲回到延时态*/
+  pls_set_ovr(PLS_OVR_RESTART);
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  TIMER1_COMPA_vect();
+  TEST_CHECK(PULSE_STA_WIDTH == pls_get_sta());
+  test_fall();
+  TEST_CHECK(PULSE_STA_DELAY == pls_get_sta());
+  TEST_CHECK(OCR1A == 5000U);
+  TEST_CHECK(TCNT1 == 0);
+  TEST_CHECK(0 != test_t1_clock());
+}
+
+/**
+ *@brief 响应测量：脉宽边沿后改为输入捕获，捕获或窗口结束时脉冲完成
+ */
+static void test_echo(void)
+{
+  uint32_t us = 0;
+  test_reset();
+  pls_set_mode(1U);
+  pls_set_pulse(5000UL,4000UL);
+  pls_set_echo(PLS_EDGE_RISE,100U);
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+#if (ECHO_MUX != ECHO_MUX_NONE)
+  TEST_CHECK(PULSE_STA_ECHO == pls_get_sta());
+  TEST_CHECK(TIMSK1 == (_BV(ICIE1)|_BV(OCIE1B)));
+  TEST_CHECK(TCCR1A == 0);
+  TEST_CHECK(0 != pls_get_busy());
+  ICR1 = 1000U;
+  TIMER1_CAPT_vect();
+  TEST_CHECK(0 == pls_get_busy());
+  TEST_CHECK(PLS_ECHO_GOT == pls_get_echo(&us));
+  TEST_CHECK(0 != us);
+
+  pls_set_param();
+  pls_arm();
+  test_fall();
+  TIMER1_COMPA_vect();
+  TIMER1_COMPA_vect();
+  TIMER1_COMPB_vect();
+  TEST_CHECK(PLS_ECHO_TIMEOUT == pls_get_echo(&us));
+#else
+  TEST_CHECK(PULSE_STA_COMPLETE == pls_get_sta());
+  (void)us;
+#endif
+  TEST_CHECK(0 == pls_get_busy());
+}
+
+/**
+ *@brief 运行参数保存任务若干节拍
+ *@param n 节拍数
+ */
+static void test_cfg_ticks(unsigned n)
+{
+  while(0 != n)
+  {
+    cfg_task(SCHED_EV_TICK);
+    n--;
+  }
+}
+
+/**
+ *@brief 取最新的有效参数记录
+ *@param[out] rec 记录
+ *@return 有效记录数
+ */
+static unsigned test_cfg_latest(scfg_t *rec)
+{
+  unsigned i;
+  unsigned n = 0;
+  for(i = 0;i < CFG_SLOTS;i++)
+  {
+    if(CFG_VER == cfg_ring[i].ver)
+    {
+      if((0 == n) || ((int8_t)(cfg_ring[i].seq - rec->seq) > 0))
+      {
+        *rec = cfg_ring[i];
+      }
+      n++;
+    }
+  }
+  return n;
+}
+
+/**
+ *@brief 参数保存：写入期间的请求不丢失，只有下标变化时推迟写入
+ */
+static void test_cfg(void)
+{
+  scfg_t rec;
+  unsigned n;
+  unsigned i;
+  uint8_t div;
+  uint16_t holdoff;
+  test_reset();
+  memset(cfg_ring,0xff,sizeof(scfg_t) * CFG_SLOTS);
+  (void)cfg_init();
+
+  /*改为手动模式后立即写入；写入期间改变参数再请求，写完后接着写入*/
+  pls_set_mode(1U);
+  cfg_save();
+  test_cfg_ticks(2U);
+  pls_set_pulse(30000UL,7000UL);
+  cfg_save();
+  test_cfg_ticks(sizeof(scfg_t) * 3U);
+  n = test_cfg_latest(&rec);
+  TEST_CHECK(2U == n);
+  TEST_CHECK(1U == rec.mode);
+  TEST_CHECK(30000UL == rec.delay);
+  TEST_CHECK(7000U == rec.width);
+
+  /*自动模式每次开放触发下标加1，只有下标变化时不写入，空闲后写一条*/
+  pls_set_mode(0);
+  cfg_save();
+  test_cfg_ticks(sizeof(scfg_t) * 2U);
+  n = test_cfg_latest(&rec);
+  for(i = 0;i < 50U;i++)
+  {
+    pls_set_param();
+    cfg_save();
+    test_cfg_ticks(1U);
+  }
+  TEST_CHECK(n == test_cfg_latest(&rec));
+  test_cfg_ticks(CFG_IDLE_TICKS + sizeof(scfg_t) * 2U);
+  TEST_CHECK((n + 1U) == test_cfg_latest(&rec));
+  TEST_CHECK(pls_get_index() == rec.index);
+  TEST_CHECK(0 == rec.mode);
+
+  /*触发条件立即写入*/
+  pls_set_trig(PLS_EDGE_RISE,4U,50U);
+  cfg_save();
+  test_cfg_ticks(sizeof(scfg_t) * 2U);
+  TEST_CHECK((n + 2U) == test_cfg_latest(&rec));
+  TEST_CHECK(PLS_EDGE_RISE == rec.edge);
+  TEST_CHECK(4U == rec.div);
+  TEST_CHECK(50U == rec.holdoff);
+
+  /*上电恢复*/
+  pls_init();
+  (void)cfg_init();
+  TEST_CHECK(rec.index == pls_get_index());
+  TEST_CHECK(0 == pls_get_mode());
+  TEST_CHECK(PLS_EDGE_RISE == pls_get_trig(&div,&holdoff));
+  TEST_CHECK(4U == div);
+  TEST_CHECK(50U == holdoff);
+}
+
+/**
+ *@brief 五位数显示：各位编码，最高位带小数点
+ */
+static void test_disp(void)
+{
+  disp_play(98765UL);
+  TEST_CHECK(disp_buf[4] == (digitcode[9] | DPOINT));
+  TEST_CHECK(disp_buf[3] == digitcode[8]);
+  TEST_CHECK(disp_buf[0] == digitcode[5]);
+  disp_play(7UL);
+  TEST_CHECK(disp_buf[4] == (digitcode[0] | DPOINT));
+  TEST_CHECK(disp_buf[1] == digitcode[0]);
+  TEST_CHECK(disp_buf[0] == digitcode[7]);
+}
+
+/**
+ *@brief 运行全部测试
+ *@return 0全部通过，1有失败
+ */
+/**
+ *@brief 多机方式接收一个字节
+ *@param ch 接收的字节
+ */
+static void test_uart_rx(uint8_t ch)
+{
+  UDR = ch;
+  USART_RX_vect();
+}
+
+/**
+ *@brief 多机方式取消选中：丢弃发送队列，正在发送的字符发送完后关闭发送器
+ */
+static void test_uart_deselect(void)
+{
+  memset((void *)sim_sfr,0,sizeof(sim_sfr));
+  uart_set_addr(3U);
+  uart_init(9600UL);
+  test_uart_rx(UART_ADDR_MARK);
+  test_uart_rx(3U);
+  TEST_CHECK(0 != (UCSRB & _BV(TXEN)));
+  uart_send('a');
+  uart_send('b');
+  USART_UDRE_vect();
+  TEST_CHECK('a' == UDR);
+  TEST_CHECK(0 != (UCSRB & _BV(TXCIE)));
+  test_uart_rx(UART_ADDR_MARK);
+  test_uart_rx(5U);
+  USART_UDRE_vect();
+  TEST_CHECK(5U == UDR);/*仿真的UDR收发共用，未写入'b'*/
+  TEST_CHECK(0 == (UCSRB & _BV(UDRIE)));
+  TEST_CHECK(0 != (UCSRB & _BV(TXEN)));
+  USART_TX_vect();
+  TEST_CHECK(0 == (UCSRB & (_BV(TXEN)|_BV(TXCIE))));
+  uart_send('c');
+  TEST_CHECK(0 == (UCSRB & _BV(UDRIE)));
+  test_uart_rx(UART_ADDR_MARK);
+  test_uart_rx(3U);
+  uart_send('d');
+  USART_UDRE_vect();
+  TEST_CHECK('d' == UDR);
+  uart_set_addr(0);
+}
+
+int main(void)
+{
+  test_init();
+  test_isr_pulse();
+  test_long_delay();
+  test_hw_pulse();
+  test_qualify();
+  test_emit();
+  test_overrun();
+  test_echo();
+  test_cfg();
+  test_disp();
+  test_uart_deselect();
+  printf("%u checks, %u failed\n",test_total,test_failed);
+  return (0 == test_failed) ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/**
+ * @brief simavr仿真波形记录
+ * @file host/trace.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 在simavr中按脚本运行pulse.elf，把PB1（脉冲）、PB5（指示灯）、PD6（时基输出）、PD2（触发）及
+ * 段端口PC0～PC5、PD3、PD4记录为VCD文件，用于对比优化前后的输出波形。脚本：\n
+ * - auto 自动模式，每次开放触发后触发一次，完成一轮20组参数\n
+ * - manual 进入手动模式，输入延时、脉宽后触发一次\n
+ * - busy 延时期间及脉宽期间各再触发一次\n
+ * 用法：trace pulse.elf 脚本名 输出.vcd\n
+ * 记录与host/golden下的基准由host/vcdcmp.awk比较，见Makefile的trace-check目标
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_vcd_file.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+#define TRACE_FCPU      16000000UL /**<CPU时钟*/
+#define TRACE_MS        (TRACE_FCPU / 1000U) /**<1ms对应的周期数*/
+#define TRACE_TRIG_LOW  1600U      /**<触发低电平保持时间，100us*/
+#define TRACE_TIMEOUT   (200U * TRACE_FCPU) /**<仿真时间上限，200s*/
+
+#define STEP_END        0U /**<脚本结束*/
+#define STEP_WAIT_MS    1U /**<等待arg毫秒*/
+#define STEP_WAIT_TEXT  2U /**<等待串口输出包含str的一行*/
+#define STEP_WAIT_PULSE 3U /**<等待脉冲结束（PB1下降沿）*/
+#define STEP_TRIG       4U /**<PD2输出一个触发*/
+#define STEP_SEND       5U /**<从串口输入str*/
+#define STEP_REPEAT     6U /**<从第一步重复，共arg次*/
+
+/**
+ * @brief 脚本步骤
+ */
+typedef struct trace_step
+{
+  uint8_t kind;    /**<步骤类型*/
+  uint32_t arg;    /**<参数*/
+  const char *str; /**<字符串参数*/
+}sstep_t;
+
+/**
+ * @brief 脚本
+ */
+typedef struct trace_script
+{
+  const char *name;     /**<脚本名*/
+  const sstep_t *steps; /**<步骤*/
+}sscript_t;
+
+static const sstep_t trace_auto[] =
+{
+  {STEP_WAIT_TEXT,0,"Start generate"},
+  {STEP_WAIT_MS,50U,NULL},
+  {STEP_TRIG,0,NULL},
+  {STEP_WAIT_PULSE,0,NULL},
+  {STEP_REPEAT,20U,NULL},
+  {STEP_END,0,NULL}
+};
+
+static const sstep_t trace_manual[] =
+{
+  {STEP_WAIT_TEXT,0,"Start generate"},
+  {STEP_SEND,0,"m"},
+  {STEP_WAIT_TEXT,0,"Delay"},
+  {STEP_SEND,0,"5000\r"},
+  {STEP_WAIT_TEXT,0,"Width"},
+  {STEP_SEND,0,"4000\r"},
+  {STEP_WAIT_TEXT,0,"Start generate"},
+  {STEP_WAIT_MS,50U,NULL},
+  {STEP_TRIG,0,NULL},
+  {STEP_WAIT_PULSE,0,NULL},
+  {STEP_WAIT_MS,1500U,NULL},
+  {STEP_END,0,NULL}
+};
+
+static const sstep_t trace_busy[] =
+{
+  {STEP_WAIT_TEXT,0,"Start generate"},
+  {STEP_WAIT_MS,50U,NULL},
+  {STEP_TRIG,0,NULL},
+  {STEP_WAIT_MS,100U,NULL},
+  {STEP_TRIG,0,NULL},
+  {STEP_WAIT_MS,600U,NULL},
+  {STEP_TRIG,0,NULL},
+  {STEP_WAIT_PULSE,0,NULL},
+  {STEP_WAIT_MS,1500U,NULL},
+  {STEP_END,0,NULL}
+};
+
+static const sscript_t trace_scripts[] =
+{
+  {"auto",trace_auto},
+  {"manual",trace_manual},
+  {"busy",trace_busy},
+  {NULL,NULL}
+};
+
+static avr_t *trace_avr;
+static avr_irq_t *trace_trig_irq;  /*PD2，触发输入*/
+static avr_irq_t *trace_rx_irq;    /*串口输入*/
+static char trace_line[64];        /*串口接收行*/
+static uint32_t trace_linelen;
+static int trace_text;             /*等待的字符串已出现*/
+static const char *trace_want;     /*等待的字符串*/
+static int trace_pulse;            /*脉冲已结束*/
+
+/**
+ *@brief 触发线恢复高电平
+ */
+static avr_cycle_count_t trace_trig_release(avr_t *avr,avr_cycle_count_t when,void *param)
+{
+  avr_raise_irq(trace_trig_irq,1);
+  return 0;
+}
+
+/**
+ *@brief 串口输出，按行匹配等待的字符串
+ */
+static void trace_uart(avr_irq_t *irq,uint32_t value,void *param)
+{
+  char ch = (char)value;
+  if(('\n' == ch) || ('\r' == ch) || (trace_linelen >= (sizeof(trace_line) - 1U)))
+  {
+    trace_line[trace_linelen] = '\0';
+    trace_linelen = 0;
+  }
+  else
+  {
+    trace_line[trace_linelen++] = ch;
+    trace_line[trace_linelen] = '\0';
+  }
+  /*提示行不以换行结束，边收边比较*/
+  if((NULL != trace_want) && (NULL != strstr(trace_line,trace_want)))
+  {
+    trace_text = 1;
+    trace_want = NULL;
+  }
+}
+
+/**
+ *@brief 脉冲输出PB1下降沿
+ */
+static void trace_pb1(avr_irq_t *irq,uint32_t value,void *param)
+{
+  if(0 == value)
+  {
+    trace_pulse = 1;
+  }
+}
+
+/**
+ *@brief 加入一个端口管脚信号
+ */
+static void trace_pin(avr_vcd_t *vcd,char port,int pin,const char *name)
+{
+  avr_vcd_add_signal(vcd,avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ(port),pin),1,name);
+}
+
+int main(int argc,char *argv[])
+{
+  elf_firmware_t fw;
+  avr_vcd_t vcd;
+  const sstep_t *steps = NULL;
+  const sstep_t *st;
+  uint32_t flags = 0;
+  uint32_t i = 0;
+  uint32_t rep = 0;
+  avr_cycle_count_t until = 0;
+  int busy = 0;
+  int state = cpu_Running;
+  const char *p;
+
+  if(argc < 4)
+  {
+    fprintf(stderr,"usage: %s pulse.elf auto|manual|busy out.vcd\n",argv[0]);
+    return 2;
+  }
+  for(i = 0;NULL != trace_scripts[i].name;i++)
+  {
+    if(0 == strcmp(argv[2],trace_scripts[i].name))
+    {
+      steps = trace_scripts[i].steps;
+    }
+  }
+  if(NULL == steps)
+  {
+    fprintf(stderr,"unknown script %s\n",argv[2]);
+    return 2;
+  }
+
+  memset(&fw,0,sizeof(fw));
+  if(0 != elf_read_firmware(argv[1],&fw))
+  {
+    fprintf(stderr,"cannot read %s\n",argv[1]);
+    return 1;
+  }
+  trace_avr = avr_make_mcu_by_name("atmega328p");
+  if(NULL == trace_avr)
+  {
+    fprintf(stderr,"simavr has no atmega328p core\n");
+    return 1;
+  }
+  avr_init(trace_avr);
+  avr_load_firmware(trace_avr,&fw);
+  trace_avr->frequency = TRACE_FCPU;
+
+  avr_ioctl(trace_avr,AVR_IOCTL_UART_GET_FLAGS('0'),&flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(trace_avr,AVR_IOCTL_UART_SET_FLAGS('0'),&flags);
+  avr_irq_register_notify(avr_io_getirq(trace_avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_OUTPUT),
+                          trace_uart,NULL);
+  trace_rx_irq = avr_io_getirq(trace_avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_INPUT);
+  avr_irq_register_notify(avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ('B'),1),trace_pb1,NULL);
+  trace_trig_irq = avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),2);
+  avr_raise_irq(trace_trig_irq,1);
+  /*板上OC0A（PD6）接T1（PD5），Timer1由时基计数*/
+  avr_connect_irq(avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),6),
+                  avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ('D'),5));
+
+  /*VCD记录，管脚变化时写入*/
+  avr_vcd_init(trace_avr,argv[3],&vcd,1000);
+  trace_pin(&vcd,'B',1,"PB1_pulse");
+  trace_pin(&vcd,'B',5,"PB5_led");
+  trace_pin(&vcd,'D',6,"PD6_clkout");
+  trace_pin(&vcd,'D',2,"PD2_trig");
+  avr_vcd_add_signal(&vcd,avr_io_getirq(trace_avr,AVR_IOCTL_IOPORT_GETIRQ('C'),IOPORT_IRQ_PIN_ALL),
+                     8,"PORTC_seg");
+  trace_pin(&vcd,'D',3,"PD3_seg_g");
+  trace_pin(&vcd,'D',4,"PD4_seg_dp");
+  avr_vcd_start(&vcd);
+
+  /*逐条执行脚本，等待条件满足后进入下一步*/
+  st = steps;
+  do
+  {
+    if(0 == busy)
+    {
+      busy = 1;
+      switch(st->kind)
+      {
+        case STEP_WAIT_MS:
+          until = trace_avr->cycle + (avr_cycle_count_t)st->arg * TRACE_MS;
+          break;
+        case STEP_WAIT_TEXT:
+          trace_text = 0;
+          trace_want = st->str;
+          break;
+        case STEP_WAIT_PULSE:
+          trace_pulse = 0;
+          break;
+        case STEP_TRIG:
+          avr_raise_irq(trace_trig_irq,0);
+          avr_cycle_timer_register(trace_avr,TRACE_TRIG_LOW,trace_trig_release,NULL);
+          busy = 0;
+          break;
+        case STEP_SEND:
+          for(p = st->str;'\0' != *p;p++)
+          {
+            avr_raise_irq(trace_rx_irq,(uint8_t)*p);
+          }
+          busy = 0;
+          break;
+        case STEP_REPEAT:
+          rep++;
+          busy = 0;
+          if(rep < st->arg)
+          {
+            st = steps;
+            continue;
+          }
+          break;
+        default:
+          break;
+      }
+      if(0 == busy)
+      {
+        st++;
+        continue;
+      }
+    }
+    else
+    {
+      if(((STEP_WAIT_MS == st->kind) && (trace_avr->cycle >= until))
+         || ((STEP_WAIT_TEXT == st->kind) && (0 != trace_text))
+         || ((STEP_WAIT_PULSE == st->kind) && (0 != trace_pulse)))
+      {
+        busy = 0;
+        st++;
+        continue;
+      }
+    }
+    state = avr_run(trace_avr);
+  }
+  while((STEP_END != st->kind) && (state != cpu_Done) && (state != cpu_Crashed)
+        && (trace_avr->cycle < TRACE_TIMEOUT));
+
+  avr_vcd_stop(&vcd);
+  if(STEP_END != st->kind)
+  {
+    fprintf(stderr,"%s: stopped at step %u\n",argv[2],(unsigned)(st - steps));
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,18 @@
+/**
+ * @brief 主机编译用原子操作头文件
+ * @file host/util/atomic.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<util/atomic.h>，ATOMIC_BLOCK内关仿真总中断，结束时恢复
+ */
+#ifndef SIM_UTIL_ATOMIC_H
+#define SIM_UTIL_ATOMIC_H
+#include <avr/io.h>
+
+#define ATOMIC_RESTORESTATE  uint8_t sim_sreg_save = SREG
+#define ATOMIC_FORCEON       uint8_t sim_sreg_save = (uint8_t)(SREG | 0x80U)
+#define ATOMIC_BLOCK(type) \
+  for(type, sim_once = (__builtin_avr_cli(), 1U); sim_once != 0; SREG = sim_sreg_save, sim_once = 0)
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @brief 主机编译用CRC头文件
+ * @file host/util/crc16.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<util/crc16.h>，按avr-libc文档给出的等效C代码实现
+ */
+#ifndef SIM_UTIL_CRC16_H
+#define SIM_UTIL_CRC16_H
+#include <stdint.h>
+
+/**
+ *@brief CRC-8-CCITT，多项式x^8+x^2+x+1，与avr-libc的_crc8_ccitt_update()相同
+ *@param crc 原校验值
+ *@param data 数据
+ *@return 新校验值
+ */
+static inline uint8_t _crc8_ccitt_update(uint8_t crc,uint8_t data)
+{
+  uint8_t i;
+  crc ^= data;
+  for(i = 0;i < 8U;i++)
+  {
+    if(0 != (crc & 0x80U))
+    {
+      crc = (uint8_t)((crc << 1) ^ 0x07U);
+    }
+    else
+    {
+      crc = (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+#endif
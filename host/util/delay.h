@@ -0,0 +1,15 @@
+/**
+ * @brief 主机编译用延时头文件
+ * @file host/util/delay.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 主机编译时代替avr-libc的<util/delay.h>，延时立即返回
+ */
+#ifndef SIM_UTIL_DELAY_H
+#define SIM_UTIL_DELAY_H
+
+#define _delay_ms(ms) ((void)(ms))
+#define _delay_us(us) ((void)(us))
+#endif
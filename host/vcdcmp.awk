@@ -0,0 +1,167 @@
+# @brief VCD波形与基准比较
+# @file host/vcdcmp.awk
+# @author shenxf 380406785@@qq.com
+# @version V1.2.0
+# @date 2016-10-24
+#
+# 用法：awk -f host/vcdcmp.awk -v tol=微秒 -v signals="名称 ..." -v absolute="名称 ..." 基准.vcd 记录.vcd
+# 按每次触发比较两个VCD文件中各信号的跳变：触发信号ref（缺省PD2_trig）的下降沿开始一次，
+# 脉冲信号pulse（缺省PB1_pulse）的下降沿结束一次，下一次从结束后的第一个触发下降沿开始。跳变
+# 时刻取相对本次开始的时间，第一次触发前的跳变（上电初始化）不比较；两次之间的跳变计入上一次，
+# 多出的脉冲会使跳变数不同。signals为空时比较基准文件中的全部信号。
+# absolute中的信号与触发无关（如定时器2刷新的显示段），按整个文件的绝对时刻比较，包括第一次
+# 触发前的跳变。每个信号要求跳变数相同，且逐个跳变的次序号、电平相同，时刻相差不超过tol微秒。
+# 两个文件的$timescale可以不同。有差异时退出码为1。
+
+# $timescale的单位换算为微秒
+function unit_us(u)
+{
+  if (u == "s")
+    return 1000000
+  if (u == "ms")
+    return 1000
+  if (u == "us")
+    return 1
+  if (u == "ns")
+    return 0.001
+  if (u == "ps")
+    return 0.000001
+  return 0.000000001
+}
+
+# 信号id在时刻t（微秒）变为值v
+function change(id, v,    s, k)
+{
+  if (!((f, id) in name))
+    return
+  s = name[f, id]
+  if ((f, s) in last && last[f, s] == v)
+    return
+  last[f, s] = v
+  if (s in abs) {
+    k = ++cnt[f, s]
+    eshot[f, s, k] = 0
+    etime[f, s, k] = t
+    eval[f, s, k] = v
+    return
+  }
+  if (s == ref && v == "0" && open[f] == 0) {
+    shot[f]++
+    start[f] = t
+    open[f] = 1
+  }
+  if (shot[f] == 0)
+    return
+  k = ++cnt[f, s]
+  eshot[f, s, k] = shot[f]
+  etime[f, s, k] = t - start[f]
+  eval[f, s, k] = v
+  if (s == pulse && v == "0")
+    open[f] = 0
+}
+
+BEGIN {
+  if (ref == "")
+    ref = "PD2_trig"
+  if (pulse == "")
+    pulse = "PB1_pulse"
+  if (tol == "")
+    tol = 5
+  n = split(absolute, item, " ")
+  for (i = 1; i <= n; i++)
+    abs[item[i]] = 1
+  f = 0
+}
+
+FNR == 1 {
+  f++
+  scale = 1
+  t = 0
+  shot[f] = 0
+  open[f] = 0
+  hdr = 1
+  skip = 0
+}
+
+# 头部：$timescale、$var，其余段（$comment等）跳过到$end
+hdr {
+  line = line " " $0
+  if ($0 !~ /\$end/ && $0 !~ /\$enddefinitions/)
+    next
+  n = split(line, w, " ")
+  line = ""
+  if (w[1] == "$timescale") {
+    ts = w[2] (w[3] == "$end" ? "" : w[3])
+    u = ts
+    sub(/^[0-9]+/, "", u)
+    scale = (ts + 0) * unit_us(u)
+  } else if (w[1] == "$var") {
+    name[f, w[4]] = w[5]
+    decl[f, w[5]] = 1
+    if (f == 1 && signals == "")
+      want[w[5]] = 1
+  } else if (w[1] == "$enddefinitions") {
+    hdr = 0
+  }
+  next
+}
+
+/^#[0-9]+/ {
+  t = substr($1, 2) * scale
+  next
+}
+
+/^[01xXzZ]/ {
+  change(substr($1, 2), substr($1, 1, 1))
+  next
+}
+
+/^[bBrR]/ {
+  change($2, substr($1, 2))
+  next
+}
+
+END {
+  if (f != 2) {
+    print "usage: awk -f vcdcmp.awk [-v tol=us] [-v signals=...] [-v absolute=...] golden.vcd trace.vcd"
+    exit 2
+  }
+  n = split(signals, item, " ")
+  for (i = 1; i <= n; i++)
+    want[item[i]] = 1
+  fail = 0
+  for (s in want) {
+    a = cnt[1, s] + 0
+    b = cnt[2, s] + 0
+    bad = 0
+    if (!((1, s) in decl) || !((2, s) in decl)) {
+      printf "%-12s not in %s\n", s, ((1, s) in decl) ? "trace" : "golden"
+      fail = 1
+      continue
+    }
+    m = (a < b) ? a : b
+    worst = 0
+    for (k = 1; k <= m; k++) {
+      d = etime[2, s, k] - etime[1, s, k]
+      if (d < 0)
+        d = -d
+      if (eshot[1, s, k] != eshot[2, s, k] || eval[1, s, k] != eval[2, s, k] || d > tol) {
+        printf "%-12s edge %d: golden shot %d %s at %.1fus, trace shot %d %s at %.1fus\n", s, k,
+               eshot[1, s, k], eval[1, s, k], etime[1, s, k], eshot[2, s, k], eval[2, s, k], etime[2, s, k]
+        bad = 1
+        break
+      }
+      if (d > worst)
+        worst = d
+    }
+    if (!bad && a != b) {
+      printf "%-12s %d edges in golden, %d in trace\n", s, a, b
+      bad = 1
+    }
+    if (bad)
+      fail = 1
+    else
+      printf "%-12s %5d edges  max error %7.1fus  tolerance %dus  ok\n", s, a, worst, tol
+  }
+  exit fail
+}
@@ -0,0 +1,119 @@
+/**
+ *@brief 开发板管脚描述头文件
+ *@file board.h
+ *@author shenxf 380406785@@qq.com
+ *@version V1.2.0
+ *@date	2016-10-24
+ *
+ *全部管脚分配集中在本文件，各模块的端口宏由此导出。管脚以“端口字母,位号”描述，BOARD_PORT() 等宏
+ *在编译时展开为常数寄存器和屏蔽码：单个管脚的置位、清零编译为一条sbi、cbi指令，同一端口的多个管脚
+ *由 BOARD_MASK() 合并为一次读改写，没有运行时开销。开发板由Makefile的BOARD选择（-DBOARD_NANO、
+ *-DBOARD_UNO、-DBOARD_PROMINI，缺省Nano），三种板的Arduino管脚编号与ATmega328P端口的对应相同，
+ *区别只在各板段内说明\n
+ *触发输入INT0、时基T1/OC0A、脉冲OC1A及SPI的管脚由硬件决定，不能移动，改动时编译报错；可以移动的是
+ *指示灯、数位选择和g、dp段，移动时只改本文件的一行\n
+ *宏列表：\n
+ * @sa BOARD_PORT 输出寄存器
+ * @sa BOARD_DDR 方向寄存器
+ * @sa BOARD_PINR 输入寄存器
+ * @sa BOARD_BIT 位号
+ * @sa BOARD_ID 端口编号
+ * @sa BOARD_MASK 管脚在某一端口上的屏蔽码
+ * @sa BOARD_SET 输出置1
+ * @sa BOARD_CLR 输出清0
+ * @sa BOARD_READ 读输入
+*/
+#ifndef BOARD_H
+#define BOARD_H
+#include <avr/io.h>
+
+#define BOARD_ID_B 1 /**<PB口编号*/
+#define BOARD_ID_C 2 /**<PC口编号*/
+#define BOARD_ID_D 3 /**<PD口编号*/
+
+/*管脚分配，端口字母,位号*/
+#define BOARD_TRIG     D,2 /**<触发输入，INT0，D2*/
+#define BOARD_SEG_G    D,3 /**<g段，D3*/
+#define BOARD_SEG_DP   D,4 /**<dp段，D4，须与g段在同一端口的下一位*/
+#define BOARD_CLKIN    D,5 /**<时基输入，T1，D5*/
+#define BOARD_CLKOUT   D,6 /**<时基输出，OC0A，D6*/
+#define BOARD_DIGIT4   D,7 /**<DS4第五位选，D7*/
+#define BOARD_DIGIT3   B,0 /**<DS3第四位选，D8*/
+#define BOARD_PULSE    B,1 /**<脉冲输出，OC1A，D9*/
+#define BOARD_DIGIT2   B,2 /**<DS2第三位选，D10*/
+#define BOARD_DIGIT1   B,3 /**<DS1第二位选，D11*/
+#define BOARD_DIGIT0   B,4 /**<DS0第一位选，D12*/
+#define BOARD_LED      B,5 /**<指示灯，D13*/
+#define BOARD_SEG_A    C,0 /**<a～f段，PC0～PC5，A0～A5，整个端口写入*/
+#define BOARD_SPI_LOAD B,2 /**<MAX7219 LOAD（CS），SS，D10，DISPLAY=max7219时代替位选*/
+#define BOARD_SPI_MOSI B,3 /**<MAX7219 DIN，MOSI，D11*/
+#define BOARD_SPI_SCK  B,5 /**<MAX7219 CLK，SCK，D13，与指示灯共用*/
+
+#if defined(BOARD_UNO)
+/*Arduino UNO：DIP封装的ATmega328P没有ADC6、ADC7，A0～A5为a～f段，没有响应输入*/
+#define BOARD_NAME     "uno"
+#elif defined(BOARD_PROMINI)
+/*Arduino Pro Mini（5V，16MHz）：与Nano相同，A7在板边的焊盘上*/
+#define BOARD_NAME     "promini"
+#define BOARD_ECHO_MUX 7U /**<响应输入，ADC7，A7*/
+#else
+/*Arduino Nano（缺省）*/
+#define BOARD_NAME     "nano"
+#define BOARD_ECHO_MUX 7U /**<响应输入，ADC7，A7*/
+#endif
+
+#define BOARD_PORT_(p,b)   PORT##p
+#define BOARD_DDR_(p,b)    DDR##p
+#define BOARD_PINR_(p,b)   PIN##p
+#define BOARD_BIT_(p,b)    b
+#define BOARD_ID_(p,b)     BOARD_ID_##p
+#define BOARD_MASK_(id,p,b) ((BOARD_ID_##p == (id)) ? (1U << (b)) : 0U)
+#define BOARD_SET_(p,b)    (PORT##p |= (uint8_t)_BV(b))
+#define BOARD_CLR_(p,b)    (PORT##p &= (uint8_t)~_BV(b))
+#define BOARD_READ_(p,b)   (PIN##p & _BV(b))
+
+#define BOARD_PORT(pin) BOARD_PORT_(pin) /**<管脚的输出寄存器*/
+#define BOARD_DDR(pin)  BOARD_DDR_(pin)  /**<管脚的方向寄存器*/
+#define BOARD_PINR(pin) BOARD_PINR_(pin) /**<管脚的输入寄存器*/
+#define BOARD_BIT(pin)  BOARD_BIT_(pin)  /**<管脚的位号*/
+#define BOARD_ID(pin)   BOARD_ID_(pin)   /**<管脚的端口编号，可用于#if*/
+
+/**
+ *@brief 管脚在某一端口上的屏蔽码，不在该端口时为0；常数表达式，可用于#if
+ *@param pin 管脚
+ *@param id 端口编号， @ref BOARD_ID_B 等
+ */
+#define BOARD_MASK(pin,id) BOARD_MASK_(id,pin)
+
+#define BOARD_SET(pin)  BOARD_SET_(pin)  /**<输出置1，sbi*/
+#define BOARD_CLR(pin)  BOARD_CLR_(pin)  /**<输出清0，cbi*/
+#define BOARD_READ(pin) BOARD_READ_(pin) /**<读输入，sbis/sbic*/
+
+/*硬件决定的管脚*/
+#if (BOARD_ID(BOARD_TRIG) != BOARD_ID_D) || (BOARD_BIT(BOARD_TRIG) != 2)
+#error "BOARD_TRIG must be INT0 (PD2)"
+#endif
+#if (BOARD_ID(BOARD_CLKIN) != BOARD_ID_D) || (BOARD_BIT(BOARD_CLKIN) != 5)
+#error "BOARD_CLKIN must be T1 (PD5)"
+#endif
+#if (BOARD_ID(BOARD_CLKOUT) != BOARD_ID_D) || (BOARD_BIT(BOARD_CLKOUT) != 6)
+#error "BOARD_CLKOUT must be OC0A (PD6)"
+#endif
+#if (BOARD_ID(BOARD_PULSE) != BOARD_ID_B) || (BOARD_BIT(BOARD_PULSE) != 1)
+#error "BOARD_PULSE must be OC1A (PB1)"
+#endif
+#if (BOARD_ID(BOARD_SPI_LOAD) != BOARD_ID_B) || (BOARD_BIT(BOARD_SPI_LOAD) != 2) || \
+    (BOARD_ID(BOARD_SPI_MOSI) != BOARD_ID_B) || (BOARD_BIT(BOARD_SPI_MOSI) != 3) || \
+    (BOARD_ID(BOARD_SPI_SCK) != BOARD_ID_B) || (BOARD_BIT(BOARD_SPI_SCK) != 5)
+#error "BOARD_SPI_* must be SS/MOSI/SCK (PB2/PB3/PB5)"
+#endif
+
+/*显示段的约束，见disp_mux.c*/
+#if (BOARD_ID(BOARD_SEG_A) != BOARD_ID_C) || (BOARD_BIT(BOARD_SEG_A) != 0)
+#error "segments a-f must be PC0-PC5"
+#endif
+#if (BOARD_ID(BOARD_SEG_DP) != BOARD_ID(BOARD_SEG_G)) || (BOARD_BIT(BOARD_SEG_DP) != (BOARD_BIT(BOARD_SEG_G) + 1)) || \
+    (BOARD_ID(BOARD_SEG_G) == BOARD_ID_C)
+#error "segment dp must follow segment g on the same port (not PC)"
+#endif
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @brief 参数掉电保存模块头文件
+ * @file cfg.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 工作模式、自动模式数组下标、手动时间参数、串口地址、同步角色和触发条件保存在EEPROM循环记录区，均衡磨损\n
+ * 函数列表：
+ *@sa cfg_init() 初始化，恢复参数
+ *@sa cfg_save() 请求保存参数
+ *@sa cfg_task() 逐字节写入EEPROM
+ *@sa cfg_recall() 恢复手动时间参数
+ */
+#ifndef CFG_H
+#define CFG_H
+#include <stdint.h>
+
+#define CFG_VER    0x03U /**<参数记录版本，记录结构改变时加1*/
+#define CFG_SLOTS  32U   /**<循环记录区记录数*/
+#define CFG_IDLE_TICKS 1000U /**<只有自动模式数组下标变化时推迟写入的节拍数，约10s*/
+
+/**
+ * @brief   参数记录结构类型
+ * @struct  scfg_t
+ */
+typedef struct cfg_data
+{
+  uint8_t ver;     /**<版本，@ref CFG_VER*/
+  uint8_t seq;     /**<序号，每写一条记录加1，序号最新的有效记录为当前参数*/
+  uint8_t mode;    /**<工作模式*/
+  uint8_t index;   /**<自动模式数组下标*/
+  uint32_t delay;  /**<手动模式延时数，单位0.1ms*/
+  uint16_t width;  /**<手动模式脉宽数，单位0.1ms*/
+  uint8_t addr;    /**<串口地址，0单机方式*/
+  uint8_t sync;    /**<同步角色*/
+  uint8_t edge;    /**<触发沿*/
+  uint8_t div;     /**<触发分频数*/
+  uint16_t holdoff;/**<触发抑制时间，ms*/
+  uint8_t crc;     /**<以上各字节的CRC-8校验*/
+}scfg_t;
+
+uint8_t cfg_init(void);
+void cfg_save(void);
+void cfg_task(uint8_t ev);
+void cfg_recall(void);
+#endif
@@ -11,41 +11,63 @@
  * @sa disp_play 将数传递至显示缓冲区
  * @sa disp_fill 填充字段码
  * @sa disp_filln 指定数位填充
+ * @sa disp_puts 显示字符串，超出5位时滚动显示
+ * @sa disp_play_pair 交替显示两个时间参数
+ * @sa disp_fmt 时间参数格式化为字符串
+ * @sa disp_overlay 限时叠加显示
+ * @sa disp_task 显示后端节拍任务
 */
 #ifndef DISP_H
 #define DISP_H
 #include <avr/io.h>
+#include "board.h"
 
-#define SEGC_PORT PORTC /**<a~f段，PC口*/
-#define SEGC_DDR  DDRC /**<PC口方向*/
-#define SEGD_PORT PORTD /**<g、dp段，PD口*/
-#define SEGD_DDR  DDRD  /**<PD口方向*/
-#define SEGD_PIN6 3     /**<g段管脚*/
-#define SEGD_PIN7 4     /**<dp段管脚*/
+#define SEGC_PORT BOARD_PORT(BOARD_SEG_A) /**<a~f段端口，整个端口写入*/
+#define SEGC_DDR  BOARD_DDR(BOARD_SEG_A)  /**<a~f段端口方向*/
+#define SEGD_PORT BOARD_PORT(BOARD_SEG_G) /**<g、dp段端口*/
+#define SEGD_DDR  BOARD_DDR(BOARD_SEG_G)  /**<g、dp段端口方向*/
+#define SEGD_PIN6 BOARD_BIT(BOARD_SEG_G)  /**<g段管脚*/
+#define SEGD_PIN7 BOARD_BIT(BOARD_SEG_DP) /**<dp段管脚*/
+#define SEGD_MASK (_BV(SEGD_PIN6)|_BV(SEGD_PIN7)) /**<g、dp段屏蔽码*/
 
-#define DIGIT4_PORT   PORTD	/**<DS4第五位选端口，PD口*/
-#define DIGIT4_DDR    DDRD	/**<DS4第五位选端口方向*/
-#define DIGIT3_PORT   PORTB /**<DS3第四位选端口,PB口*/
-#define DIGIT3_DDR    DDRB /**<DS3第四位选端口方向*/
-#define DIGIT2_PORT   PORTB /**<DS2第三选端口,PB口*/
-#define DIGIT2_DDR    DDRB /**<DS2第三位选端口方向*/
-#define DIGIT1_PORT   PORTB /**<DS1第二位选端口，PB口*/
-#define DIGIT1_DDR    DDRB /**<DS1第二位选端口方向*/
-#define DIGIT0_PORT   PORTB /**<DS0第一位选端口，PB口*/
-#define DIGIT0_DDR    DDRB /**<DS0第一位选端口方向*/
-#define DIGIT_PIN4    7 /**<DS4第五位选端口管脚，PD7*/
-#define DIGIT_PIN3    0 /**<DS3第四位选端口管脚，PB0*/
-#define DIGIT_PIN2    2 /**<DS2第三位选端口管脚，PB2*/
-#define DIGIT_PIN1    3 /**<DS1第二位选端口管脚，PB3*/
-#define DIGIT_PIN0    4 /**<DS0第一位选端口管脚，PB4*/
+/**
+ *@brief 位选在某一端口上的屏蔽码，由board.h的管脚分配在编译时算出
+ *@param id 端口编号， @ref BOARD_ID_B 等
+ */
+#define DIGIT_MASK(id) (BOARD_MASK(BOARD_DIGIT0,id)|BOARD_MASK(BOARD_DIGIT1,id)|BOARD_MASK(BOARD_DIGIT2,id)| \
+                        BOARD_MASK(BOARD_DIGIT3,id)|BOARD_MASK(BOARD_DIGIT4,id))
+#define DIGIT_MASK_B DIGIT_MASK(BOARD_ID_B) /**<PB口上的位选*/
+#define DIGIT_MASK_D DIGIT_MASK(BOARD_ID_D) /**<PD口上的位选*/
+#define DIGIT_SEGD   DIGIT_MASK(BOARD_ID(BOARD_SEG_G)) /**<与g、dp段同端口的位选*/
+#if 0 != DIGIT_MASK(BOARD_ID_C)
+#error "digit selects cannot share PORTC with segments a-f"
+#endif
+
+#define DISP_SPI_PORT BOARD_PORT(BOARD_SPI_LOAD) /**<MAX7219后端SPI端口*/
+#define DISP_SPI_DDR  BOARD_DDR(BOARD_SPI_LOAD)  /**<MAX7219后端SPI端口方向*/
+#define DISP_SPI_LOAD BOARD_BIT(BOARD_SPI_LOAD)  /**<MAX7219 LOAD（CS），SS脚*/
+#define DISP_SPI_MOSI BOARD_BIT(BOARD_SPI_MOSI)  /**<MAX7219 DIN，MOSI脚*/
+#define DISP_SPI_SCK  BOARD_BIT(BOARD_SPI_SCK)   /**<MAX7219 CLK，SCK脚，与指示灯共用*/
+#define DISP_INTENSITY 0x08U /**<MAX7219亮度，0～15*/
 
 #define DPOINT 0x80U  /**<dp小数点段编码权值*/
 
+#define DISP_LINE_MAX    24U /**<长行显示缓冲区字符数*/
+#define DISP_MODE_SCROLL 0x00U /**<长行逐位滚动显示*/
+#define DISP_MODE_PAGE   0x01U /**<长行按5位分页显示*/
+#define DISP_SCROLL_STEP 30U /**<滚动步进时间，单位10ms刷新帧*/
+#define DISP_PAGE_STEP   50U /**<翻页时间，单位10ms刷新帧*/
+
 void disp_init(void);
 void disp_on(void);
 void disp_off(void);
 void disp_play(uint32_t num);
 void disp_fill(uint8_t segs);
 void disp_filln(uint8_t segs,uint8_t digit);
+void disp_puts(const char str[]);
+void disp_play_pair(uint32_t dly,uint32_t wtd);
+uint8_t disp_fmt(uint32_t num,char str[]);
+void disp_overlay(const char str[],uint8_t frames);
+void disp_task(uint8_t ev);
 
 #endif
@@ -0,0 +1,115 @@
+/**
+ *@brief 数码管显示后端接口头文件
+ *@file disp_hw.h
+ *@author shenxf 380406785@@qq.com
+ *@version V1.2.0
+ *@date	2016-10-24
+ *
+ *显示模块分为与硬件无关的缓冲区部分（disp.c）和显示后端，后端由Makefile的DISPLAY选择，编译时
+ *确定，刷新中断内没有间接调用：\n
+ * - mux     disp_mux.c，CPU经PB、PC、PD口动态扫描，定时器2每2ms刷新一位（缺省）\n
+ * - max7219 disp_max7219.c，经硬件SPI送外部显示控制器，内容变化时才在主循环中发送\n
+ *两种后端的调度节拍都由定时器2比较匹配中断产生，每5次中断为一帧，10ms。本文件只供显示模块及
+ *后端包含\n
+ *函数列表：\n
+ * @sa disp_hw_init 后端初始化
+ * @sa disp_hw_on 后端开显示
+ * @sa disp_hw_off 后端关显示
+ * @sa disp_task 后端节拍任务
+ * @sa disp_seg 取某一位当前应显示的编码
+ * @sa disp_frame_end 一帧结束处理
+*/
+#ifndef DISP_HW_H
+#define DISP_HW_H
+#include "disp.h"
+#include "sched.h"
+
+extern uint8_t disp_buf[5];
+extern uint8_t disp_line[DISP_LINE_MAX];
+extern uint8_t disp_ovlbuf[5];
+extern volatile uint8_t disp_lit;
+extern volatile uint8_t disp_len;
+extern volatile uint8_t disp_pos;
+extern volatile uint8_t disp_mode;
+extern volatile uint8_t disp_frame;
+extern volatile uint8_t disp_ovl;
+
+void disp_hw_init(void);
+void disp_hw_on(void);
+void disp_hw_off(void);
+
+/**
+ *@brief 取某一位当前应显示的编码
+ *@param[in] ind 数位号0-4，0为个位
+ *@return 七段编码，叠加显示期间为叠加显示编码
+ */
+static inline uint8_t disp_seg(uint8_t ind)
+{
+  return (0 != disp_ovl) ? disp_ovlbuf[ind] : disp_buf[ind];
+}
+
+/**
+ *@brief 长行显示窗口送显示缓冲区
+ *
+ *将长行中从disp_pos开始的5个字符送至显示缓冲区，超出行尾时从行首循环
+ */
+static inline void disp_window(void)
+{
+  uint8_t i;
+  uint8_t pos;
+  pos = disp_pos;
+  for(i = 5U;i > 0;i--)
+  {
+    disp_buf[i - 1U] = disp_line[pos];
+    pos++;
+    if(pos >= disp_len)
+    {
+      pos = 0;
+    }
+  }
+}
+
+/**
+ *@brief 一帧结束处理，由后端的刷新中断每10ms调用一次
+ *
+ *产生调度节拍，叠加显示计时；长行到步进时间时滚动一位或翻一页
+ */
+static inline void disp_frame_end(void)
+{
+  uint8_t cnt;
+  sched_post(SCHED_EV_TICK);
+  if(0 != disp_ovl)
+  {
+    disp_ovl--;
+  }
+  if(0 != disp_len)
+  {
+    cnt = disp_frame + 1U;
+    if(DISP_MODE_PAGE == disp_mode)
+    {
+      if(cnt >= DISP_PAGE_STEP)
+      {
+        cnt = 0;
+        disp_pos += 5U;
+      }
+    }
+    else
+    {
+      if(cnt >= DISP_SCROLL_STEP)
+      {
+        cnt = 0;
+        disp_pos++;
+      }
+    }
+    if(disp_pos >= disp_len)
+    {
+      disp_pos = 0;
+    }
+    if(0 == cnt)
+    {
+      disp_window();
+    }
+    disp_frame = cnt;
+  }
+}
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @brief 响应测量统计头文件
+ * @file echo.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 每个脉冲完成后取响应测量结果，在发生器上累计次数、超时次数、最小、最大、平均值及直方图，
+ * 只经串口发送汇总\n
+ * 函数列表：
+ *@sa echo_set() 设置响应测量，清除统计
+ *@sa echo_get_window() 取测量窗口
+ *@sa echo_task() 脉冲完成任务，累计测量结果
+ *@sa echo_report() 发送统计
+ */
+#ifndef ECHO_H
+#define ECHO_H
+#include <stdint.h>
+
+#define ECHO_BINS      16U   /**<直方图格数，测量窗口等分*/
+#define ECHO_REF_EDGE  0x00U /**<从脉冲后沿计时*/
+#define ECHO_REF_TRIG  0x01U /**<从触发计时*/
+
+void echo_set(uint8_t edge,uint16_t window_ms,uint8_t ref);
+uint16_t echo_get_window(void);
+void echo_task(uint8_t ev);
+void echo_report(void);
+#endif
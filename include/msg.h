@@ -0,0 +1,48 @@
+/**
+ * @brief 消息输出头文件
+ * @file msg.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 提示及事件消息按编号输出，文本集中在 msg.def。文本方式发送文本及格式化的参数；代码方式只发送
+ * 一个代码字节（0x80加消息编号）及二进制参数（时间参数、十进制数3字节，十六进制数1字节，计数2字节，
+ * 低字节在前），
+ * 由主机解码程序 host/msgdec.c 还原为文本\n
+ * 函数列表：
+ *@sa msg_put_args() 发送带参数的消息
+ *@sa msg_set_mode() 设置输出方式
+ *@sa msg_get_mode() 取输出方式
+ */
+#ifndef MSG_H
+#define MSG_H
+#include <stdint.h>
+
+#define MSG_ARG_NONE   0x00U /**<无参数*/
+#define MSG_ARG_TIME1  0x01U /**<一个时间参数，文本方式按“d.dddd”换行*/
+#define MSG_ARG_TIME2  0x02U /**<两个时间参数，文本方式按“d.dddd,w.wwww”换行*/
+#define MSG_ARG_HEX1   0x03U /**<一个字节，文本方式按两位十六进制数换行*/
+#define MSG_ARG_NUM2   0x04U /**<两个16位计数，文本方式按“n,m”十进制数换行*/
+#define MSG_ARG_DEC2   0x05U /**<两个24位数，文本方式按“n,m”十进制数换行*/
+
+#define MSG_TEXT       0x00U /**<文本方式，缺省*/
+#define MSG_CODE       0x01U /**<代码方式*/
+#define MSG_TOKEN      0x80U /**<代码字节最高位*/
+
+/**
+ * @brief 消息编号，由 msg.def 生成
+ */
+enum msg_id
+{
+#define MSG(id,arg,text) MSG_##id,
+#include "msg.def"
+#undef MSG
+  MSG_NUM
+};
+
+#define msg_put(id)  msg_put_args((id),0,0) /**<发送无参数的消息*/
+
+void msg_put_args(uint8_t id,uint32_t a,uint32_t b);
+void msg_set_mode(uint8_t mod);
+uint8_t msg_get_mode(void);
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @brief 中断及任务执行时间统计头文件
+ * @file prof.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 定义PROFILE编译时有效（make PROFILE=1），否则各宏为空，不占用代码和RAM。定时器2改为8分频、
+ * 125us比较匹配中断，计数值与中断次数组成自由运行的时间戳，单位8个CPU周期；显示刷新每
+ * @ref PROF_T2_DIV 次中断执行一次，刷新周期不变\n
+ * 函数列表：
+ *@sa prof_now() 取时间戳
+ *@sa prof_add() 累计一次执行时间
+ *@sa prof_dump() 发送统计表并清零
+ */
+#ifndef PROF_H
+#define PROF_H
+#include <avr/io.h>
+#include <stdint.h>
+
+#define PROF_ID_INT0   0x00U /**<外部中断0*/
+#define PROF_ID_T1A    0x01U /**<定时器1比较匹配中断*/
+#define PROF_ID_T2A    0x02U /**<定时器2比较匹配中断，只计显示刷新的一次*/
+#define PROF_ID_URX    0x03U /**<串口接收中断*/
+#define PROF_ID_UDRE   0x04U /**<串口发送缓冲区空中断*/
+#define PROF_ID_FMT    0x05U /**<disp_fmt()时间参数格式化*/
+#define PROF_ID_WRT    0x06U /**<uart_write_times()发送时间参数*/
+#define PROF_ID_TASK   0x07U /**<调度任务，加任务表下标*/
+#define PROF_TASKS     9U    /**<统计的任务表项数*/
+#define PROF_NUM       (PROF_ID_TASK + PROF_TASKS) /**<统计项数*/
+
+#define PROF_T2_DIV    16U   /**<每次显示刷新的定时器2中断次数，125us×16=2ms*/
+#define PROF_T2_TOP    250U  /**<定时器2计数周期*/
+#define PROF_CYCLES    8U    /**<时间戳单位，CPU周期*/
+
+#ifdef PROFILE
+/**
+ * @brief   统计项类型
+ * @struct  sprof_t
+ */
+typedef struct prof_stat
+{
+  uint16_t count; /**<次数，达到最大值后不再累计*/
+  uint16_t min;   /**<最短时间*/
+  uint16_t max;   /**<最长时间*/
+  uint32_t sum;   /**<累计时间*/
+}sprof_t;
+
+extern volatile uint16_t prof_hi;
+
+/**
+ *@brief 取时间戳
+ *@return 时间戳，单位 @ref PROF_CYCLES 个CPU周期，65536回绕
+ *
+ *关中断读取，计数器已回绕而中断尚未响应时补上一个周期
+ */
+static inline uint16_t prof_now(void)
+{
+  uint8_t sreg;
+  uint8_t cnt;
+  uint16_t hi;
+  sreg = SREG;
+  __builtin_avr_cli();
+  cnt = TCNT2;
+  hi = prof_hi;
+  if((0 != (TIFR2 & _BV(OCF2A))) && (cnt < (PROF_T2_TOP / 2U)))
+  {
+    hi++;
+  }
+  SREG = sreg;
+  return (uint16_t)((hi * PROF_T2_TOP) + cnt);
+}
+
+void prof_add(uint8_t id,uint16_t dt);
+void prof_dump(void);
+
+#define PROF_ENTER()    uint16_t prof_t0 = prof_now() /**<开始计时，声明局部变量*/
+#define PROF_EXIT(id)   prof_add((id),(uint16_t)(prof_now() - prof_t0)) /**<结束计时并累计*/
+#define PROF_TICK()     (prof_hi++) /**<定时器2中断计数*/
+#define PROF_DUMP()     prof_dump() /**<发送统计表*/
+#else
+#define PROF_ENTER()
+#define PROF_EXIT(id)
+#define PROF_TICK()
+#define PROF_DUMP()
+#endif
+
+#endif
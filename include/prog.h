@@ -0,0 +1,73 @@
+/**
+ * @brief 脉冲程序解释器头文件
+ * @file prog.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 脉冲程序为字节码，保存在EEPROM，经串口上传。程序模式下在两个脉冲之间解释执行，设置时间参数时
+ * 即预备好下一个脉冲的寄存器映像。指令（多字节参数小端）：\n
+ * - @ref PROG_END 结束\n
+ * - @ref PROG_TRIG 开放触发，等待外部触发的脉冲完成\n
+ * - @ref PROG_EMIT 内部触发一次，等待脉冲完成\n
+ * - @ref PROG_DELAY d0 d1 d2 设置延时数，单位0.1ms\n
+ * - @ref PROG_WIDTH w0 w1 设置脉宽数，单位0.1ms\n
+ * - @ref PROG_LOOP n 循环开始，循环体执行n次，0为256次\n
+ * - @ref PROG_NEXT 循环结束\n
+ * - @ref PROG_JIN lvl addr 触发端口电平为lvl（0或1）时转移到addr\n
+ * - @ref PROG_WAIT t0 t1 等待，单位10ms\n
+ * - @ref PROG_JMP addr 转移到addr\n
+ * 上传格式：长度1字节、程序、程序及长度的CRC-8校验\n
+ * 函数列表：
+ *@sa prog_init() 初始化，从EEPROM装入程序
+ *@sa prog_start() 从头开始执行
+ *@sa prog_stop() 停止执行
+ *@sa prog_run() 执行到需要脉冲或等待为止
+ *@sa prog_load_begin() 开始接收程序
+ *@sa prog_load_poll() 接收程序
+ *@sa prog_task() 逐字节写入EEPROM
+ */
+#ifndef PROG_H
+#define PROG_H
+#include <stdint.h>
+
+#define PROG_SIZE   64U   /**<程序最大字节数*/
+#define PROG_DEPTH  4U    /**<循环嵌套层数*/
+#define PROG_STEPS  32U   /**<每次调用最多执行的指令数*/
+#define PROG_LD_TIMEOUT 100U /**<上传字节间隔超时，单位10ms节拍*/
+
+#define PROG_END    0x00U /**<结束*/
+#define PROG_TRIG   0x01U /**<开放触发，等待外部触发的脉冲完成*/
+#define PROG_EMIT   0x02U /**<内部触发一次，等待脉冲完成*/
+#define PROG_DELAY  0x03U /**<设置延时数，3字节参数*/
+#define PROG_WIDTH  0x04U /**<设置脉宽数，2字节参数*/
+#define PROG_LOOP   0x05U /**<循环开始，1字节次数*/
+#define PROG_NEXT   0x06U /**<循环结束*/
+#define PROG_JIN    0x07U /**<按触发端口电平转移，1字节电平、1字节地址*/
+#define PROG_WAIT   0x08U /**<等待，2字节时间*/
+#define PROG_JMP    0x09U /**<转移，1字节地址*/
+
+#define PROG_ACT_NONE  0x00U /**<无动作，程序等待或已停止*/
+#define PROG_ACT_TRIG  0x01U /**<开放外部触发*/
+#define PROG_ACT_EMIT  0x02U /**<开放触发并内部触发一次*/
+#define PROG_ACT_END   0x03U /**<程序结束或出错停止*/
+
+/**
+ * @brief   程序映像类型，EEPROM和RAM中相同
+ * @struct  sprog_t
+ */
+typedef struct prog_image
+{
+  uint8_t len;             /**<程序字节数*/
+  uint8_t code[PROG_SIZE]; /**<程序*/
+  uint8_t crc;             /**<长度及程序的CRC-8校验*/
+}sprog_t;
+
+void prog_init(void);
+void prog_start(void);
+void prog_stop(void);
+uint8_t prog_run(void);
+void prog_load_begin(void);
+int8_t prog_load_poll(uint8_t ev);
+void prog_task(uint8_t ev);
+#endif
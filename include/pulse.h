@@ -7,7 +7,8 @@
  * 函数列表
  *@sa pls_init() 初始化
  *@sa pls_set_pulse() 手动设置时间参数
- *@sa pls_set_param() 自动设置时间参数
+ *@sa pls_set_param() 开放触发前装入时间参数
+ *@sa pls_prepare() 预备下一组时间参数
  *@sa pls_set_mode()  设置工作模式
  *@sa pls_get_mode() 取工作模式
  *@sa pls_set_sta()   设置脉冲状态
@@ -16,41 +17,102 @@
  *@sa pls_get_delay() 取延时数
  *@sa pls_get_width() 取脉宽数
  *@sa pls_strtou()    数字字符串转整型数
+ *@sa pls_get_index() 取自动模式数组下标
+ *@sa pls_set_index() 设置自动模式数组下标
+ *@sa pls_set_itrig() 设置内部触发
+ *@sa pls_get_itrig() 取内部触发剩余次数
+ *@sa pls_emit() 内部触发一次
+ *@sa pls_set_trig() 设置触发条件
+ *@sa pls_get_trig() 取触发条件
+ *@sa pls_trig_idle() 触发端口是否为空闲电平
+ *@sa pls_get_ignored() 取抑制期内忽略的触发次数
+ *@sa pls_set_out() 设置脉冲产生方式
+ *@sa pls_arm() 开放触发
+ *@sa pls_disarm() 关闭触发
+ *@sa pls_set_ovr() 设置溢出触发的处理方式
+ *@sa pls_get_ovr() 取溢出触发的处理方式
+ *@sa pls_get_overrun() 取溢出触发次数
+ *@sa pls_get_dropped() 取丢失的触发次数
+ *@sa pls_get_queued() 取排队等待的触发数
+ *@sa pls_get_qwait() 取排队触发的最长等待时间
+ *@sa pls_set_echo() 设置响应测量
+ *@sa pls_get_echo() 取响应测量结果
+ *@sa pls_get_span() 取触发到脉冲后沿的时间
+ *@sa pls_set_sync() 设置同步角色
+ *@sa pls_get_sync() 取同步角色
  */ 
 #ifndef PULSE_H
 #define PULSE_H
 #include <avr/io.h>
 #include <stdint.h>
+#include "board.h"
 
-#define SPARK_PORT  PORTD /**<触发端口，PD口*/
-#define SPARK_DDR   DDRD  /**<触发端口方向，输入*/
-#define SPARK_PINS  PIND  /**<触发端口输入寄存器*/
-#define SPARK_PIN   2     /**<触发端口位，PD2脚，Aeduino Nano D2*/
+#define SPARK_PORT  BOARD_PORT(BOARD_TRIG) /**<触发端口*/
+#define SPARK_DDR   BOARD_DDR(BOARD_TRIG)  /**<触发端口方向，输入*/
+#define SPARK_PINS  BOARD_PINR(BOARD_TRIG) /**<触发端口输入寄存器*/
+#define SPARK_PIN   BOARD_BIT(BOARD_TRIG)  /**<触发端口位，INT0*/
 
-#define CLKOUT_PORT  PORTD  /**<时基输出端口，PD口*/
-#define CLKOUT_DDR   DDRD   /**<时基输出方向，输出*/
-#define CLKOUT_PIN   6      /**<时基输出管脚，PD6脚，Aeduino Nano D6*/
+#define CLKOUT_PORT  BOARD_PORT(BOARD_CLKOUT) /**<时基输出端口*/
+#define CLKOUT_DDR   BOARD_DDR(BOARD_CLKOUT)  /**<时基输出方向，输出*/
+#define CLKOUT_PIN   BOARD_BIT(BOARD_CLKOUT)  /**<时基输出管脚，OC0A*/
 
-#define CLKIN_PORT  PORTD   /**<时基输入端口，PD口*/
-#define CLKIN_DDR   DDRD    /**<时基输入方向，输入*/
-#define CLKIN_PIN   5       /**<时基输入管脚，PD5脚，Aeduino Nano D5*/
+#define CLKIN_PORT  BOARD_PORT(BOARD_CLKIN) /**<时基输入端口*/
+#define CLKIN_DDR   BOARD_DDR(BOARD_CLKIN)  /**<时基输入方向，输入*/
+#define CLKIN_PIN   BOARD_BIT(BOARD_CLKIN)  /**<时基输入管脚，T1*/
+#define CLKIN_PCINT PCINT21 /**<时基输入管脚的引脚变化中断，从机检测同步时刻*/
 
-#define LED_PORT    PORTB   /**<指示灯输出端口，PB口*/
-#define LED_DDR     DDRB    /**<指示灯输出方向，输出*/
-#define LED_PIN     5       /**<指示灯输出管脚，PB5脚，Aeduino Nano D13*/
+#define LED_PORT    BOARD_PORT(BOARD_LED) /**<指示灯输出端口*/
+#define LED_DDR     BOARD_DDR(BOARD_LED)  /**<指示灯输出方向，输出*/
+#define LED_PIN     BOARD_BIT(BOARD_LED)  /**<指示灯输出管脚*/
 
-#define PULSE_PORT  PORTB   /**<脉冲输出端口，PB口*/
-#define PULSE_DDR   DDRB    /**<脉冲输出方向，输出*/
-#define PULSE_PIN   1       /**<脉冲输出管脚，PB1脚，Aeduino Nano D9*/
+#define PULSE_PORT  BOARD_PORT(BOARD_PULSE) /**<脉冲输出端口*/
+#define PULSE_DDR   BOARD_DDR(BOARD_PULSE)  /**<脉冲输出方向，输出*/
+#define PULSE_PIN   BOARD_BIT(BOARD_PULSE)  /**<脉冲输出管脚，OC1A*/
+
+#define ECHO_MUX_NONE 0xffU /**<开发板没有响应输入*/
+#ifdef BOARD_ECHO_MUX
+#define ECHO_MUX    BOARD_ECHO_MUX /**<响应输入，ADC多路开关通道，经模拟比较器接入定时器1输入捕获*/
+#else
+#define ECHO_MUX    ECHO_MUX_NONE
+#endif
 
 #define PULSE_STA_DELAY       0x00U   /**<脉冲波的延迟态*/
 #define PULSE_STA_WIDTH       0x01U   /**<脉冲波的宽度态*/
 #define PULSE_STA_COMPLETE    0x02U   /**<脉冲波的完成态*/
+#define PULSE_STA_ECHO        0x03U   /**<脉冲波结束后等待响应*/
+
+#define PLS_EDGE_FALL   0x00U   /**<下降沿触发*/
+#define PLS_EDGE_RISE   0x01U   /**<上升沿触发*/
+#define PLS_EDGE_BOTH   0x02U   /**<双沿触发*/
+
+#define PLS_OUT_ISR     0x00U   /**<中断方式，延时边沿后由中断装入脉宽数*/
+#define PLS_OUT_HW      0x01U   /**<硬件边沿方式，两个边沿都由定时器1产生*/
+
+#define PLS_OVR_DROP    0x00U   /**<溢出触发丢弃并计数*/
+#define PLS_OVR_QUEUE   0x01U   /**<溢出触发带时间排队，开放触发时立即产生*/
+#define PLS_OVR_RESTART 0x02U   /**<溢出触发使进行中的脉冲从头重新开始*/
+#define PLS_QUEUE_SIZE  4U      /**<排队触发数，2的整数次幂*/
+
+#define PLS_ECHO_NONE    0x00U  /**<没有响应测量结果*/
+#define PLS_ECHO_GOT     0x01U  /**<测得响应*/
+#define PLS_ECHO_TIMEOUT 0x02U  /**<测量窗口内没有响应*/
+#define PLS_ECHO_MAX_MS  4194U  /**<最长测量窗口，ms*/
+
+#define PLS_SYNC_MASTER 0x00U   /**<主机（缺省）：触发后D6输出时基，各从机的D6与之相连*/
+#define PLS_SYNC_SLAVE  0x01U   /**<从机：D6为输入，定时器1由D5上主机的时基计数，不响应触发*/
+
+#define PLS_ITRIG_CONT  0xffffU /**<内部触发连续触发*/
+#ifdef PROFILE
+#define PLS_ITRIG_US    125U    /**<内部触发计时单位，定时器2比较匹配周期，us*/
+#else
+#define PLS_ITRIG_US    2000U   /**<内部触发计时单位，定时器2比较匹配周期，us*/
+#endif
 
 void pls_init(void);
-void pls_set_pulse(uint32_t dly,uint16_t wtd);
+void pls_set_pulse(uint32_t dly,uint32_t wtd);
 void pls_set_mode(uint8_t mod);
 void pls_set_param(void);
+void pls_prepare(void);
 void pls_set_sta(uint8_t sta);
 uint8_t pls_get_sta(void);
 uint8_t pls_get_busy(void);
@@ -58,4 +120,27 @@ uint8_t pls_get_mode(void);
 uint32_t pls_get_delay(void);
 uint16_t pls_get_width(void);
 uint32_t pls_strtou(uint8_t str[]);
+uint8_t pls_get_index(void);
+void pls_set_index(uint8_t ind);
+void pls_set_itrig(uint16_t period,uint16_t shots);
+uint16_t pls_get_itrig(void);
+void pls_emit(void);
+void pls_set_trig(uint8_t edge,uint8_t div,uint16_t holdoff);
+uint8_t pls_get_trig(uint8_t *div,uint16_t *holdoff);
+uint8_t pls_trig_idle(void);
+uint16_t pls_get_ignored(void);
+void pls_set_out(uint8_t out);
+void pls_arm(void);
+uint8_t pls_disarm(void);
+void pls_set_ovr(uint8_t policy);
+uint8_t pls_get_ovr(void);
+uint16_t pls_get_overrun(void);
+uint16_t pls_get_dropped(void);
+uint8_t pls_get_queued(void);
+uint16_t pls_get_qwait(void);
+void pls_set_echo(uint8_t edge,uint16_t window_ms);
+uint8_t pls_get_echo(uint32_t *us);
+uint32_t pls_get_span(void);
+void pls_set_sync(uint8_t role);
+uint8_t pls_get_sync(void);
 #endif
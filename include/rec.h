@@ -0,0 +1,67 @@
+/**
+ * @brief 运行记录器头文件
+ * @file rec.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 在.noinit段保存最近的状态、中断事件和命令，看门狗复位后仍然保留，用于事后分析\n
+ * 函数列表：
+ *@sa rec_init() 初始化
+ *@sa rec_put() 记录一个事件
+ *@sa rec_get_cause() 取复位原因
+ *@sa rec_dump() 发送复位原因及记录
+ */
+#ifndef REC_H
+#define REC_H
+#include <avr/io.h>
+#include <stdint.h>
+
+#define REC_SIZE   16U      /**<记录条数，2的整数次幂*/
+#define REC_MAGIC  0x5aa5U  /**<记录有效标志*/
+
+#define REC_EV_BOOT   0x01U /**<上电或复位，数据为MCUSR*/
+#define REC_EV_STATE  0x02U /**<主控制状态变化，数据为新状态*/
+#define REC_EV_MODE   0x03U /**<工作模式变化，数据为新模式*/
+#define REC_EV_ARM    0x04U /**<开放触发，数据为工作模式*/
+#define REC_EV_TRIG   0x05U /**<触发，数据0外部中断0，1内部触发，2排队的触发，3溢出触发重新开始，4从机同步*/
+#define REC_EV_DONE   0x06U /**<单脉冲完成*/
+#define REC_EV_CMD    0x07U /**<串口命令，数据为命令字符*/
+
+/**
+ * @brief   记录结构类型
+ * @struct  srec_t
+ */
+typedef struct rec_entry
+{
+  uint8_t tag;  /**<事件*/
+  uint8_t data; /**<数据*/
+}srec_t;
+
+extern srec_t rec_ring[REC_SIZE];
+extern uint8_t rec_index;
+
+/**
+ *@brief 记录一个事件
+ *@param[in] tag 事件
+ *@param[in] data 数据
+ *
+ *内联函数，可在中断服务程序中调用，不增加中断现场保护的开销
+ */
+static inline void rec_put(uint8_t tag,uint8_t data)
+{
+  uint8_t sreg;
+  uint8_t ind;
+  sreg = SREG;
+  __builtin_avr_cli();
+  ind = rec_index;
+  rec_ring[ind].tag = tag;
+  rec_ring[ind].data = data;
+  rec_index = (uint8_t)((ind + 1U) & (REC_SIZE - 1U));
+  SREG = sreg;
+}
+
+void rec_init(void);
+uint8_t rec_get_cause(void);
+void rec_dump(uint8_t all);
+#endif
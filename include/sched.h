@@ -0,0 +1,55 @@
+/**
+ * @brief 事件驱动协作式调度器头文件
+ * @file sched.h
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 中断服务程序置事件标志，主程序按任务表分派事件，无事件时CPU进入空闲睡眠\n
+ * 函数列表：
+ *@sa sched_init() 初始化
+ *@sa sched_set_tasks() 设置任务表
+ *@sa sched_run() 分派一次事件
+ *@sa sched_post() 置事件标志
+ */
+#ifndef SCHED_H
+#define SCHED_H
+#include <avr/io.h>
+#include <stdint.h>
+
+#define SCHED_EVENTS  GPIOR0 /**<事件标志寄存器，位操作编译为单条sbi/cbi指令，主程序与中断均可直接置位*/
+
+#define SCHED_EV_TRIG   0x01U /**<触发事件，外部中断0*/
+#define SCHED_EV_DONE   0x02U /**<单脉冲完成事件，定时器1比较匹配中断*/
+#define SCHED_EV_UART   0x04U /**<串口接收事件*/
+#define SCHED_EV_TICK   0x08U /**<节拍事件，显示刷新每帧一次*/
+#define SCHED_EV_READY  0x10U /**<触发端口就绪事件，主程序产生*/
+
+#define SCHED_TICK_MS   10U   /**<节拍周期，单位ms*/
+
+/**
+ *@brief 置事件标志
+ *@param ev 事件，单个事件位时编译为sbi指令，不需关中断
+ */
+#define sched_post(ev)  (SCHED_EVENTS |= (ev))
+
+/**
+ * @brief 任务函数类型
+ * @param ev 本次分派的全部事件
+ */
+typedef void (*sched_fn_t)(uint8_t ev);
+
+/**
+ * @brief 任务结构类型
+ * @struct stask_t
+ */
+typedef struct sched_task
+{
+  uint8_t mask;   /**<响应的事件*/
+  sched_fn_t fn;  /**<任务函数*/
+}stask_t;
+
+void sched_init(void);
+void sched_set_tasks(const __flash stask_t tasks[],uint8_t n);
+void sched_run(void);
+#endif
@@ -5,16 +5,26 @@
  * @version V1.1.0
  * @date 2016-10-17
  *
- * 串口接口常数定义与函数声明\n
+ * 串口接口常数定义与函数声明。设置了本机地址时为多机方式：多台共用一条串口总线，主机发送的
+ * @ref UART_ADDR_MARK 及地址字节选中一台（或 @ref UART_ADDR_ALL 选中全部），未选中时丢弃接收的
+ * 字节；只有被单独选中时发送，其余时间关闭发送器释放TXD。数据中的 @ref UART_ADDR_MARK 及
+ * @ref UART_ADDR_ESC 由主机前缀 @ref UART_ADDR_ESC 发送\n
  * 函数列表：
  *@sa uart_init() 初始化
  *@sa uart_send() 发送一个字符
  *@sa uart_getchar() 接收一个字符
+ *@sa uart_peek() 读取队头字符
  *@sa uart_getnum()  接收数字字符串
+ *@sa uart_readnum() 非阻塞接收数字字符串
  *@sa uart_putsn_P() 发送FLASH的字符串
+ *@sa uart_puts_P() 发送FLASH中以'\0'结束的字符串
  *@sa uart_flush() 清空接收缓冲区
  *@sa uart_received() 是否已接收了数据／字符
  *@sa uart_write_times() 发送时间参数数据
+ *@sa uart_write_hex() 发送十六进制数
+ *@sa uart_write_dec() 发送十进制数
+ *@sa uart_set_addr() 设置本机地址
+ *@sa uart_get_addr() 取本机地址
  */
 #ifndef UART_H
 #define UART_H
@@ -31,20 +41,37 @@
 #define FE		FE0     /**<usart控制寄存器A,FE位*/
 #define DOR		DOR0    /**<usart控制寄存器A,DOR位*/
 #define U2X		U2X0    /**<usart控制寄存器A,U2X位*/
+#define TXC		TXC0    /**<usart控制寄存器A,TXC位*/
 #define RXEN	RXEN0   /**<usart控制寄存器B,RXEN位*/
 #define RXCIE	RXCIE0   /**<usart控制寄存器B,RXCIE位*/
+#define UDRIE	UDRIE0   /**<usart控制寄存器B,UDRIE位*/
+#define TXCIE	TXCIE0   /**<usart控制寄存器B,TXCIE位*/
 #define TXEN	TXEN0   /**<usart控制寄存器B,TXEN位*/
 #define UCSZ1	UCSZ01  /**<usart控制寄存器C,UCSZ1位*/
 #define UCSZ0	UCSZ00  /**<usart控制寄存器C,UCSZ0位*/
 #define USBS	USBS0   /**<usart控制寄存器C,USBS位*/
 
+#define UART_TXSIZE 64U /**<发送队列长度，2的整数次幂*/
+
+#define UART_ADDR_MARK  0xffU /**<多机方式，下一字节为地址*/
+#define UART_ADDR_ESC   0xfeU /**<多机方式，下一字节为数据*/
+#define UART_ADDR_ALL   0x00U /**<广播地址，全部接收，都不发送*/
+#define UART_ADDR_MAX   127U  /**<最大本机地址，0为单机方式*/
+
 void uart_send(uint8_t byte);
 void uart_init(uint32_t baud);
 uint8_t uart_getchar(void);
+uint8_t uart_peek(void);
 int8_t uart_getnum(uint8_t str[]);
+int8_t uart_readnum(uint8_t str[]);
 void uart_putsn(char str[],uint8_t n);
 void uart_putsn_P(const __flash char str[],uint8_t n);
+void uart_puts_P(const __flash char *str);
 void uart_flush(void);
 uint8_t uart_received(void);
 void uart_write_times(uint32_t num);
+void uart_write_hex(uint8_t byte);
+void uart_write_dec(uint32_t num);
+void uart_set_addr(uint8_t addr);
+uint8_t uart_get_addr(void);
 #endif
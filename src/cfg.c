@@ -0,0 +1,232 @@
+/**
+ * @brief 参数掉电保存模块
+ * @file cfg.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 参数记录带版本和CRC-8校验，依次写入EEPROM中 @ref CFG_SLOTS 条记录的循环区，每条记录位置
+ * 轮流使用，均衡磨损。上电时取序号最新的有效记录恢复参数；参数有变化时才写入，写入由节拍
+ * 任务每次写一个字节，不等待EEPROM写完成。写入中途掉电的记录校验错误，自动使用上一条记录\n
+ * 自动模式每发一个脉冲数组下标加1，若每次都写入，连续内部触发时约一个月即用完EEPROM的擦写寿命，
+ * 因此只有下标变化时推迟到 @ref CFG_IDLE_TICKS 个节拍内没有再保存请求才写入；其它参数变化时
+ * 连同当时的下标立即写入\n
+ * 函数列表：
+ *@sa cfg_init() 初始化，恢复参数
+ *@sa cfg_save() 请求保存参数
+ *@sa cfg_task() 逐字节写入EEPROM
+ *@sa cfg_recall() 恢复手动时间参数
+ */
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "cfg.h"
+#include "pulse.h"
+#include "uart.h"
+
+scfg_t cfg_ring[CFG_SLOTS] EEMEM;/**<EEPROM参数记录循环区*/
+
+static scfg_t cfg_cur;/**<最近写入（或正在写入）的参数记录*/
+static uint8_t cfg_slot;/**<最近写入的记录位置*/
+static uint8_t cfg_pending;/**<待写入的字节数，0无写入*/
+static uint8_t cfg_dirty;/**<有保存请求未处理，写入中的请求等写完再比较*/
+static uint16_t cfg_idle;/**<只有下标变化时距写入的节拍数，0无推迟的写入*/
+
+/**
+ *@brief 计算参数记录的CRC-8校验
+ *@param[in] rec 参数记录
+ *@return 除crc外各字节的CRC-8校验
+ */
+static uint8_t cfg_crc(const scfg_t *rec)
+{
+  const uint8_t *p;
+  uint8_t i;
+  uint8_t crc = 0;
+  p = (const uint8_t *)rec;
+  for(i = 0;i < (sizeof(scfg_t) - 1U);i++)
+  {
+    crc = _crc8_ccitt_update(crc,p[i]);
+  }
+  return crc;
+}
+
+/**
+ *@brief 取触发条件存入参数记录
+ *@param[out] rec 参数记录
+ */
+static void cfg_get_trig(scfg_t *rec)
+{
+  uint8_t div;
+  uint16_t holdoff;
+  rec->edge = pls_get_trig(&div,&holdoff);
+  rec->div = div;
+  rec->holdoff = holdoff;
+}
+
+/**
+ *@brief 初始化，恢复参数
+ *@return 0无有效记录，使用缺省参数；非零已恢复参数
+ *
+ *扫描全部记录，取版本、校验正确且序号最新的记录，恢复工作模式、自动模式数组下标、手动
+ *时间参数、串口地址、同步角色和触发条件。须在 pls_init() 之后、 uart_init() 之前调用
+ */
+uint8_t cfg_init(void)
+{
+  scfg_t rec;
+  uint8_t i;
+  uint8_t ret = 0;
+  cfg_pending = 0;
+  cfg_dirty = 0;
+  cfg_idle = 0;
+  cfg_slot = CFG_SLOTS - 1U;
+  for(i = 0;i < CFG_SLOTS;i++)
+  {
+    eeprom_read_block(&rec,&cfg_ring[i],sizeof(scfg_t));
+    if((CFG_VER == rec.ver) && (cfg_crc(&rec) == rec.crc))
+    {
+      if((0 == ret) || ((int8_t)(rec.seq - cfg_cur.seq) > 0))
+      {
+        cfg_cur = rec;
+        cfg_slot = i;
+        ret = 1U;
+      }
+    }
+  }
+  if(0 != ret)
+  {
+    cfg_recall();
+    pls_set_index(cfg_cur.index);
+    pls_set_mode(cfg_cur.mode);
+    uart_set_addr(cfg_cur.addr);
+    pls_set_sync(cfg_cur.sync);
+    pls_set_trig(cfg_cur.edge,cfg_cur.div,cfg_cur.holdoff);
+  }
+  else
+  {
+    cfg_cur.ver = CFG_VER;
+    cfg_cur.seq = 0;
+    cfg_cur.mode = pls_get_mode();
+    cfg_cur.index = pls_get_index();
+    cfg_cur.delay = pls_get_delay();
+    cfg_cur.width = pls_get_width();
+    cfg_cur.addr = uart_get_addr();
+    cfg_cur.sync = pls_get_sync();
+    cfg_get_trig(&cfg_cur);
+  }
+  return ret;
+}
+
+/**
+ *@brief 参数有变化时准备写入
+ *@param with_index 0不比较自动模式数组下标；非零比较
+ *@return 0无变化或已准备写入；非零只有下标变化，未写入
+ *
+ *取当前工作模式、自动模式数组下标、串口地址、同步角色、触发条件，手动模式时取时间参数，与最近写入的记录比较，有变化时
+ *在下一个记录位置准备写入，由 cfg_task() 完成
+ */
+static uint8_t cfg_update(uint8_t with_index)
+{
+  scfg_t rec;
+  uint8_t ret = 0;
+  rec = cfg_cur;
+  rec.mode = pls_get_mode();
+  rec.index = pls_get_index();
+  rec.addr = uart_get_addr();
+  rec.sync = pls_get_sync();
+  cfg_get_trig(&rec);
+  if(0 != rec.mode)
+  {
+    rec.delay = pls_get_delay();
+    rec.width = pls_get_width();
+  }
+  if((rec.mode != cfg_cur.mode) || (rec.delay != cfg_cur.delay) || (rec.width != cfg_cur.width)
+     || (rec.addr != cfg_cur.addr) || (rec.sync != cfg_cur.sync) || (rec.edge != cfg_cur.edge)
+     || (rec.div != cfg_cur.div) || (rec.holdoff != cfg_cur.holdoff)
+     || ((0 != with_index) && (rec.index != cfg_cur.index)))
+  {
+    rec.seq++;
+    rec.crc = cfg_crc(&rec);
+    cfg_cur = rec;
+    cfg_slot++;
+    if(cfg_slot >= CFG_SLOTS)
+    {
+      cfg_slot = 0;
+    }
+    cfg_pending = sizeof(scfg_t);
+    cfg_idle = 0;
+  }
+  else if(rec.index != cfg_cur.index)
+  {
+    ret = 1U;
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+  return ret;
+}
+
+/**
+ *@brief 请求保存参数
+ *
+ *只登记请求，由 cfg_task() 在上一条记录写完后比较参数，不会丢失写入期间的请求
+ */
+void cfg_save(void)
+{
+  cfg_dirty = 1U;
+}
+
+/**
+ *@brief 逐字节写入EEPROM的节拍任务
+ *@param ev 事件
+ *
+ *EEPROM空闲时写入一个字节后立即返回，不等待写完成；与原内容相同的字节不写。
+ *校验字节最后写入。没有写入时处理保存请求，只有下标变化时开始计数空闲节拍，满
+ * @ref CFG_IDLE_TICKS 个节拍再写入
+ */
+void cfg_task(uint8_t ev)
+{
+  uint8_t ind;
+  if(0 != cfg_pending)
+  {
+    if(0 != eeprom_is_ready())
+    {
+      ind = (uint8_t)(sizeof(scfg_t) - cfg_pending);
+      eeprom_update_byte((uint8_t *)&cfg_ring[cfg_slot] + ind,((const uint8_t *)&cfg_cur)[ind]);
+      cfg_pending--;
+    }
+  }
+  else if(0 != cfg_dirty)
+  {
+    cfg_dirty = 0;
+    if(0 != cfg_update(0))
+    {
+      cfg_idle = CFG_IDLE_TICKS;
+    }
+  }
+  else if(0 != cfg_idle)
+  {
+    cfg_idle--;
+    if(0 == cfg_idle)
+    {
+      (void)cfg_update(1U);
+    }
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+}
+
+/**
+ *@brief 恢复手动时间参数
+ *
+ *以最近保存的手动延时数、脉宽数设置时间参数，用于上电恢复和从自动模式进入手动模式
+ */
+void cfg_recall(void)
+{
+  uint8_t mod;
+  mod = pls_get_mode();
+  pls_set_mode(1U);
+  pls_set_pulse(cfg_cur.delay,cfg_cur.width);
+  pls_set_mode(mod);
+}
@@ -1,11 +1,12 @@
 /**
- * @brief 5位数码管动态显示
+ * @brief 5位数码管显示
  * @file disp.c
  * @author shenxf 380406785@@qq.com
  * @version V1.2.0
  * @date 2016-10-24
  * 
- * 5位公阴数码管动态显示，
+ * 5位数码管显示缓冲区、长行滚动及叠加显示，与硬件无关；输出由Makefile的DISPLAY选择的后端完成，
+ * 见 disp_hw.h\n
  * 函数列表
  * @sa disp_init 初始化
  * @sa disp_on  开显示
@@ -13,9 +14,13 @@
  * @sa disp_play 将数传递至显示缓冲区
  * @sa disp_fill 填充字段码
  * @sa disp_filln 指定数位填充
+ * @sa disp_puts 显示字符串，超出5位时滚动或分页显示
+ * @sa disp_play_pair 交替显示两个时间参数
+ * @sa disp_fmt 时间参数格式化为字符串
+ * @sa disp_overlay 限时叠加显示
  */ 
-#include <avr/interrupt.h>
-#include "disp.h"
+#include "disp_hw.h"
+#include "prof.h"
 
 /**
  *@var __flash const uint8_t digitcode[10]
@@ -30,156 +35,71 @@ __flash const uint8_t digitcode[10] =
  */ 
 uint8_t disp_buf[5];
 
-volatile uint8_t disp_index;/**<当前显示的数位号0-4*/
+volatile uint8_t disp_lit;/**<显示开关，0关闭，非0打开；关闭时定时器2继续运行，提供调度节拍*/
 
 /**
- * 
- * @brief 定时器2比较匹配中断服务程序
- * 
- * 2ms一次中断服务，关闭当前位显示，更新下一个数位并显示，5位数码管显示刷新率10ms
- */ 
-ISR(TIMER2_COMPA_vect)
-{
-  uint8_t ind;
-  uint8_t scode;
-  ind = disp_index;
-  
-  /*关闭当前数位显示，位选置1关闭*/
-  if(0 == ind)
-  {
-    DIGIT0_PORT |= _BV(DIGIT_PIN0);
-  }
-  else if(1U == ind)
-  {
-    DIGIT1_PORT |= _BV(DIGIT_PIN1);
-  }
-  else if(2U == ind)
-  {
-    DIGIT2_PORT |= _BV(DIGIT_PIN2);
-  }
-  else if(3U == ind)
-  {
-    DIGIT3_PORT |= _BV(DIGIT_PIN3);
-  }
-  else if(4U == ind)
-  {
-    DIGIT4_PORT |= _BV(DIGIT_PIN4);
-  }
-  else
-  {
-    ;/* no deal with */
-  }
-  
-  /*更新下一个数位显示编码，段置1数码管段亮*/
-  ind++;
-  if(ind > 4U)
-  {
-    ind = 0;
-  }
-  scode = disp_buf[ind];
-  SEGC_PORT = (scode & 0x3fU);
-  if(0x40U == (scode & 0x40U))
-  {
-    SEGD_PORT |= _BV(SEGD_PIN6);
-  }
-  else
-  {
-    SEGD_PORT &= ~_BV(SEGD_PIN6);
-  }
-  if(0x80U == (scode & 0x80U))
-  {
-    SEGD_PORT |= _BV(SEGD_PIN7);
-  }
-  else
-  {
-    SEGD_PORT &= ~_BV(SEGD_PIN7);
-  }
-  
-  /*显示下一个数码，位选置0显示*/
-  if(0 == ind)
-  {
-    DIGIT0_PORT &= ~_BV(DIGIT_PIN0);
-  }
-  else if(1U == ind)
-  {
-    DIGIT1_PORT &= ~_BV(DIGIT_PIN1);
-  }
-  else if(2U == ind)
-  {
-    DIGIT2_PORT &= ~_BV(DIGIT_PIN2);
-  }
-  else if(3U == ind)
-  {
-    DIGIT3_PORT &= ~_BV(DIGIT_PIN3);
-  }
-  else if(4U == ind)
-  {
-    DIGIT4_PORT &= ~_BV(DIGIT_PIN4);
-  }
-  else
-  {
-    ;/* no deal with */
-  }
-  
-  /*保存下一个数位号*/
-  disp_index = ind;
-}
+ *@var __flash const uint8_t alphacode[26]
+ *@brief 存在FLASH的字母七段编码，依次a~z，无法显示的字母为0
+ */
+__flash const uint8_t alphacode[26] =
+{0x77U,0x7cU,0x39U,0x5eU,0x79U,0x71U,0x3dU,0x76U,0x30U,0x1eU,0x75U,0x38U,0x37U,
+ 0x54U,0x5cU,0x73U,0x67U,0x50U,0x6dU,0x78U,0x3eU,0x1cU,0x2aU,0x76U,0x6eU,0x5bU};
+
+/**
+ * @var disp_line[DISP_LINE_MAX]
+ * @brief 长行显示缓冲区，七段编码，下标0为最左边的字符
+ */
+uint8_t disp_line[DISP_LINE_MAX];
+
+volatile uint8_t disp_len;/**<长行字符数，0表示静态显示，不滚动*/
+volatile uint8_t disp_pos;/**<长行显示窗口起始位置*/
+volatile uint8_t disp_mode;/**<长行显示方式，@ref DISP_MODE_SCROLL 或 @ref DISP_MODE_PAGE*/
+volatile uint8_t disp_frame;/**<刷新帧计数，10ms一帧*/
+
+/**
+ * @var disp_ovlbuf[5]
+ * @brief 叠加显示编码缓冲区，叠加显示期间代替disp_buf刷新，下标为0时表示个位
+ */
+uint8_t disp_ovlbuf[5];
+
+volatile uint8_t disp_ovl;/**<叠加显示剩余帧数，0无叠加显示*/
 
 /**
 *@fn void disp_init(void)
 *@brief 初始化
 *
-*动态数码管显示初始化，设置段端口、位选端口为高阻输入，定时器2设置为CTC模式
- */ 
+*显示缓冲区清零，后端初始化，定时器2设置为CTC模式
+ */
 void disp_init(void)
 {
   uint8_t i;
   
-  /* 段端口初始化，PC0～PC5对应a~f段，PD3～PD4对应g、dp段，高阻输入
-  ＊ PC0(A0)-->a
-  *  PC1(A1)-->b
-  *	 PC2(A2)-->c
-  *  PC3(A3)-->d
-  *  PC4(A4)-->e
-  *  PC5(A5)-->f
-  *  PD3(D3)-->g
-  *  PD4(D4)-->dp
-  */
-  SEGC_PORT = 0x00;
-  SEGC_DDR  = 0x00;
-  SEGD_PORT &= ~(_BV(SEGD_PIN6)|_BV(SEGD_PIN7));
-  SEGD_DDR  &= ~(_BV(SEGD_PIN6)|_BV(SEGD_PIN7));
-
-  /*位选端口初始化，DS0～DS4对应个位～万位，高阻输入
-  *DS4-->PD7(D7)
-  *DS3-->PB0(D8)
-  *DS2-->PB2(D10)
-  *DS1-->PB3(D11)
-  *DS0-->PB4(D12)
-  */
-  DIGIT4_PORT &= ~_BV(DIGIT_PIN4);
-  DIGIT3_PORT &= ~_BV(DIGIT_PIN3);
-  DIGIT2_PORT &= ~_BV(DIGIT_PIN2);
-  DIGIT1_PORT &= ~_BV(DIGIT_PIN1);
-  DIGIT0_PORT &= ~_BV(DIGIT_PIN0);
-  DIGIT4_DDR  &= ~_BV(DIGIT_PIN4);
-  DIGIT3_DDR  &= ~_BV(DIGIT_PIN3);
-  DIGIT2_DDR  &= ~_BV(DIGIT_PIN2);
-  DIGIT1_DDR  &= ~_BV(DIGIT_PIN1);
-  DIGIT0_DDR  &= ~_BV(DIGIT_PIN0);
-  
   /*七段数码管编码缓冲区，下标0对应DS0*/
   for(i = 0;i<5U;i++)
   {
     disp_buf[i] = 0;
   }
-  disp_index = 0;
-  
-  /*定时器2初始化，CTC模式，计数器清零，比较匹配寄存器赋值249，T2分频数250，关闭T2时钟*/
+  disp_lit = 0;
+  disp_ovl = 0;
+  disp_len = 0;
+  disp_pos = 0;
+  disp_mode = DISP_MODE_SCROLL;
+  disp_frame = 0;
+  disp_hw_init();
+
+  /*定时器2初始化，CTC模式，计数器清零，比较匹配寄存器赋值249，T2分频数250，预分频数128，
+   *2ms中断一次，5次一帧，允许T2比较匹配中断。定时器2始终运行，关显示时仍产生调度节拍；统计执行时间时
+   *预分频数为8，125us中断一次*/
   TCCR2A = _BV(WGM21);
   OCR2A = 249U;
   TCNT2 = 0;
-  TCCR2B = 0;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 = _BV(OCIE2A);
+#ifdef PROFILE
+  TCCR2B = _BV(CS21);
+#else
+  TCCR2B = _BV(CS22)|_BV(CS20);
+#endif
 }
 
 /**
@@ -189,20 +109,10 @@ void disp_init(void)
  */
 void disp_on(void)
 {
-  /*设置段端口为输出*/
-  SEGC_DDR  = 0x3fU;
-  SEGD_DDR  |= _BV(SEGD_PIN6)|_BV(SEGD_PIN7);
+  disp_hw_on();
 
-  /*设置位选端口为输出*/
-  DIGIT4_DDR  |= _BV(DIGIT_PIN4);
-  DIGIT3_DDR  |= _BV(DIGIT_PIN3);
-  DIGIT2_DDR  |= _BV(DIGIT_PIN2);
-  DIGIT1_DDR  |= _BV(DIGIT_PIN1);
-  DIGIT0_DDR  |= _BV(DIGIT_PIN0);
-  
-  /*允许T2比较匹配中断，开启T2时钟，预分频数128*/
-  TIMSK2 = _BV(OCIE2A);
-  TCCR2B |= _BV(CS22)|_BV(CS21);      
+  /*刷新中断或后端任务开始输出*/
+  disp_lit = 1U;
 }
 
 /**
@@ -211,28 +121,17 @@ void disp_on(void)
 */
 void disp_off(void)
 {
-  /*设置段端口为高阻输入*/
-  SEGC_DDR  = 0x00;
-  SEGD_DDR  &= ~(_BV(SEGD_PIN6)|_BV(SEGD_PIN7));
+  disp_hw_off();
 
-  /*设置位选端口为高阻输入*/
-  DIGIT4_DDR  &= ~_BV(DIGIT_PIN4);
-  DIGIT3_DDR  &= ~_BV(DIGIT_PIN3);
-  DIGIT2_DDR  &= ~_BV(DIGIT_PIN2);
-  DIGIT1_DDR  &= ~_BV(DIGIT_PIN1);
-  DIGIT0_DDR  &= ~_BV(DIGIT_PIN0);
-  
-  /*关闭T2时钟，禁止T2比较匹配中断，请T2比较匹配中断标志*/
-  TCCR2B &= ~(_BV(CS22)|_BV(CS21));
-  TIFR2 |= _BV(OCF2A);
-  TIMSK2 &= ~_BV(OCIE2A);
+  /*刷新中断停止输出，定时器2继续运行提供节拍*/
+  disp_lit = 0;
 }
 
 /**
  *@brief 将整型数转换成七段数码管编码，并存入缓冲区
  *@param[in] num 长整型数，单位是0.1ms
  *
- *只接收小于1000000的数，只能显示5位十进制数
+ *小于100000的数直接以“#.####”显示，不小于100000的数格式化为字符串后滚动显示
  * @sa disp_on  开显示
  * @sa disp_off 关显示
  * @sa disp_fill 填充字段码
@@ -244,16 +143,19 @@ void disp_play(uint32_t num)
   uint32_t nm;
   uint8_t dgt,ind;
   uint8_t digits[5];
+  char str[12];
   nm = num;
   if(nm<100000UL)
   {
+    disp_len = 0;
+
     /*五位十进制数字，初始值0*/
     for(ind = 0;ind < 5U;ind++)
     {
       digits[ind] = 0;
     }
 
-    /*将整型数转换十进制数*/
+    /*将整型数转换十进制数，小于100000最多五位，其余位保持0*/
     ind = 0;
     do
     {
@@ -262,9 +164,7 @@ void disp_play(uint32_t num)
       nm /= 10;
       ind++;
     }
-    while(0 != nm);
-    dgt = (uint8_t)(nm % 10);
-    digits[ind] = dgt;
+    while((0 != nm) && (ind < 5U));
 
     /*将十进制数转换成七段数码管编码*/
     disp_buf[4] = digitcode[digits[4]] | DPOINT;/*最高位总是带小数点的，因此加上dp位*/
@@ -273,6 +173,11 @@ void disp_play(uint32_t num)
       disp_buf[ind] = digitcode[digits[ind]];
     }
   }
+  else
+  {
+    (void)disp_fmt(nm,str);
+    disp_puts(str);
+  }
 }
 
 /**
@@ -286,6 +191,7 @@ void disp_play(uint32_t num)
 void disp_fill(uint8_t segs)
 {
   uint8_t i;
+  disp_len = 0;
   for(i = 0;i < 5U;i++)
   {
     disp_buf[i] = segs;
@@ -303,6 +209,205 @@ void disp_fill(uint8_t segs)
  */ 
 void disp_filln(uint8_t segs,uint8_t digit)
 {
+  disp_len = 0;
   disp_buf[digit] = segs;
 }
 
+/**
+ *@brief 字符转换成七段数码管编码
+ *@param[in] ch 字符，数字、字母（不分大小写）、空格、“-”、“_”
+ *@return 七段数码管编码，无法显示的字符为0
+ */
+static uint8_t disp_segcode(char ch)
+{
+  uint8_t ret = 0;
+  if((ch >= '0') && (ch <= '9'))
+  {
+    ret = digitcode[(uint8_t)(ch - '0')];
+  }
+  else if((ch >= 'a') && (ch <= 'z'))
+  {
+    ret = alphacode[(uint8_t)(ch - 'a')];
+  }
+  else if((ch >= 'A') && (ch <= 'Z'))
+  {
+    ret = alphacode[(uint8_t)(ch - 'A')];
+  }
+  else if('-' == ch)
+  {
+    ret = 0x40U;
+  }
+  else if('_' == ch)
+  {
+    ret = 0x08U;
+  }
+  else
+  {
+    ;/*空格及其它字符不显示*/
+  }
+  return ret;
+}
+
+/**
+ *@brief 时间参数格式化为“#.####”字符串
+ *@param[in] num 时间参数，单位0.1ms
+ *@param[out] str 字符串，至少12字节
+ *@return 字符串长度
+ */
+uint8_t disp_fmt(uint32_t num,char str[])
+{
+  char tmp[10];
+  uint8_t i = 0;
+  uint8_t n = 0;
+  PROF_ENTER();
+  do
+  {
+    tmp[i] = (char)('0' + (uint8_t)(num % 10U));
+    num /= 10U;
+    i++;
+  }
+  while((0 != num) || (i < 5U));
+  while(i > 0)
+  {
+    i--;
+    str[n] = tmp[i];
+    n++;
+    if(4U == i)
+    {
+      str[n] = '.';
+      n++;
+    }
+  }
+  str[n] = '\0';
+  PROF_EXIT(PROF_ID_FMT);
+  return n;
+}
+
+/**
+ *@brief 将字符串转换成七段数码管编码显示
+ *@param[in] str 字符串，“.”并入前一字符的dp段
+ *
+ *不超过5个字符时右对齐静态显示；超过5个字符时在刷新中断中按 @ref DISP_SCROLL_STEP 循环滚动，
+ *不需要主程序定时驱动
+ * @sa disp_play 将数传递至显示缓冲区
+ * @sa disp_play_pair 交替显示两个时间参数
+ */
+void disp_puts(const char str[])
+{
+  uint8_t n = 0;
+  uint8_t i;
+  disp_len = 0;
+  for(i = 0;(str[i] != '\0') && (n < (DISP_LINE_MAX - 2U));i++)
+  {
+    if(('.' == str[i]) && (n > 0))
+    {
+      disp_line[n - 1U] |= DPOINT;
+    }
+    else
+    {
+      disp_line[n] = disp_segcode(str[i]);
+      n++;
+    }
+  }
+  if(n <= 5U)
+  {
+    for(i = 0;i < 5U;i++)
+    {
+      disp_buf[i] = (i < n) ? disp_line[n - 1U - i] : 0;
+    }
+  }
+  else
+  {
+    /*行尾加两个空格与行首隔开*/
+    disp_line[n] = 0;
+    disp_line[n + 1U] = 0;
+    disp_mode = DISP_MODE_SCROLL;
+    disp_pos = 0;
+    disp_frame = 0;
+    disp_len = n + 2U;
+    disp_window();
+  }
+}
+
+/**
+ *@brief 交替显示延时和脉宽参数
+ *@param[in] dly 延时数，单位0.1ms
+ *@param[in] wtd 脉宽数，单位0.1ms
+ *
+ *两个参数都能以5位显示时按 @ref DISP_PAGE_STEP 分页交替显示，否则以“d #.#### P #.####”
+ *滚动显示，由刷新中断驱动
+ * @sa disp_puts 显示字符串
+ */
+void disp_play_pair(uint32_t dly,uint32_t wtd)
+{
+  char str[28];
+  uint8_t n;
+  if((dly < 100000UL) && (wtd < 100000UL))
+  {
+    disp_len = 0;
+    disp_play(dly);
+    for(n = 0;n < 5U;n++)
+    {
+      disp_line[4U - n] = disp_buf[n];
+    }
+    disp_play(wtd);
+    for(n = 0;n < 5U;n++)
+    {
+      disp_line[9U - n] = disp_buf[n];
+    }
+    disp_play(dly);
+    disp_mode = DISP_MODE_PAGE;
+    disp_pos = 0;
+    disp_frame = 0;
+    disp_len = 10U;
+  }
+  else
+  {
+    str[0] = 'd';
+    str[1] = ' ';
+    n = (uint8_t)(disp_fmt(dly,&str[2]) + 2U);
+    str[n] = ' ';
+    str[n + 1U] = 'P';
+    str[n + 2U] = ' ';
+    (void)disp_fmt(wtd,&str[n + 3U]);
+    disp_puts(str);
+  }
+}
+
+/**
+ *@brief 限时叠加显示字符串
+ *@param[in] str 不超过5个字符的字符串，“.”并入前一字符的dp段
+ *@param[in] frames 叠加显示时间，单位10ms刷新帧
+ *
+ *叠加显示期间显示缓冲区照常更新，到时后由刷新中断自动恢复显示缓冲区的内容，
+ *主程序不需等待
+ * @sa disp_puts 显示字符串
+ */
+void disp_overlay(const char str[],uint8_t frames)
+{
+  uint8_t n = 0;
+  uint8_t i;
+  uint8_t segs[5];
+  disp_ovl = 0;
+  for(i = 0;str[i] != '\0';i++)
+  {
+    if(('.' == str[i]) && (n > 0))
+    {
+      segs[n - 1U] |= DPOINT;
+    }
+    else if(n < 5U)
+    {
+      segs[n] = disp_segcode(str[i]);
+      n++;
+    }
+    else
+    {
+      break;
+    }
+  }
+  for(i = 0;i < 5U;i++)
+  {
+    disp_ovlbuf[i] = (i < n) ? segs[n - 1U - i] : 0;
+  }
+  disp_ovl = frames;
+}
@@ -0,0 +1,179 @@
+/**
+ * @brief 数码管显示后端：MAX7219显示控制器
+ * @file disp_max7219.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 5位数码管由MAX7219扫描，经硬件SPI（8MHz）连接：PB3/MOSI接DIN，PB5/SCK接CLK，PB2接LOAD，
+ * 数码管DIG0～DIG4对应个位～万位。节拍任务比较各位当前编码与已发送的编码，只发送有变化的位，
+ * 内容不变时没有SPI传输。定时器2中断不操作端口，只计数产生帧节拍，定时器2的周期不变，
+ * 内部触发及触发抑制计时不受影响。PB5同时是指示灯管脚，SPI工作时指示灯不受LED_PORT控制\n
+ * 函数列表
+ * @sa disp_hw_init 后端初始化
+ * @sa disp_hw_on 后端开显示
+ * @sa disp_hw_off 后端关显示
+ * @sa disp_task 后端节拍任务
+ */
+#include <avr/interrupt.h>
+#include "disp_hw.h"
+#include "prof.h"
+
+#define MAX_DIGIT0    0x01U /**<DIG0数据寄存器，DIG0～DIG7依次加1*/
+#define MAX_DECODE    0x09U /**<译码方式寄存器*/
+#define MAX_INTENSITY 0x0AU /**<亮度寄存器*/
+#define MAX_SCANLIMIT 0x0BU /**<扫描位数寄存器*/
+#define MAX_SHUTDOWN  0x0CU /**<关断寄存器*/
+#define MAX_TEST      0x0FU /**<显示测试寄存器*/
+
+static volatile uint8_t disp_slot;/**<帧内剩余中断次数*/
+static uint8_t disp_sent[5];/**<已发送的MAX7219编码，下标0为个位*/
+static uint8_t disp_dirty;/**<非零时下一次节拍全部重发*/
+#ifdef PROFILE
+static uint8_t prof_div = PROF_T2_DIV;/**<定时器2中断分频计数*/
+#endif
+
+/**
+ *@brief 定时器2比较匹配中断服务程序
+ *
+ *2ms一次，每5次为一帧，产生调度节拍及帧处理，不操作端口
+ */
+ISR(TIMER2_COMPA_vect)
+{
+  uint8_t slot;
+#ifdef PROFILE
+  /*统计时定时器2为125us中断，每PROF_T2_DIV次计数一次*/
+  PROF_TICK();
+  prof_div--;
+  if(0 != prof_div)
+  {
+    return;
+  }
+  prof_div = PROF_T2_DIV;
+#endif
+  PROF_ENTER();
+  slot = disp_slot - 1U;
+  if(0 == slot)
+  {
+    slot = 5U;
+    if(0 != disp_lit)
+    {
+      disp_frame_end();
+    }
+    else
+    {
+      sched_post(SCHED_EV_TICK);
+    }
+  }
+  disp_slot = slot;
+  PROF_EXIT(PROF_ID_T2A);
+}
+
+/**
+ *@brief 向MAX7219写一个寄存器
+ *@param[in] reg 寄存器地址
+ *@param[in] val 数据
+ *
+ *LOAD低电平期间移入16位，上升沿锁存
+ */
+static void max_write(uint8_t reg,uint8_t val)
+{
+  DISP_SPI_PORT &= ~_BV(DISP_SPI_LOAD);
+  SPDR = reg;
+  while(0 == (SPSR & _BV(SPIF)))
+  {
+    ;/*等待发送完毕*/
+  }
+  SPDR = val;
+  while(0 == (SPSR & _BV(SPIF)))
+  {
+    ;/*等待发送完毕*/
+  }
+  DISP_SPI_PORT |= _BV(DISP_SPI_LOAD);
+}
+
+/**
+ *@brief 七段编码转换为MAX7219不译码方式的编码
+ *@param[in] segs 七段编码，位0～6为a～g段，位7为dp段
+ *@return MAX7219编码，位7为dp段，位6～0为a～g段
+ */
+static uint8_t max_code(uint8_t segs)
+{
+  uint8_t i;
+  uint8_t ret;
+  ret = segs & DPOINT;
+  for(i = 0;i < 7U;i++)
+  {
+    if(0 != (segs & (uint8_t)(1U << i)))
+    {
+      ret |= (uint8_t)(0x40U >> i);
+    }
+  }
+  return ret;
+}
+
+/**
+ *@brief 后端初始化
+ *
+ *SPI主机方式0，8MHz；MAX7219不译码、扫描5位，处于关断状态
+ */
+void disp_hw_init(void)
+{
+  DISP_SPI_PORT |= _BV(DISP_SPI_LOAD);
+  DISP_SPI_PORT &= ~(_BV(DISP_SPI_MOSI)|_BV(DISP_SPI_SCK));
+  DISP_SPI_DDR |= _BV(DISP_SPI_LOAD)|_BV(DISP_SPI_MOSI)|_BV(DISP_SPI_SCK);
+  SPCR = _BV(SPE)|_BV(MSTR);
+  SPSR = _BV(SPI2X);
+  max_write(MAX_TEST,0);
+  max_write(MAX_DECODE,0);
+  max_write(MAX_SCANLIMIT,4U);
+  max_write(MAX_INTENSITY,DISP_INTENSITY);
+  max_write(MAX_SHUTDOWN,0);
+  disp_slot = 5U;
+  disp_dirty = 1U;
+}
+
+/**
+ *@brief 后端开显示
+ *
+ *退出关断状态，显示内容由节拍任务发送
+ */
+void disp_hw_on(void)
+{
+  max_write(MAX_SHUTDOWN,1U);
+}
+
+/**
+ *@brief 后端关显示
+ *
+ *进入关断状态，MAX7219保留显示数据
+ */
+void disp_hw_off(void)
+{
+  max_write(MAX_SHUTDOWN,0);
+}
+
+/**
+ *@brief 后端节拍任务
+ *@param ev 事件
+ *
+ *显示打开时逐位比较，只发送编码有变化的位
+ */
+void disp_task(uint8_t ev)
+{
+  uint8_t i;
+  uint8_t code;
+  if(0 != disp_lit)
+  {
+    for(i = 0;i < 5U;i++)
+    {
+      code = max_code(disp_seg(i));
+      if((0 != disp_dirty) || (code != disp_sent[i]))
+      {
+        max_write((uint8_t)(MAX_DIGIT0 + i),code);
+        disp_sent[i] = code;
+      }
+    }
+    disp_dirty = 0;
+  }
+}
@@ -0,0 +1,250 @@
+/**
+ * @brief 数码管显示后端：CPU动态扫描
+ * @file disp_mux.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 5位公阴数码管动态显示，管脚分配见board.h（缺省段码经PC0～PC5、PD3、PD4输出，位选经PB0、
+ * PB2～PB4、PD7输出）。定时器2比较匹配中断每2ms刷新一位，5位一帧；各端口的屏蔽码编译时算出，
+ * 关闭位选时每个端口一次读改写，g、dp段与同端口的位选合并写入\n
+ * 函数列表
+ * @sa disp_hw_init 后端初始化
+ * @sa disp_hw_on 后端开显示
+ * @sa disp_hw_off 后端关显示
+ * @sa disp_task 后端节拍任务
+ */
+#include <avr/interrupt.h>
+#include "disp_hw.h"
+#include "prof.h"
+
+volatile uint8_t disp_index;/**<当前显示的数位号0-4*/
+
+/**
+ *@brief 全部位选输出置1或清0，屏蔽码为0的端口不生成代码
+ *@param[in] set 非零置1（关闭），0清0
+ *@param[in] segd 0时跳过与g、dp段同端口的位选，由段码写入时合并处理
+ */
+static inline void disp_digit_port(uint8_t set,uint8_t segd)
+{
+  if((0U != DIGIT_MASK_B) && ((0 != segd) || (BOARD_ID_B != BOARD_ID(BOARD_SEG_G))))
+  {
+    if(0 != set)
+    {
+      PORTB |= (uint8_t)DIGIT_MASK_B;
+    }
+    else
+    {
+      PORTB &= (uint8_t)~DIGIT_MASK_B;
+    }
+  }
+  if((0U != DIGIT_MASK_D) && ((0 != segd) || (BOARD_ID_D != BOARD_ID(BOARD_SEG_G))))
+  {
+    if(0 != set)
+    {
+      PORTD |= (uint8_t)DIGIT_MASK_D;
+    }
+    else
+    {
+      PORTD &= (uint8_t)~DIGIT_MASK_D;
+    }
+  }
+}
+
+/**
+ *@brief 全部位选设置为输出或高阻输入
+ *@param[in] out 非零输出，0输入
+ */
+static inline void disp_digit_ddr(uint8_t out)
+{
+  if(0U != DIGIT_MASK_B)
+  {
+    if(0 != out)
+    {
+      DDRB |= (uint8_t)DIGIT_MASK_B;
+    }
+    else
+    {
+      DDRB &= (uint8_t)~DIGIT_MASK_B;
+    }
+  }
+  if(0U != DIGIT_MASK_D)
+  {
+    if(0 != out)
+    {
+      DDRD |= (uint8_t)DIGIT_MASK_D;
+    }
+    else
+    {
+      DDRD &= (uint8_t)~DIGIT_MASK_D;
+    }
+  }
+}
+#ifdef PROFILE
+static uint8_t prof_div = PROF_T2_DIV;/**<定时器2中断分频计数*/
+#endif
+
+/**
+ *
+ * @brief 定时器2比较匹配中断服务程序
+ *
+ * 2ms一次中断服务，关闭当前位显示，更新下一个数位并显示，5位数码管显示刷新率10ms
+ */
+ISR(TIMER2_COMPA_vect)
+{
+  uint8_t ind;
+  uint8_t scode;
+#ifdef PROFILE
+  /*统计时定时器2为125us中断，每PROF_T2_DIV次刷新一位*/
+  PROF_TICK();
+  prof_div--;
+  if(0 != prof_div)
+  {
+    return;
+  }
+  prof_div = PROF_T2_DIV;
+#endif
+  PROF_ENTER();
+  ind = disp_index;
+  if(0 == disp_lit)
+  {
+    ind++;
+    if(ind > 4U)
+    {
+      ind = 0;
+      sched_post(SCHED_EV_TICK);
+    }
+    disp_index = ind;
+    PROF_EXIT(PROF_ID_T2A);
+    return;
+  }
+
+  /*关闭当前数位显示，位选置1关闭；g、dp段端口上的位选在写段码时一并关闭*/
+  disp_digit_port(1U,0);
+
+  /*更新下一个数位显示编码，段置1数码管段亮*/
+  ind++;
+  if(ind > 4U)
+  {
+    ind = 0;
+  }
+  scode = disp_seg(ind);
+  SEGD_PORT = (uint8_t)((SEGD_PORT & (uint8_t)~SEGD_MASK) | ((scode >> (6U - SEGD_PIN6)) & SEGD_MASK) | DIGIT_SEGD);
+  SEGC_PORT = (scode & 0x3fU);
+
+  /*显示下一个数码，位选置0显示*/
+  if(0 == ind)
+  {
+    BOARD_CLR(BOARD_DIGIT0);
+  }
+  else if(1U == ind)
+  {
+    BOARD_CLR(BOARD_DIGIT1);
+  }
+  else if(2U == ind)
+  {
+    BOARD_CLR(BOARD_DIGIT2);
+  }
+  else if(3U == ind)
+  {
+    BOARD_CLR(BOARD_DIGIT3);
+  }
+  else if(4U == ind)
+  {
+    BOARD_CLR(BOARD_DIGIT4);
+  }
+  else
+  {
+    ;/* no deal with */
+  }
+
+  /*保存下一个数位号*/
+  disp_index = ind;
+
+  /*一帧刷新完毕*/
+  if(0 == ind)
+  {
+    disp_frame_end();
+  }
+  PROF_EXIT(PROF_ID_T2A);
+}
+
+/**
+ *@brief 后端初始化
+ *
+ *段端口、位选端口设置为高阻输入
+ */
+void disp_hw_init(void)
+{
+  /* 段端口初始化，高阻输入，缺省管脚分配（board.h）
+  ＊ PC0(A0)-->a
+  *  PC1(A1)-->b
+  *	 PC2(A2)-->c
+  *  PC3(A3)-->d
+  *  PC4(A4)-->e
+  *  PC5(A5)-->f
+  *  PD3(D3)-->g
+  *  PD4(D4)-->dp
+  */
+  SEGC_PORT = 0x00;
+  SEGC_DDR  = 0x00;
+  SEGD_PORT &= (uint8_t)~SEGD_MASK;
+  SEGD_DDR  &= (uint8_t)~SEGD_MASK;
+
+  /*位选端口初始化，DS0～DS4对应个位～万位，高阻输入，缺省管脚分配（board.h）
+  *DS4-->PD7(D7)
+  *DS3-->PB0(D8)
+  *DS2-->PB2(D10)
+  *DS1-->PB3(D11)
+  *DS0-->PB4(D12)
+  */
+  disp_digit_port(0,1U);
+  disp_digit_ddr(0);
+  disp_index = 0;
+}
+
+/**
+ *@brief 后端开显示
+ *
+ *从关闭状态打开时，位选先全部置1关闭，再由刷新中断逐位打开
+ */
+void disp_hw_on(void)
+{
+  if(0 == disp_lit)
+  {
+    disp_digit_port(1U,1U);
+  }
+
+  /*设置段端口为输出*/
+  SEGC_DDR  = 0x3fU;
+  SEGD_DDR  |= SEGD_MASK;
+
+  /*设置位选端口为输出*/
+  disp_digit_ddr(1U);
+}
+
+/**
+ *@brief 后端关显示
+ *
+ *段端口、位选端口设置为高阻输入，定时器2继续运行提供节拍
+ */
+void disp_hw_off(void)
+{
+  /*设置段端口为高阻输入*/
+  SEGC_DDR  = 0x00;
+  SEGD_DDR  &= (uint8_t)~SEGD_MASK;
+
+  /*设置位选端口为高阻输入*/
+  disp_digit_ddr(0);
+}
+
+/**
+ *@brief 后端节拍任务
+ *@param ev 事件
+ *
+ *动态扫描全部在刷新中断中完成，不需要主循环处理
+ */
+void disp_task(uint8_t ev)
+{
+  ;/*no deal with*/
+}
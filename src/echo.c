@@ -0,0 +1,157 @@
+/**
+ * @brief 响应测量统计
+ * @file echo.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 响应时间由 pulse.c 在脉冲后沿之后用定时器1输入捕获测量，与脉冲时间参数同一时基。本模块在
+ * 脉冲完成事件中取结果累计：最小、最大、平均值按设置的起点（触发或脉冲后沿）计算，直方图总是
+ * 以脉冲后沿为起点把测量窗口分为 @ref ECHO_BINS 格\n
+ * 函数列表：
+ *@sa echo_set() 设置响应测量，清除统计
+ *@sa echo_get_window() 取测量窗口
+ *@sa echo_task() 脉冲完成任务，累计测量结果
+ *@sa echo_report() 发送统计
+ */
+#include "echo.h"
+#include "pulse.h"
+#include "msg.h"
+
+static uint16_t echo_window;/**<测量窗口，ms，0不测量*/
+static uint8_t echo_ref;/**<计时起点， @ref ECHO_REF_EDGE 或 @ref ECHO_REF_TRIG */
+static uint16_t echo_cnt;/**<测得响应次数*/
+static uint16_t echo_timeouts;/**<超时次数*/
+static uint32_t echo_min;/**<最小值，us*/
+static uint32_t echo_max;/**<最大值，us*/
+static uint32_t echo_last;/**<最近一次，us*/
+static uint32_t echo_sum;/**<平均值的累计值，us*/
+static uint16_t echo_nsum;/**<echo_sum的累计次数*/
+static uint16_t echo_bin[ECHO_BINS];/**<直方图*/
+
+/**
+ *@brief 设置响应测量，清除统计
+ *@param[in] edge 响应沿， @ref PLS_EDGE_RISE 或 @ref PLS_EDGE_FALL
+ *@param[in] window_ms 测量窗口，ms，最长 @ref PLS_ECHO_MAX_MS ，0不测量
+ *@param[in] ref 计时起点， @ref ECHO_REF_EDGE 脉冲后沿， @ref ECHO_REF_TRIG 触发
+ */
+void echo_set(uint8_t edge,uint16_t window_ms,uint8_t ref)
+{
+  uint8_t i;
+  if(window_ms > PLS_ECHO_MAX_MS)
+  {
+    window_ms = PLS_ECHO_MAX_MS;
+  }
+  if(ECHO_MUX_NONE == ECHO_MUX)
+  {
+    window_ms = 0;/*开发板没有响应输入*/
+  }
+  pls_set_echo(edge,window_ms);
+  echo_window = window_ms;
+  echo_ref = ref;
+  echo_cnt = 0;
+  echo_timeouts = 0;
+  echo_min = 0xffffffffUL;
+  echo_max = 0;
+  echo_last = 0;
+  echo_sum = 0;
+  echo_nsum = 0;
+  for(i = 0;i < ECHO_BINS;i++)
+  {
+    echo_bin[i] = 0;
+  }
+}
+
+/**
+ *@brief 取测量窗口
+ *@return 测量窗口，ms，0不测量
+ */
+uint16_t echo_get_window(void)
+{
+  return echo_window;
+}
+
+/**
+ *@brief 脉冲完成任务，累计测量结果
+ *@param ev 事件
+ *
+ *计数到65535后不再累计。平均值的累计值将超过32位时累计值与其次数同时减半，平均值不变，
+ *此后的结果权重加倍
+ */
+void echo_task(uint8_t ev)
+{
+  uint32_t us;
+  uint32_t val;
+  uint8_t res;
+  uint8_t bin;
+  if(0 != echo_window)
+  {
+    res = pls_get_echo(&us);
+    if((PLS_ECHO_GOT == res) && (0xffffU != echo_cnt))
+    {
+      bin = (uint8_t)((us * ECHO_BINS) / ((uint32_t)echo_window * 1000UL));
+      if(bin >= ECHO_BINS)
+      {
+        bin = ECHO_BINS - 1U;
+      }
+      echo_bin[bin]++;
+      val = us;
+      if(ECHO_REF_TRIG == echo_ref)
+      {
+        val += pls_get_span();
+      }
+      echo_cnt++;
+      if(val > (0xffffffffUL - echo_sum))
+      {
+        echo_sum >>= 1;
+        echo_nsum >>= 1;
+      }
+      echo_sum += val;
+      echo_nsum++;
+      echo_last = val;
+      if(val < echo_min)
+      {
+        echo_min = val;
+      }
+      if(val > echo_max)
+      {
+        echo_max = val;
+      }
+    }
+    else if((PLS_ECHO_TIMEOUT == res) && (0xffffU != echo_timeouts))
+    {
+      echo_timeouts++;
+    }
+    else
+    {
+      ;/*no deal with*/
+    }
+  }
+}
+
+/**
+ *@brief 发送统计
+ *
+ *依次发送次数及超时次数；有测量结果时发送最小、最大值及平均值、最近一次；测量窗口及每格宽度；
+ *直方图中不为0的各格“格号,次数”
+ */
+void echo_report(void)
+{
+  uint8_t i;
+  uint32_t win;
+  msg_put_args(MSG_ECHO,echo_cnt,echo_timeouts);
+  if(0 != echo_cnt)
+  {
+    msg_put_args(MSG_ECHOMM,echo_min,echo_max);
+    msg_put_args(MSG_ECHOAVG,echo_sum / echo_nsum,echo_last);
+  }
+  win = (uint32_t)echo_window * 1000UL;
+  msg_put_args(MSG_ECHOWIN,win,win / ECHO_BINS);
+  for(i = 0;i < ECHO_BINS;i++)
+  {
+    if(0 != echo_bin[i])
+    {
+      msg_put_args(MSG_ECHOBIN,i,echo_bin[i]);
+    }
+  }
+}
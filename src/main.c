@@ -5,7 +5,8 @@
  *@version V1.2.0
  *@date 2016-10-24
  *
- *软件运行硬件环境：atmega328p或Arduino nano、Arduino pro mini、Arduino UNO等开发板\n
+ *软件运行硬件环境：atmega328p或Arduino nano、Arduino pro mini、Arduino UNO等开发板，由Makefile的BOARD选择，\n
+ *管脚分配见board.h\n
  *软件编译环境：avr-gcc-4.8.1或更新的版本\n
  *主要功能：从INT0管脚响应一个触发信号，以这一信号触发定时器1开始计时，在预定的时间改变OC1A管脚电平状态\n
  *产生预定的单脉冲信号。单脉冲发生器设置两个工作模式：自动模式和手动模式。自动模式是根据触发信号的输入\n
@@ -14,83 +15,153 @@
 */
 #include <avr/interrupt.h>
 #include <avr/wdt.h>
-#include <util/delay.h>
 #include "pulse.h"
 #include "disp.h"
 #include "uart.h"
+#include "sched.h"
+#include "rec.h"
+#include "cfg.h"
+#include "prof.h"
+#include "prog.h"
+#include "msg.h"
+#include "echo.h"
 
-/**
- *@var __flash const char prompt[80]
- *@brief 存在FLASH的提示字符串
-*/
-__flash const char pbrief[68] =
-"Single pulse generator\nV1.1.1\n\nPress 'm' or 'M' enter manual model\n";
+#define APP_WAIT   0x00U /**<等待触发端口恢复空闲电平*/
+#define APP_DELAY  0x01U /**<手动模式，接收延时数*/
+#define APP_WIDTH  0x02U /**<手动模式，接收脉宽数*/
+#define APP_ARMED  0x03U /**<已准备好，等待触发及单脉冲输出完成*/
+#define APP_LOAD   0x04U /**<程序模式，接收程序*/
+#define APP_ADDR   0x05U /**<接收本机串口地址*/
+#define APP_PARAM  0x06U /**<接收命令参数*/
 
-/**
- *@var __flash const char promptmanual[40]
- *@brief 存在FLASH的提示字符串
-*/
-__flash const char promptmanual[40] = "Press 'm' or 'M' enter manual model\n";
+#define APP_MODE_AUTO  0x00U /**<自动模式*/
+#define APP_MODE_MAN   0x01U /**<手动模式*/
+#define APP_MODE_PROG  0x02U /**<程序模式，时间参数同手动模式，由脉冲程序设置*/
 
-/**
- *@var __flash const char promptauto[40]
- *@brief 存在FLASH的提示字符串
-*/
-__flash const char promptauto[40] = "Press 'a' or 'A' return auto model\n";
+#define APP_DEBOUNCE   2U   /**<触发端口去抖动节拍数，20ms*/
+#define APP_BLINK      50U  /**<触发端口异常时“-----”闪烁半周期节拍数，0.5s*/
+#define APP_END_FRAMES 100U /**<“End”叠加显示帧数，1s*/
+#define APP_ITRIG_MS   1000U /**<内部触发周期缺省值，ms*/
+#define APP_PARAMS     3U   /**<命令参数最多个数*/
+#define APP_SETKEYS    "nsifw" /**<关闭触发后处理的设置命令*/
+#define APP_TRIG_EDGE  PLS_EDGE_FALL /**<触发沿缺省值，'f'命令设置并保存*/
+#define APP_TRIG_DIV   1U   /**<触发分频数缺省值，每APP_TRIG_DIV次触发产生一个脉冲*/
+#define APP_TRIG_HOLDOFF 0U /**<脉冲结束后的触发抑制时间缺省值，ms，0不抑制*/
+#define APP_PULSE_OUT  PLS_OUT_ISR /**<脉冲产生方式，PLS_OUT_HW时两个边沿都由定时器产生*/
+#define APP_OVR_POLICY PLS_OVR_DROP /**<溢出触发的处理方式，PLS_OVR_QUEUE排队，PLS_OVR_RESTART重新开始*/
+#define APP_ECHO_MS    100U /**<响应测量窗口缺省值，ms，'w'命令设置*/
+#define APP_ECHO_EDGE  PLS_EDGE_RISE /**<响应沿缺省值*/
+#define APP_ECHO_REF   ECHO_REF_EDGE /**<响应时间起点缺省值，ECHO_REF_TRIG从触发计时*/
+#define APP_TEST_BOOT  _BV(PORF) /**<以这些复位原因启动时在后台运行显示自检，0只在'd'命令时运行*/
+#define APP_TEST_FRAMES 100U /**<显示自检每步帧数，1s*/
+#define APP_TEST_STEPS 8U   /**<显示自检步数*/
 
-/**
- *@var __flash const char pdelay[40]
- *@brief 存在FLASH的延时输入提示字符串
-*/
-__flash const char pdelay[40] = "Delay number(5000-99999) unit 0.1ms:";
-
-/**
- *@var __flash const char pwidth[40]
- *@brief 存在FLASH的脉宽输入提示字符串
-*/
-__flash const char pwidth[40] = "Width number(4000-10000) unit 0.1ms:";
+static uint8_t app_state;/**<主控制状态*/
+static uint8_t app_mode;/**<工作模式*/
+static uint8_t app_ready;/**<触发端口已就绪，程序模式使用*/
+static uint8_t app_ticks;/**<当前状态的节拍计数*/
+static uint8_t app_debounce;/**<触发端口去抖动节拍计数*/
+static uint32_t app_delay;/**<手动模式接收的延时数*/
+static uint8_t app_strnum[8];/**<数字字符串缓冲区*/
+static uint8_t app_test;/**<显示自检剩余步数，0不在自检*/
+static uint8_t app_test_ticks;/**<显示自检当前步的节拍计数*/
+static uint8_t app_cmd;/**<正在接收参数的命令字符*/
+static uint8_t app_nparam;/**<已接收的参数个数*/
+static uint32_t app_param[APP_PARAMS];/**<命令参数，预置为当前值*/
+static uint16_t app_itrig_ms = APP_ITRIG_MS;/**<内部触发周期，ms*/
+static uint16_t app_itrig_shots;/**<内部触发次数，0连续触发*/
+static uint16_t app_echo_ms = APP_ECHO_MS;/**<响应测量窗口，ms*/
+static uint8_t app_echo_edge = APP_ECHO_EDGE;/**<响应沿*/
+static uint8_t app_echo_ref = APP_ECHO_REF;/**<响应时间起点*/
 
 /**
- *@var __flash const char pstart[20]
- *@brief 存在FLASH的开始输出脉冲提示字符串
-*/
-__flash const char pstart[20] = "Start generate\n";
+ * @brief 带参数命令的描述
+ */
+typedef struct app_cmd_def
+{
+  uint8_t key;               /**<命令字符*/
+  uint8_t msg[APP_PARAMS];   /**<各参数的提示消息，不足时以MSG_NUM结束*/
+}sappcmd_t;
 
 /**
- *@var __flash const char psucc[8]
- *@brief 存在FLASH的输出脉冲完成提示字符串
-*/
-__flash const char psucc[10] = "finished\n";
+ *@var __flash const sappcmd_t app_cmds[]
+ *@brief 带参数命令表，参数逐个由 uart_readnum() 非阻塞接收
+ */
+__flash const sappcmd_t app_cmds[] =
+{
+  { .key = 'i', .msg = { MSG_PERIOD, MSG_SHOTS, MSG_NUM, }, },
+  { .key = 'f', .msg = { MSG_EDGE, MSG_DIV, MSG_HOLDOFF, }, },
+  { .key = 'w', .msg = { MSG_WINDOW, MSG_ECHOEDGE, MSG_ECHOREF, }, },
+};
 
 /**
- *@var __flash const char pnreadyA[12]
- *@brief 存在FLASH的准备接收触发提示字符串
-*/
-__flash const char pnreadyA[12] = "No ready A\n";
+ *@brief 显示自检各步的叠加显示内容：“8.8.8.8.8.”闪亮3次，再显示“12345”和“67890”
+ */
+static const char *const app_test_str[APP_TEST_STEPS] =
+{
+  "8.8.8.8.8.","","8.8.8.8.8.","","8.8.8.8.8.","","12345","67890",
+};
 
-/**
- *@var __flash const char pnready[12]
- *@brief 存在FLASH的准备接收触发提示字符串
-*/
-__flash const char pnreadyM[12] = "No ready M\n";
+static void app_tick(uint8_t ev);
+static void app_trig(uint8_t ev);
+static void app_done(uint8_t ev);
+static void auto_arm(uint8_t ev);
+static void auto_cmd(uint8_t ev);
+static void man_start(uint8_t ev);
+static void man_cmd(uint8_t ev);
+static void prog_step(uint8_t ev);
+static void prog_cmd(uint8_t ev);
 
 /**
- *@var __flash const char pwaitting[16]
- *@brief 存在FLASH的等待输出脉冲完毕提示字符串
-*/
-__flash const char pwaitting[16] = "Waitting...\n";
+ *@var __flash const stask_t auto_tasks[]
+ *@brief 自动模式任务表
+ */
+__flash const stask_t auto_tasks[] =
+{
+  { .mask = SCHED_EV_TICK, .fn = app_tick, },
+  { .mask = SCHED_EV_TICK, .fn = cfg_task, },
+  { .mask = SCHED_EV_TICK, .fn = prog_task, },
+  { .mask = SCHED_EV_TICK, .fn = disp_task, },
+  { .mask = SCHED_EV_TRIG, .fn = app_trig, },
+  { .mask = SCHED_EV_DONE, .fn = echo_task, },
+  { .mask = SCHED_EV_DONE, .fn = app_done, },
+  { .mask = SCHED_EV_READY, .fn = auto_arm, },
+  { .mask = SCHED_EV_UART|SCHED_EV_TICK, .fn = auto_cmd, },
+};
 
 /**
- *@var __flash const char pauto[20]
- *@brief 存在FLASH的进入自动模式提示字符串
-*/
-__flash const char pauto[20] = "enter auto model!\n";
+ *@var __flash const stask_t man_tasks[]
+ *@brief 手动模式任务表
+ */
+__flash const stask_t man_tasks[] =
+{
+  { .mask = SCHED_EV_TICK, .fn = app_tick, },
+  { .mask = SCHED_EV_TICK, .fn = cfg_task, },
+  { .mask = SCHED_EV_TICK, .fn = prog_task, },
+  { .mask = SCHED_EV_TICK, .fn = disp_task, },
+  { .mask = SCHED_EV_TRIG, .fn = app_trig, },
+  { .mask = SCHED_EV_DONE, .fn = echo_task, },
+  { .mask = SCHED_EV_DONE, .fn = app_done, },
+  { .mask = SCHED_EV_READY, .fn = man_start, },
+  { .mask = SCHED_EV_UART|SCHED_EV_TICK, .fn = man_cmd, },
+};
 
 /**
- *@var __flash const char pman[26]
- *@brief 存在FLASH的进入自动模式提示字符串
-*/
-__flash const char pman[26] = "enter manual model!\n";
+ *@var __flash const stask_t prog_tasks[]
+ *@brief 程序模式任务表
+ */
+__flash const stask_t prog_tasks[] =
+{
+  { .mask = SCHED_EV_TICK, .fn = app_tick, },
+  { .mask = SCHED_EV_TICK, .fn = cfg_task, },
+  { .mask = SCHED_EV_TICK, .fn = disp_task, },
+  { .mask = SCHED_EV_TICK, .fn = prog_task, },
+  { .mask = SCHED_EV_TRIG, .fn = app_trig, },
+  { .mask = SCHED_EV_DONE, .fn = echo_task, },
+  { .mask = SCHED_EV_DONE, .fn = app_done, },
+  { .mask = SCHED_EV_READY|SCHED_EV_TICK, .fn = prog_step, },
+  { .mask = SCHED_EV_UART|SCHED_EV_TICK, .fn = prog_cmd, },
+};
 
 /**
  *@brief IO口上电初始化
@@ -110,329 +181,792 @@ void init_portb (void)
 }
 
 /**
- *@brief 主函数
+ *@brief 开始显示自检
  *
- * 主控制函数，
-*/
-int main(void)
+ *自检内容由显示刷新中断限时叠加显示，不影响触发及脉冲，到时后恢复正常显示
+ */
+static void app_test_start(void)
 {
-  uint8_t ch;/*串口接收字符/临时变量*/
-  uint8_t ind = 0; /*循环控制变量*/
-  uint32_t udelay; /*延时数*/
-  uint16_t uwidth; /*脉宽数*/
-  uint8_t strnum[8];/*数字字符串缓冲区*/
-
-  /*各模块初始化，波特率115200，开总中断,点亮LED指示灯，开启开门狗定时器，溢出时间0.5s*/
-  pls_init();
-  disp_init();
-  uart_init(115200UL);
-  sei();
-  //wdt_enable(WDTO_500MS);
-  uart_putsn_P(pbrief,68);
-  uart_write_times(500U);
-  uart_send('\n');
-  uart_send('\r');
+  app_test = APP_TEST_STEPS;
+  app_test_ticks = 0;
+  disp_on();
+}
 
-  /*闪亮显示“8.8.8.8.8."*/
-  disp_fill(0xffU);
-  for(ch = 0;ch < 3U;ch++)
+/**
+ *@brief 显示自检节拍处理，每步开始时叠加显示该步内容
+ */
+static void app_test_tick(void)
+{
+  if(0 != app_test)
   {
-    disp_on();
-    for(ind = 0;ind<100U;ind++)
+    if(0 == app_test_ticks)
     {
-        wdt_reset();
-        _delay_ms(10);
+      disp_overlay(app_test_str[APP_TEST_STEPS - app_test],APP_TEST_FRAMES);
     }
-    disp_off();
-    for(ind = 0;ind<100U;ind++)
+    app_test_ticks++;
+    if(app_test_ticks >= APP_TEST_FRAMES)
     {
-        wdt_reset();
-        _delay_ms(10);
+      app_test_ticks = 0;
+      app_test--;
     }
   }
+}
 
-  /*显示“12345”和“67890”*/
-  disp_play(12345U);
-  disp_on();
-  for(ind = 0;ind<100U;ind++)
+/**
+ *@brief 转换主控制状态并记录
+ *@param[in] sta 新状态
+ */
+static void app_set_state(uint8_t sta)
+{
+  app_state = sta;
+  app_ready = 0;
+  rec_put(REC_EV_STATE,sta);
+}
+
+/**
+ *@brief 设置工作模式并切换任务表
+ *@param[in] mod 工作模式， @ref APP_MODE_AUTO 等
+ *
+ *程序模式下脉冲模块按手动模式工作，保存的参数为进入程序模式时的参数
+ */
+static void app_set_mode(uint8_t mod)
+{
+  if((APP_MODE_AUTO != mod) && (0 == pls_get_mode()))
+  {
+    cfg_recall();
+  }
+  if(APP_MODE_PROG != mod)
   {
-    wdt_reset();
-    _delay_ms(10);
+    prog_stop();
   }
-  disp_play(67890U);
-  for(ind = 0;ind<100U;ind++)
+  app_mode = mod;
+  pls_set_mode((APP_MODE_AUTO == mod) ? 0 : 1U);
+  rec_put(REC_EV_MODE,mod);
+  cfg_save();
+  if(APP_MODE_AUTO == mod)
   {
-     wdt_reset();
-     _delay_ms(10);
+    sched_set_tasks(auto_tasks,sizeof(auto_tasks)/sizeof(auto_tasks[0]));
   }
+  else if(APP_MODE_MAN == mod)
+  {
+    sched_set_tasks(man_tasks,sizeof(man_tasks)/sizeof(man_tasks[0]));
+  }
+  else
+  {
+    sched_set_tasks(prog_tasks,sizeof(prog_tasks)/sizeof(prog_tasks[0]));
+  }
+  app_set_state(APP_WAIT);
+  app_ticks = 0;
+  app_debounce = 0;
+}
 
-  /*点亮状态指示灯，发送串口提示*/
-  ind = 0;
-  LED_PORT |= _BV(LED_PIN);
-  uart_flush();
-  TIMSK0 &= ~_BV(OCIE0A);
-  /*主控制流程*/
-  while(1)
+/**
+ *@brief 未在产生脉冲时关闭触发，以便切换模式
+ *@return 0正在产生脉冲或接收参数，不能切换；非零已关闭触发
+ *
+ *等待及已准备好状态下，确认未在产生脉冲后关闭触发，避免切换时恰好触发
+ */
+static uint8_t app_disarm(void)
+{
+  uint8_t ret = 0;
+  if((APP_WAIT == app_state) || (APP_ARMED == app_state))
+  {
+    ret = pls_disarm();
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+  return ret;
+}
+
+/**
+ *@brief 非阻塞接收本机串口地址
+ *
+ *接收完毕设置地址并保存，发送地址和同步角色，回到等待状态；只按回车或超出范围时不改变。
+ *多机方式下改变地址后仍为选中状态，主机随后以新地址选择本机
+ */
+static void app_addr(void)
+{
+  int8_t ret;
+  uint32_t addr;
+  ret = uart_readnum(app_strnum);
+  if(ret >= 0)
   {
-    if(pls_get_mode() == 0)
+    uart_send('\n');
+    uart_send('\r');
+    if(0 != ret)
     {
-      /*自动模式控制*/
-      if(_BV(SPARK_PIN) == (SPARK_PINS & _BV(SPARK_PIN)))
+      addr = pls_strtou(app_strnum);
+      if(addr <= UART_ADDR_MAX)
       {
-        _delay_ms(20);/*去抖动*/
-        if(_BV(SPARK_PIN) == (SPARK_PINS & _BV(SPARK_PIN)))
-        {
-          /*触发端口状态正常，熄灭指示灯，关显示，获取预产生的延时和脉宽参数*/
-          disp_off();
-          pls_set_param();
-
-          /*准备响应触发，显示时间参数*/
-          pls_set_sta(PULSE_STA_DELAY );
-          uart_putsn_P(pstart,20U);
-          uart_write_times(pls_get_delay());
-          uart_send(',');
-          uart_write_times(pls_get_width());
-          uart_send('\n');
-          uart_send('\r');
-          EIMSK |= _BV(INT0);
-          disp_on();
-          disp_play(pls_get_delay());
-          LED_PORT |= _BV(LED_PIN);
-
-          /*等待单脉冲输出完成*/
-          while(pls_get_sta() != PULSE_STA_COMPLETE)
-          {
-            if(pls_get_busy() != 0)
-            {
-            /*等待过程中交替显示时间参数，约 0.3秒显示延时和脉宽，闪亮指示灯*/
-              if(0 == ind)
-              {
-                disp_play(pls_get_delay());
-              }
-              else if( 50U == ind)
-              {
-                disp_play(pls_get_width());
-              }
-              else
-              {
-                ;/*no deal with*/
-              }
-              ind++;
-              if(100U == ind)
-              {
-                ind = 0;
-              }
-		    }
-            _delay_ms(10);
-            wdt_reset();
-          }
-          
-          /*单脉冲输出完毕，显示“End”*/
-          TCCR1B &= ~(_BV(CS12)|_BV(CS10));
-          EIMSK = 0;
-          disp_fill(0);
-          disp_filln(0x79U,2);
-          disp_filln(0x54U,1);
-          disp_filln(0x5eU,0);
-          disp_on();
-          /*1秒内若接收到手动模式命令，将进入手动模式*/
-          ind = 0;
-          do
-          {
-            if(uart_received() != 0)
-            {
-              LED_PORT &= ~_BV(LED_PIN);
-              ch = uart_getchar();
-              if(('m' == ch)||('M' == ch))
-              {
-                pls_set_mode(1U);
-                break;
-              }
-            }
-            _delay_ms(10);
-            wdt_reset();
-            ind++;
-          }  
-          while(ind <= 100U);
-          ind = 0;
-        }
+        uart_set_addr((uint8_t)addr);
+        cfg_save();
       }
-      else
+    }
+    msg_put_args(MSG_UNIT,uart_get_addr(),pls_get_sync());
+    app_set_state(APP_WAIT);
+  }
+}
+
+/**
+ *@brief 在命令字符串中查找字符
+ *@param[in] keys 命令字符串
+ *@param[in] ch 字符
+ *@return 0不在命令字符串中；非零在
+ */
+static uint8_t app_findkey(const char *keys,uint8_t ch)
+{
+  while(('\0' != *keys) && ((uint8_t)*keys != ch))
+  {
+    keys++;
+  }
+  return ('\0' != *keys) ? 1U : 0;
+}
+
+/**
+ *@brief 开放内部触发
+ *@param[in] period 周期，ms，0关闭
+ *@param[in] shots 次数，0连续触发
+ */
+static void app_itrig(uint16_t period,uint16_t shots)
+{
+  pls_set_itrig(period,(0 == shots) ? PLS_ITRIG_CONT : shots);
+}
+
+/**
+ *@brief 取正在接收的参数的提示消息
+ *@return 消息编号，MSG_NUM参数已接收完
+ */
+static uint8_t app_param_msg(void)
+{
+  uint8_t i;
+  uint8_t ret = MSG_NUM;
+  for(i = 0;i < (sizeof(app_cmds) / sizeof(app_cmds[0]));i++)
+  {
+    if((app_cmds[i].key == app_cmd) && (app_nparam < APP_PARAMS))
+    {
+      ret = app_cmds[i].msg[app_nparam];
+    }
+  }
+  return ret;
+}
+
+/**
+ *@brief 开始接收命令参数
+ *@param[in] key 命令字符
+ *
+ *各参数预置为当前值，只按回车时不改变
+ */
+static void app_param_start(uint8_t key)
+{
+  uint8_t div;
+  uint16_t holdoff;
+  app_cmd = key;
+  app_nparam = 0;
+  if('i' == key)
+  {
+    app_param[0] = app_itrig_ms;
+    app_param[1] = app_itrig_shots;
+  }
+  else if('f' == key)
+  {
+    app_param[0] = pls_get_trig(&div,&holdoff);
+    app_param[1] = div;
+    app_param[2] = holdoff;
+  }
+  else if('w' == key)
+  {
+    app_param[0] = app_echo_ms;
+    app_param[1] = app_echo_edge;
+    app_param[2] = app_echo_ref;
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+  LED_PORT &= ~_BV(LED_PIN);
+  msg_put(app_param_msg());
+  app_set_state(APP_PARAM);
+}
+
+/**
+ *@brief 命令参数接收完毕，设置并发送结果
+ *
+ *'i'按周期、次数开放内部触发，周期0关闭，次数0连续触发；'f'设置触发沿、分频数和抑制时间ms并保存，
+ *分频数超过255时取255；'w'设置响应测量窗口ms（0关闭，最长 @ref PLS_ECHO_MAX_MS ）、响应沿（0下降沿，
+ *1上升沿）和计时起点（0脉冲后沿，1触发），清除统计并发送。超出16位时取最大值
+ */
+static void app_param_end(void)
+{
+  uint8_t i;
+  uint8_t div;
+  uint16_t holdoff;
+  for(i = 0;i < APP_PARAMS;i++)
+  {
+    if(app_param[i] > 0xffffUL)
+    {
+      app_param[i] = 0xffffUL;
+    }
+  }
+  if('i' == app_cmd)
+  {
+    app_itrig_ms = (uint16_t)app_param[0];
+    app_itrig_shots = (uint16_t)app_param[1];
+    app_itrig(app_itrig_ms,app_itrig_shots);
+    msg_put_args(MSG_ITRIG,app_itrig_ms,app_itrig_shots);
+  }
+  else if('f' == app_cmd)
+  {
+    pls_set_trig((uint8_t)((app_param[0] > 0xffU) ? 0xffU : app_param[0]),
+                 (uint8_t)((app_param[1] > 0xffU) ? 0xffU : app_param[1]),(uint16_t)app_param[2]);
+    cfg_save();
+    msg_put_args(MSG_TRIG,pls_get_trig(&div,&holdoff),div);
+    msg_put_args(MSG_IGNORED,pls_get_ignored(),holdoff);
+  }
+  else if('w' == app_cmd)
+  {
+    app_echo_ms = (app_param[0] > PLS_ECHO_MAX_MS) ? PLS_ECHO_MAX_MS : (uint16_t)app_param[0];
+    app_echo_edge = (0 != app_param[1]) ? PLS_EDGE_RISE : PLS_EDGE_FALL;
+    app_echo_ref = (0 != app_param[2]) ? ECHO_REF_TRIG : ECHO_REF_EDGE;
+    echo_set(app_echo_edge,app_echo_ms,app_echo_ref);
+    echo_report();
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+}
+
+/**
+ *@brief 非阻塞接收命令参数
+ *
+ *每接收一个数提示下一个参数，全部接收完毕设置参数，回到等待状态
+ */
+static void app_param_read(void)
+{
+  int8_t ret;
+  uint8_t id;
+  ret = uart_readnum(app_strnum);
+  if(ret >= 0)
+  {
+    uart_send('\n');
+    uart_send('\r');
+    if(0 != ret)
+    {
+      app_param[app_nparam] = pls_strtou(app_strnum);
+    }
+    app_nparam++;
+    id = app_param_msg();
+    if(MSG_NUM != id)
+    {
+      msg_put(id);
+    }
+    else
+    {
+      app_param_end();
+      app_set_state(APP_WAIT);
+    }
+  }
+}
+
+/**
+ *@brief 接收模式切换命令
+ *@param[in] keys 切换命令字符串，小写，大写同样有效
+ *@return 0未接收到切换命令；非零已接收到的切换命令字符（小写），已关闭触发
+ *
+ *等待状态或已准备好状态下处理接收的字符；切换命令及 @ref APP_SETKEYS 在产生脉冲期间留在缓冲区，
+ *脉冲完成后再处理；'n'接收本机串口地址，'s'切换同步主从角色并发送地址和角色，'i'接收内部触发周期ms和
+ *次数（0连续）并开放内部触发，'f'接收触发沿、分频数和抑制时间ms并保存，'w'接收响应测量窗口ms、
+ *响应沿和计时起点并开始测量；'r'按已设置的周期、次数开关内部触发，'t'切换消息文本方式和代码方式，
+ *'?'发送状态（高4位工作模式，低4位主控制状态），'l'发送运行记录，'o'发送溢出触发次数、丢失次数及
+ *排队数、最长排队等待时间ms，以及抑制期内忽略的触发次数、抑制时间ms，'c'依次切换溢出触发的处理
+ *方式并发送，'e'按已设置的窗口开关响应测量，'h'发送响应测量统计，统计执行时间时'p'发送统计表，
+ *'d'在后台运行显示自检，其它字符丢弃
+ */
+static uint8_t app_modekey(const char *keys)
+{
+  uint8_t ret = 0;
+  uint8_t ch;
+  uint8_t div;
+  uint16_t holdoff;
+  if(APP_ADDR == app_state)
+  {
+    app_addr();
+  }
+  else if(APP_PARAM == app_state)
+  {
+    app_param_read();
+  }
+  else if((uart_received() != 0) && ((APP_WAIT == app_state) || (APP_ARMED == app_state)))
+  {
+    ch = uart_peek() | 0x20U;
+    if((0 != app_findkey(keys,ch)) || (0 != app_findkey(APP_SETKEYS,ch)))
+    {
+      if(app_disarm() != 0)
       {
-        /*触发端口电平状态异常*/
-        /*闪烁显示“-----“及指示灯*/
-        if( 0 == ind)
-        {
-          disp_fill(0x40U);
-          LED_PORT |= _BV(LED_PIN);
-          disp_on();
-        }
-        else if(50U == ind)
+        rec_put(REC_EV_CMD,uart_getchar());
+        if('n' == ch)
         {
           LED_PORT &= ~_BV(LED_PIN);
-          disp_off();
+          msg_put(MSG_ADDR);
+          app_set_state(APP_ADDR);
         }
-        else
+        else if('s' == ch)
         {
+          pls_set_sync((PLS_SYNC_SLAVE == pls_get_sync()) ? PLS_SYNC_MASTER : PLS_SYNC_SLAVE);
+          cfg_save();
+          msg_put_args(MSG_UNIT,uart_get_addr(),pls_get_sync());
+          LED_PORT &= ~_BV(LED_PIN);
+          app_set_state(APP_WAIT);
         }
-        ind++;
-        if (ind >= 100U)
+        else if(('i' == ch) || ('f' == ch) || ('w' == ch))
         {
-          ind = 0;
-          uart_putsn_P(pnreadyA,12U);
+          app_param_start(ch);
         }
-        
-          /*接收到手动模式命令，将进入手动模式*/
-        if(uart_received() != 0)
+        else
         {
-          LED_PORT &= ~_BV(LED_PIN);
-          ch = uart_getchar();
-          if(('m' == ch)||('M' == ch))
-          {
-            pls_set_mode(1U);
-            uart_putsn_P(pman,26U);
-            uart_flush();
-          }
+          ret = ch;
         }
       }
     }
     else
     {
-      /*手动模式*/
-      if(_BV(SPARK_PIN) == (SPARK_PINS & _BV(SPARK_PIN)))
+      rec_put(REC_EV_CMD,uart_getchar());
+      if('r' == ch)
       {
-        _delay_ms(20);
-        if(_BV(SPARK_PIN) == (SPARK_PINS & _BV(SPARK_PIN)))
-        {
-          /*触发端口状态正常，关显示，接收延时数*/
-          disp_off();
-          uart_putsn_P(pdelay,40U);
-          uart_send('\n');
-          uart_send('\r');
-          (void)uart_getnum(strnum);
-          udelay = pls_strtou(strnum);
-
-          /*接收脉宽数，设置时间参数*/
-          uart_putsn_P(pwidth,40U);
-          (void)uart_getnum(strnum);
-          uart_send('\n');
-          uart_send('\r');
-          uwidth = (uint16_t)pls_strtou(strnum);
-          pls_set_pulse(udelay,uwidth);
-          
-          /*准备响应触发，显示时间参数*/
-          uart_putsn_P(pstart,20U);
-          uart_write_times(pls_get_delay());
-          uart_send(',');
-          uart_write_times(pls_get_width());
-          uart_send('\n');
-          uart_send('\r');
-          EIMSK |= _BV(INT0);
-          pls_set_sta(PULSE_STA_DELAY );
-          disp_on();
-          disp_play(pls_get_delay());
-          uart_putsn_P(pwaitting,16);
-          LED_PORT |= _BV(LED_PIN);
-          
-          /*等待单脉冲输出完成*/          
-          while(pls_get_sta() != PULSE_STA_COMPLETE)
-          {
-            /*等待过程中交替显示时间参数，约 0.3秒显示延时和脉宽，闪亮指示灯*/
-            if(pls_get_busy() != 0)
-            {
-              if(0 == ind)
-              {
-                disp_play(pls_get_delay());
-              }
-              else if( 30U == ind)
-              {
-                disp_play(pls_get_width());
-              }
-              else
-              {
-                ;/*no deal with*/
-              }
-              ind++;
-              if(600U == ind)
-              {
-                ind = 0;
-              }
-            }
-             _delay_ms(10);
-            wdt_reset();
-         }
-          
-          /*单脉冲输出完毕，显示“End”*/
-          uart_putsn_P(psucc,8);
-          EIMSK = 0;
-          disp_fill(0);
-          disp_filln(0x79U,2);
-          disp_filln(0x54U,1);
-          disp_filln(0x5eU,0);
-          ind = 0;
-
-          /*1秒内若接收到自动模式命令，将进入自动模式*/
-          do
-          {
-            if(uart_received() != 0)
-            {
-              LED_PORT &= ~_BV(LED_PIN);
-              ch = uart_getchar();
-              if(('a' == ch)||('A' == ch))
-              {
-                pls_set_mode(0U);
-                break;
-              }
-            }
-            _delay_ms(10);
-            wdt_reset();
-            ind++;
-          }  
-          while(ind <= 100U);
-          ind = 0;          
-        }
+        app_itrig((0 == pls_get_itrig()) ? app_itrig_ms : 0,app_itrig_shots);
+      }
+      else if('t' == ch)
+      {
+        msg_set_mode((MSG_TEXT == msg_get_mode()) ? MSG_CODE : MSG_TEXT);
+      }
+      else if('?' == ch)
+      {
+        msg_put_args(MSG_STATUS,(uint8_t)((app_mode << 4) | app_state),0);
+      }
+      else if('l' == ch)
+      {
+        rec_dump(1U);
+      }
+      else if('o' == ch)
+      {
+        msg_put_args(MSG_OVERRUN,pls_get_overrun(),pls_get_dropped());
+        msg_put_args(MSG_QUEUE,pls_get_queued(),pls_get_qwait());
+        (void)pls_get_trig(&div,&holdoff);
+        msg_put_args(MSG_IGNORED,pls_get_ignored(),holdoff);
+      }
+      else if('c' == ch)
+      {
+        pls_set_ovr((uint8_t)(pls_get_ovr() + 1U));
+        msg_put_args(MSG_POLICY,pls_get_ovr(),0);
+      }
+      else if('e' == ch)
+      {
+        echo_set(app_echo_edge,(0 == echo_get_window()) ? app_echo_ms : 0,app_echo_ref);
+        echo_report();
+      }
+      else if('h' == ch)
+      {
+        echo_report();
+      }
+      else if('p' == ch)
+      {
+        PROF_DUMP();
+      }
+      else if('d' == ch)
+      {
+        app_test_start();
       }
       else
       {
-        /*触发端口电平状态异常*/
-        /*闪烁显示“-----“及指示灯*/
-        if( 0 == ind)
-        {
-          disp_fill(0x40U);
-          LED_PORT |= _BV(LED_PIN);
-        }
-        else if(50U == ind)
+        ;/*no deal with*/
+      }
+      if(APP_WAIT == app_state)
+      {
+        LED_PORT &= ~_BV(LED_PIN);
+      }
+    }
+  }
+  return ret;
+}
+
+/**
+ *@brief 装入时间参数，开放触发
+ *
+ *各模式共用，时间参数写入定时器，有变化时保存参数，发送并显示时间参数；程序模式的参数
+ *逐个脉冲变化，不保存
+ */
+static void app_arm(void)
+{
+  pls_set_param();
+  if(APP_MODE_PROG != app_mode)
+  {
+    cfg_save();
+  }
+  msg_put_args(MSG_START,pls_get_delay(),pls_get_width());
+  rec_put(REC_EV_ARM,pls_get_mode());
+  disp_on();
+  disp_play(pls_get_delay());
+  LED_PORT |= _BV(LED_PIN);
+  app_set_state(APP_ARMED);
+  pls_arm();
+}
+
+/**
+ *@brief 节拍任务
+ *@param ev 事件
+ *
+ *等待状态下触发端口空闲电平去抖动后产生就绪事件，有效电平时闪烁显示“-----”及指示灯；
+ *各状态下推进显示自检
+ */
+static void app_tick(uint8_t ev)
+{
+  app_test_tick();
+  if(APP_WAIT == app_state)
+  {
+    if(0 != pls_trig_idle())
+    {
+      /*去抖动*/
+      app_debounce++;
+      if(app_debounce >= APP_DEBOUNCE)
+      {
+        app_debounce = 0;
+        app_ticks = 0;
+        sched_post(SCHED_EV_READY);
+      }
+    }
+    else
+    {
+      /*触发端口电平状态异常*/
+      /*闪烁显示“-----“及指示灯*/
+      app_debounce = 0;
+      app_ready = 0;
+      if(0 == app_ticks)
+      {
+        disp_fill(0x40U);
+        LED_PORT |= _BV(LED_PIN);
+        disp_on();
+      }
+      else if(APP_BLINK == app_ticks)
+      {
+        LED_PORT &= ~_BV(LED_PIN);
+        disp_off();
+      }
+      else
+      {
+        ;/*no deal with*/
+      }
+      app_ticks++;
+      if(app_ticks >= (2U * APP_BLINK))
+      {
+        app_ticks = 0;
+        if(0 == pls_get_mode())
         {
-          LED_PORT &= ~_BV(LED_PIN);
-          disp_off();
+          msg_put(MSG_NREADYA);
         }
         else
         {
-          ;/*no deal with*/
-        }
-        ind++;
-        if (ind >= 100U)
-        {
-          ind = 0;
-          uart_putsn_P(pnreadyM,12U);
+          msg_put(MSG_NREADYM);
         }
+      }
+    }
+  }
+}
 
-          /*接收到自动模式命令，将进入自动模式*/
-        if(uart_received() != 0)
-        {
-          LED_PORT &= ~_BV(LED_PIN);
-          ch = uart_getchar();
-          if(('a' == ch)||('A' == ch))
-          {
-            pls_set_mode(0);
-            uart_putsn_P(pauto,20U);
-            uart_flush();
-          }
-        }
+/**
+ *@brief 触发任务，脉冲开始后由显示刷新中断交替显示延时和脉宽，同时预备下一组时间参数
+ *@param ev 事件
+ */
+static void app_trig(uint8_t ev)
+{
+  if(APP_ARMED == app_state)
+  {
+    disp_play_pair(pls_get_delay(),pls_get_width());
+    pls_prepare();
+  }
+}
+
+/**
+ *@brief 单脉冲完成任务，叠加显示“End”
+ *@param ev 事件
+ *
+ *“End”由显示刷新中断限时叠加显示，不等待，触发端口恢复后立即准备下一次触发；外部中断0保持
+ *允许，再次开放触发前的触发按溢出触发处理
+ */
+static void app_done(uint8_t ev)
+{
+  if(APP_ARMED == app_state)
+  {
+    if(0 != pls_get_mode())
+    {
+      msg_put(MSG_SUCC);
+    }
+    disp_overlay("End",APP_END_FRAMES);
+    disp_on();
+    app_set_state(APP_WAIT);
+    app_ticks = 0;
+    app_debounce = 0;
+  }
+}
+
+/**
+ *@brief 自动模式就绪任务，从FLASH取下一组时间参数并开放触发
+ *@param ev 事件
+ */
+static void auto_arm(uint8_t ev)
+{
+  if(APP_WAIT == app_state)
+  {
+    app_arm();
+  }
+}
+
+/**
+ *@brief 自动模式命令任务
+ *@param ev 事件
+ *
+ *未在产生脉冲时接收到'm'或'M'进入手动模式，'g'或'G'进入程序模式并从头执行程序，产生脉冲期间
+ *字符留在缓冲区
+ */
+static void auto_cmd(uint8_t ev)
+{
+  uint8_t key;
+  key = app_modekey("mg");
+  if('m' == key)
+  {
+    app_set_mode(APP_MODE_MAN);
+    msg_put(MSG_MAN);
+    uart_flush();
+  }
+  else if('g' == key)
+  {
+    app_set_mode(APP_MODE_PROG);
+    prog_start();
+    msg_put(MSG_PROG);
+    uart_flush();
+  }
+  else
+  {
+    ;/*no deal with*/
+  }
+}
+
+/**
+ *@brief 手动模式就绪任务，提示输入延时数
+ *@param ev 事件
+ *
+ *输入参数期间关闭触发，此时的触发不计为溢出，已排队的触发计为丢失
+ */
+static void man_start(uint8_t ev)
+{
+  if(APP_WAIT == app_state)
+  {
+    (void)pls_disarm();
+    disp_fill(0);
+    msg_put(MSG_DELAY);
+    app_set_state(APP_DELAY);
+  }
+}
+
+/**
+ *@brief 手动模式命令任务
+ *@param ev 事件
+ *
+ *非阻塞接收延时数和脉宽数，只按回车时沿用当前参数，接收完毕设置时间参数并开放触发；未在产生脉冲时
+ *接收到'a'或'A'返回自动模式，'g'或'G'进入程序模式并从头执行程序
+ */
+static void man_cmd(uint8_t ev)
+{
+  int8_t ret;
+  uint8_t key;
+  if(APP_DELAY == app_state)
+  {
+    ret = uart_readnum(app_strnum);
+    if(ret >= 0)
+    {
+      app_delay = (0 == ret) ? pls_get_delay() : pls_strtou(app_strnum);
+      msg_put(MSG_WIDTH);
+      app_set_state(APP_WIDTH);
+    }
+  }
+  else if(APP_WIDTH == app_state)
+  {
+    ret = uart_readnum(app_strnum);
+    if(ret >= 0)
+    {
+      uart_send('\n');
+      uart_send('\r');
+      if(0 == ret)
+      {
+        pls_set_pulse(app_delay,pls_get_width());
+      }
+      else
+      {
+        pls_set_pulse(app_delay,pls_strtou(app_strnum));
+      }
+      app_arm();
+      msg_put(MSG_WAITTING);
+    }
+  }
+  else
+  {
+    key = app_modekey("ag");
+    if('a' == key)
+    {
+      app_set_mode(APP_MODE_AUTO);
+      msg_put(MSG_AUTO);
+      uart_flush();
+    }
+    else if('g' == key)
+    {
+      app_set_mode(APP_MODE_PROG);
+      prog_start();
+      msg_put(MSG_PROG);
+      uart_flush();
+    }
+    else
+    {
+      ;/*no deal with*/
+    }
+  }
+}
+
+/**
+ *@brief 程序模式执行任务
+ *@param ev 事件
+ *
+ *触发端口就绪后每个节拍执行一次脉冲程序，直到程序要求开放触发：外部触发时开放触发，内部触发时
+ *开放触发并内部触发一次；脉冲完成后重新就绪，继续执行。程序结束时提示，停在等待状态
+ */
+static void prog_step(uint8_t ev)
+{
+  uint8_t act;
+  if(0 != (ev & SCHED_EV_READY))
+  {
+    app_ready = 1U;
+  }
+  if((APP_WAIT == app_state) && (0 != app_ready) && (0 != (ev & SCHED_EV_TICK)))
+  {
+    act = prog_run();
+    if(PROG_ACT_TRIG == act)
+    {
+      app_arm();
+    }
+    else if(PROG_ACT_EMIT == act)
+    {
+      app_arm();
+      pls_emit();
+    }
+    else if(PROG_ACT_END == act)
+    {
+      msg_put(MSG_PROGEND);
+    }
+    else
+    {
+      ;/*no deal with*/
+    }
+  }
+}
+
+/**
+ *@brief 程序模式命令任务
+ *@param ev 事件
+ *
+ *未在产生脉冲时接收到'a'或'A'返回自动模式，'m'或'M'进入手动模式，'g'或'G'从头执行程序，'u'或'U'
+ *停止执行并上传程序；上传期间串口字符全部作为程序接收，完毕后提示结果并回到等待状态
+ */
+static void prog_cmd(uint8_t ev)
+{
+  int8_t ret;
+  uint8_t key;
+  if(APP_LOAD == app_state)
+  {
+    ret = prog_load_poll(ev);
+    if(ret >= 0)
+    {
+      if(0 == ret)
+      {
+        msg_put(MSG_LOADOK);
       }
+      else
+      {
+        msg_put(MSG_LOADERR);
+      }
+      app_set_state(APP_WAIT);
+    }
+  }
+  else
+  {
+    key = app_modekey("amgu");
+    if('a' == key)
+    {
+      app_set_mode(APP_MODE_AUTO);
+      msg_put(MSG_AUTO);
+      uart_flush();
     }
-    wdt_reset();
-    _delay_ms(10);
+    else if('m' == key)
+    {
+      app_set_mode(APP_MODE_MAN);
+      msg_put(MSG_MAN);
+      uart_flush();
+    }
+    else if('g' == key)
+    {
+      prog_start();
+      app_set_state(APP_WAIT);
+    }
+    else if('u' == key)
+    {
+      prog_load_begin();
+      msg_put(MSG_LOAD);
+      app_set_state(APP_LOAD);
+    }
+    else
+    {
+      ;/*no deal with*/
+    }
+  }
+}
+
+/**
+ *@brief 主函数
+ *
+ * 主控制函数，初始化后由调度器按当前模式的任务表分派事件，无事件时CPU空闲睡眠
+*/
+int main(void)
+{
+  /*各模块初始化，波特率115200，开总中断,点亮LED指示灯，开启开门狗定时器，溢出时间0.5s*/
+  rec_init();
+  pls_init();
+  pls_set_trig(APP_TRIG_EDGE,APP_TRIG_DIV,APP_TRIG_HOLDOFF);
+  pls_set_out(APP_PULSE_OUT);
+  pls_set_ovr(APP_OVR_POLICY);
+  (void)cfg_init();
+  prog_init();
+  disp_init();
+  uart_init(115200UL);
+  sched_init();/*开中断前清除事件标志，之后中断置位的事件都由任务表处理*/
+  sei();
+  wdt_enable(WDTO_500MS);
+  msg_put_args(MSG_BRIEF,500U,0);
+
+  /*发送复位原因，看门狗复位时同时发送复位前的运行记录*/
+  rec_dump(0);
+
+  /*不等待显示自检，立即按当前模式装入任务表；上电复位时显示自检在后台运行*/
+  LED_PORT |= _BV(LED_PIN);
+  TIMSK0 &= ~_BV(OCIE0A);
+  app_set_mode((0 == pls_get_mode()) ? APP_MODE_AUTO : APP_MODE_MAN);
+  if(0 != (rec_get_cause() & APP_TEST_BOOT))
+  {
+    app_test_start();
+  }
+
+  /*主控制流程*/
+  while(1)
+  {
+    sched_run();
   }
   return 0;
 }
@@ -0,0 +1,149 @@
+/**
+ * @brief 消息输出
+ * @file msg.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 消息文本、参数类型由 msg.def 生成，存在FLASH。文本方式发送文本及参数，代码方式只发送代码字节
+ * 及二进制参数，每个事件的串口字节数减少约一个数量级\n
+ * 函数列表：
+ *@sa msg_put_args() 发送带参数的消息
+ *@sa msg_set_mode() 设置输出方式
+ *@sa msg_get_mode() 取输出方式
+ */
+#include "msg.h"
+#include "uart.h"
+
+#define MSG(id,arg,text) static const __flash char msg_s_##id[] = text;
+#include "msg.def"
+#undef MSG
+
+/**
+ *@var const __flash char * const __flash msg_text[]
+ *@brief 存在FLASH的消息文本表
+ */
+static const __flash char * const __flash msg_text[MSG_NUM] =
+{
+#define MSG(id,arg,text) msg_s_##id,
+#include "msg.def"
+#undef MSG
+};
+
+/**
+ *@var __flash const uint8_t msg_arg[]
+ *@brief 存在FLASH的消息参数类型表
+ */
+static __flash const uint8_t msg_arg[MSG_NUM] =
+{
+#define MSG(id,arg,text) arg,
+#include "msg.def"
+#undef MSG
+};
+
+static uint8_t msg_mode;/**<输出方式*/
+
+/**
+ *@brief 按低字节在前发送二进制数
+ *@param[in] num 预发送的数
+ *@param[in] n 字节数
+ */
+static void msg_write_bin(uint32_t num,uint8_t n)
+{
+  while(0 != n)
+  {
+    uart_send((uint8_t)num);
+    num >>= 8;
+    n--;
+  }
+}
+
+/**
+ *@brief 发送带参数的消息
+ *@param[in] id 消息编号， @ref MSG_BRIEF 等
+ *@param[in] a 第一个参数，无参数时不用
+ *@param[in] b 第二个参数， @ref MSG_ARG_TIME2 、 @ref MSG_ARG_NUM2 、 @ref MSG_ARG_DEC2 使用
+ */
+void msg_put_args(uint8_t id,uint32_t a,uint32_t b)
+{
+  uint8_t arg;
+  if(id < MSG_NUM)
+  {
+    arg = msg_arg[id];
+    if(MSG_CODE == msg_mode)
+    {
+      uart_send(MSG_TOKEN | id);
+      if(MSG_ARG_HEX1 == arg)
+      {
+        msg_write_bin(a,1U);
+      }
+      else if(MSG_ARG_NUM2 == arg)
+      {
+        msg_write_bin(a,2U);
+        msg_write_bin(b,2U);
+      }
+      else if(MSG_ARG_NONE != arg)
+      {
+        msg_write_bin(a,3U);
+        if((MSG_ARG_TIME2 == arg) || (MSG_ARG_DEC2 == arg))
+        {
+          msg_write_bin(b,3U);
+        }
+      }
+      else
+      {
+        ;/*no deal with*/
+      }
+    }
+    else
+    {
+      uart_puts_P(msg_text[id]);
+      if(MSG_ARG_HEX1 == arg)
+      {
+        uart_write_hex((uint8_t)a);
+      }
+      else if((MSG_ARG_NUM2 == arg) || (MSG_ARG_DEC2 == arg))
+      {
+        uart_write_dec(a);
+        uart_send(',');
+        uart_write_dec(b);
+      }
+      else if(MSG_ARG_NONE != arg)
+      {
+        uart_write_times(a);
+        if(MSG_ARG_TIME2 == arg)
+        {
+          uart_send(',');
+          uart_write_times(b);
+        }
+      }
+      else
+      {
+        ;/*no deal with*/
+      }
+      if(MSG_ARG_NONE != arg)
+      {
+        uart_send('\n');
+        uart_send('\r');
+      }
+    }
+  }
+}
+
+/**
+ *@brief 设置输出方式
+ *@param[in] mod @ref MSG_TEXT 文本方式， @ref MSG_CODE 代码方式
+ */
+void msg_set_mode(uint8_t mod)
+{
+  msg_mode = mod;
+}
+
+/**
+ *@brief 取输出方式
+ *@return @ref MSG_TEXT 文本方式， @ref MSG_CODE 代码方式
+ */
+uint8_t msg_get_mode(void)
+{
+  return msg_mode;
+}
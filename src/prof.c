@@ -0,0 +1,98 @@
+/**
+ * @brief 中断及任务执行时间统计
+ * @file prof.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 定义PROFILE编译时有效。各中断服务程序及调度任务入口、出口取时间戳，按统计项累计次数、最短、
+ * 最长和累计时间；串口命令'p'按“名称 次数 最短 最长 平均”逐行发送统计表，单位CPU周期，
+ * 发送后清零。统计本身的开销计入被统计的中断\n
+ * 函数列表：
+ *@sa prof_add() 累计一次执行时间
+ *@sa prof_dump() 发送统计表并清零
+ */
+#include "prof.h"
+#include "uart.h"
+
+#ifdef PROFILE
+volatile uint16_t prof_hi;/**<定时器2比较匹配中断次数，时间戳高位*/
+sprof_t prof_tab[PROF_NUM];/**<统计表*/
+
+/**
+ *@var __flash const char prof_name[PROF_NUM][6]
+ *@brief 存在FLASH的统计项名称
+ */
+__flash const char prof_name[PROF_NUM][6] =
+{
+  "INT0 ","T1A  ","T2A  ","URX  ","UDRE ","FMT  ","WRT  ",
+  "TSK0 ","TSK1 ","TSK2 ","TSK3 ","TSK4 ","TSK5 ","TSK6 ","TSK7 ","TSK8 "
+};
+
+/**
+ *@brief 累计一次执行时间
+ *@param[in] id 统计项， @ref PROF_ID_INT0 等
+ *@param[in] dt 执行时间，单位 @ref PROF_CYCLES 个CPU周期
+ */
+void prof_add(uint8_t id,uint16_t dt)
+{
+  uint8_t sreg;
+  sprof_t *p;
+  if(id < PROF_NUM)
+  {
+    p = &prof_tab[id];
+    sreg = SREG;
+    __builtin_avr_cli();
+    if(0xffffU != p->count)
+    {
+      if((0 == p->count) || (dt < p->min))
+      {
+        p->min = dt;
+      }
+      if(dt > p->max)
+      {
+        p->max = dt;
+      }
+      p->sum += dt;
+      p->count++;
+    }
+    SREG = sreg;
+  }
+}
+
+/**
+ *@brief 发送统计表并清零
+ *
+ *只发送有记录的统计项，时间换算为CPU周期
+ */
+void prof_dump(void)
+{
+  uint8_t i;
+  uint8_t sreg;
+  sprof_t s;
+  for(i = 0;i < PROF_NUM;i++)
+  {
+    sreg = SREG;
+    __builtin_avr_cli();
+    s = prof_tab[i];
+    prof_tab[i].count = 0;
+    prof_tab[i].min = 0;
+    prof_tab[i].max = 0;
+    prof_tab[i].sum = 0;
+    SREG = sreg;
+    if(0 != s.count)
+    {
+      uart_putsn_P(prof_name[i],6U);
+      uart_write_dec(s.count);
+      uart_send(' ');
+      uart_write_dec((uint32_t)s.min * PROF_CYCLES);
+      uart_send(' ');
+      uart_write_dec((uint32_t)s.max * PROF_CYCLES);
+      uart_send(' ');
+      uart_write_dec((s.sum / s.count) * PROF_CYCLES);
+      uart_send('\n');
+      uart_send('\r');
+    }
+  }
+}
+#endif
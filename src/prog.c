@@ -0,0 +1,372 @@
+/**
+ * @brief 脉冲程序解释器
+ * @file prog.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 程序映像在RAM中执行，上电时从EEPROM装入，校验错误时为空程序。解释器由主控制在可以开放触发
+ * 时调用，执行到需要脉冲、等待或结束为止，每次最多执行 @ref PROG_STEPS 条指令。上传的程序校验
+ * 正确后由节拍任务逐字节写入EEPROM，校验字节最后写入\n
+ * 函数列表：
+ *@sa prog_init() 初始化，从EEPROM装入程序
+ *@sa prog_start() 从头开始执行
+ *@sa prog_stop() 停止执行
+ *@sa prog_run() 执行到需要脉冲或等待为止
+ *@sa prog_load_begin() 开始接收程序
+ *@sa prog_load_poll() 接收程序
+ *@sa prog_task() 逐字节写入EEPROM
+ */
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "prog.h"
+#include "pulse.h"
+#include "uart.h"
+#include "sched.h"
+
+#define PROG_STA_STOP   0x00U /**<停止*/
+#define PROG_STA_RUN    0x01U /**<执行*/
+#define PROG_STA_WAIT   0x02U /**<等待时间*/
+
+#define PROG_LD_IDLE    0x00U /**<未接收*/
+#define PROG_LD_LEN     0x01U /**<接收长度*/
+#define PROG_LD_CODE    0x02U /**<接收程序*/
+#define PROG_LD_CRC     0x03U /**<接收校验*/
+#define PROG_LD_SAVE    0x04U /**<校验正确，等待写入EEPROM*/
+
+sprog_t prog_ee EEMEM;/**<EEPROM中的程序*/
+
+static sprog_t prog_img;/**<RAM中的程序*/
+static uint8_t prog_sta;/**<执行状态*/
+static uint8_t prog_pc;/**<下一条指令地址*/
+static uint16_t prog_wait;/**<等待剩余节拍数*/
+static uint8_t prog_sp;/**<循环嵌套层数*/
+static uint8_t prog_lpc[PROG_DEPTH];/**<循环体起始地址*/
+static uint8_t prog_lcnt[PROG_DEPTH];/**<循环剩余次数*/
+static uint8_t prog_ld;/**<接收状态*/
+static uint8_t prog_ldn;/**<已接收的程序字节数*/
+static uint8_t prog_ldidle;/**<接收间隔节拍计数*/
+static uint8_t prog_pending;/**<待写入EEPROM的字节数，0无写入*/
+
+/**
+ *@brief 计算程序映像的CRC-8校验
+ *@param[in] img 程序映像
+ *@return 长度及程序各字节的CRC-8校验
+ */
+static uint8_t prog_crc(const sprog_t *img)
+{
+  uint8_t i;
+  uint8_t crc;
+  crc = _crc8_ccitt_update(0,img->len);
+  for(i = 0;i < img->len;i++)
+  {
+    crc = _crc8_ccitt_update(crc,img->code[i]);
+  }
+  return crc;
+}
+
+/**
+ *@brief 初始化，从EEPROM装入程序
+ *
+ *长度超出或校验错误时为空程序，停止执行
+ */
+void prog_init(void)
+{
+  eeprom_read_block(&prog_img,&prog_ee,sizeof(sprog_t));
+  if((prog_img.len > PROG_SIZE) || (prog_crc(&prog_img) != prog_img.crc))
+  {
+    prog_img.len = 0;
+  }
+  prog_sta = PROG_STA_STOP;
+  prog_ld = PROG_LD_IDLE;
+  prog_pending = 0;
+}
+
+/**
+ *@brief 从头开始执行
+ */
+void prog_start(void)
+{
+  prog_pc = 0;
+  prog_sp = 0;
+  prog_wait = 0;
+  prog_sta = PROG_STA_RUN;
+}
+
+/**
+ *@brief 停止执行
+ */
+void prog_stop(void)
+{
+  prog_sta = PROG_STA_STOP;
+}
+
+/**
+ *@brief 取下一个程序字节
+ *@param[out] byte 程序字节
+ *@return 0超出程序长度；非零成功
+ */
+static uint8_t prog_fetch(uint8_t *byte)
+{
+  uint8_t ret = 0;
+  if(prog_pc < prog_img.len)
+  {
+    *byte = prog_img.code[prog_pc];
+    prog_pc++;
+    ret = 1U;
+  }
+  return ret;
+}
+
+/**
+ *@brief 执行到需要脉冲或等待为止
+ *@return 动作
+ *- @ref PROG_ACT_NONE 正在等待或已停止
+ *- @ref PROG_ACT_TRIG 时间参数已设置，开放外部触发
+ *- @ref PROG_ACT_EMIT 时间参数已设置，开放触发并内部触发一次
+ *- @ref PROG_ACT_END 执行到结束指令、程序末尾或出错，已停止
+ *
+ *可以开放触发时每个节拍调用一次。等待指令按调用次数计时；设置时间参数时即换算好寄存器
+ *映像，开放触发只需装入
+ */
+uint8_t prog_run(void)
+{
+  uint8_t act = PROG_ACT_NONE;
+  uint8_t op;
+  uint8_t a = 0;
+  uint8_t b = 0;
+  uint8_t c = 0;
+  uint8_t ok;
+  uint8_t n;
+
+  if(PROG_STA_WAIT == prog_sta)
+  {
+    if(0 != prog_wait)
+    {
+      prog_wait--;
+    }
+    if(0 == prog_wait)
+    {
+      prog_sta = PROG_STA_RUN;
+    }
+  }
+  for(n = 0;(n < PROG_STEPS) && (PROG_STA_RUN == prog_sta) && (PROG_ACT_NONE == act);n++)
+  {
+    ok = prog_fetch(&op);
+    if(0 == ok)
+    {
+      op = PROG_END;
+    }
+    switch(op)
+    {
+      case PROG_TRIG:
+        act = PROG_ACT_TRIG;
+        break;
+      case PROG_EMIT:
+        act = PROG_ACT_EMIT;
+        break;
+      case PROG_DELAY:
+        ok = prog_fetch(&a) && prog_fetch(&b) && prog_fetch(&c);
+        if(0 != ok)
+        {
+          pls_set_pulse(((uint32_t)c << 16) | ((uint16_t)b << 8) | a,pls_get_width());
+        }
+        break;
+      case PROG_WIDTH:
+        ok = prog_fetch(&a) && prog_fetch(&b);
+        if(0 != ok)
+        {
+          pls_set_pulse(pls_get_delay(),((uint16_t)b << 8) | a);
+        }
+        break;
+      case PROG_LOOP:
+        ok = prog_fetch(&a) && (prog_sp < PROG_DEPTH);
+        if(0 != ok)
+        {
+          prog_lpc[prog_sp] = prog_pc;
+          prog_lcnt[prog_sp] = a;
+          prog_sp++;
+        }
+        break;
+      case PROG_NEXT:
+        ok = (0 != prog_sp);
+        if(0 != ok)
+        {
+          prog_lcnt[prog_sp - 1U]--;
+          if(0 != prog_lcnt[prog_sp - 1U])
+          {
+            prog_pc = prog_lpc[prog_sp - 1U];
+          }
+          else
+          {
+            prog_sp--;
+          }
+        }
+        break;
+      case PROG_JIN:
+        ok = prog_fetch(&a) && prog_fetch(&b);
+        if(0 != ok)
+        {
+          c = (0 != (SPARK_PINS & _BV(SPARK_PIN))) ? 1U : 0;
+          if(c == a)
+          {
+            prog_pc = b;
+          }
+        }
+        break;
+      case PROG_WAIT:
+        ok = prog_fetch(&a) && prog_fetch(&b);
+        if(0 != ok)
+        {
+          prog_wait = ((uint16_t)b << 8) | a;
+          if(0 != prog_wait)
+          {
+            prog_sta = PROG_STA_WAIT;
+          }
+        }
+        break;
+      case PROG_JMP:
+        ok = prog_fetch(&a);
+        if(0 != ok)
+        {
+          prog_pc = a;
+        }
+        break;
+      default:
+        ok = 0;
+        break;
+    }
+    if(0 == ok)
+    {
+      /*结束指令、程序末尾、参数不全、循环嵌套错误或未知指令*/
+      prog_sta = PROG_STA_STOP;
+      act = PROG_ACT_END;
+    }
+  }
+  return act;
+}
+
+/**
+ *@brief 开始接收程序
+ *
+ *停止执行，放弃未写完的EEPROM写入，之后由 prog_load_poll() 接收
+ */
+void prog_load_begin(void)
+{
+  prog_sta = PROG_STA_STOP;
+  prog_pending = 0;
+  prog_ld = PROG_LD_LEN;
+  prog_ldn = 0;
+  prog_ldidle = 0;
+}
+
+/**
+ *@brief 接收程序
+ *@param ev 事件，节拍事件用于超时计时
+ *@return -1正在接收或正在写入EEPROM；0接收完毕、校验正确，校验字节已写入EEPROM；1长度错误、
+ *校验错误或超时
+ *
+ *处理缓冲区中已接收的字节，不等待。校验正确后由 prog_task() 写入，校验字节写完（EEPROM空闲）
+ *前不再读串口，也不计超时。失败时从EEPROM重新装入原来的程序
+ */
+int8_t prog_load_poll(uint8_t ev)
+{
+  int8_t ret = -1;
+  uint8_t ch;
+  if(PROG_LD_SAVE == prog_ld)
+  {
+    if((0 == prog_pending) && (0 != eeprom_is_ready()))
+    {
+      prog_ld = PROG_LD_IDLE;
+      ret = 0;
+    }
+  }
+  else
+  {
+    while((ret < 0) && (uart_received() != 0))
+    {
+      ch = uart_getchar();
+      prog_ldidle = 0;
+      if(PROG_LD_LEN == prog_ld)
+      {
+        prog_img.len = ch;
+        prog_ld = (0 == ch) ? PROG_LD_CRC : PROG_LD_CODE;
+        if(ch > PROG_SIZE)
+        {
+          ret = 1;
+        }
+      }
+      else if(PROG_LD_CODE == prog_ld)
+      {
+        prog_img.code[prog_ldn] = ch;
+        prog_ldn++;
+        if(prog_ldn >= prog_img.len)
+        {
+          prog_ld = PROG_LD_CRC;
+        }
+      }
+      else
+      {
+        prog_img.crc = ch;
+        ret = (prog_crc(&prog_img) == ch) ? 0 : 1;
+      }
+    }
+    if((ret < 0) && (0 != (ev & SCHED_EV_TICK)))
+    {
+      prog_ldidle++;
+      if(prog_ldidle >= PROG_LD_TIMEOUT)
+      {
+        ret = 1;
+      }
+    }
+    if(0 == ret)
+    {
+      prog_pending = (uint8_t)(1U + prog_img.len + 1U);
+      prog_ld = PROG_LD_SAVE;
+      ret = -1;
+    }
+    else if(ret > 0)
+    {
+      prog_init();
+    }
+    else
+    {
+      ;/*no deal with*/
+    }
+  }
+  return ret;
+}
+
+/**
+ *@brief 逐字节写入EEPROM的节拍任务
+ *@param ev 事件
+ *
+ *EEPROM空闲时写入一个字节后立即返回：先写长度和程序，校验字节最后写入
+ */
+void prog_task(uint8_t ev)
+{
+  uint8_t ind;
+  uint8_t *dst;
+  uint8_t val;
+  if((0 != prog_pending) && (0 != eeprom_is_ready()))
+  {
+    ind = (uint8_t)((1U + prog_img.len + 1U) - prog_pending);
+    if(0 == ind)
+    {
+      dst = &prog_ee.len;
+      val = prog_img.len;
+    }
+    else if(ind <= prog_img.len)
+    {
+      dst = &prog_ee.code[ind - 1U];
+      val = prog_img.code[ind - 1U];
+    }
+    else
+    {
+      dst = &prog_ee.crc;
+      val = prog_img.crc;
+    }
+    eeprom_update_byte(dst,val);
+    prog_pending--;
+  }
+}
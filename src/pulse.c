@@ -9,7 +9,8 @@
  * 函数列表
  *@sa pls_init() 初始化
  *@sa pls_set_pulse() 手动设置时间参数
- *@sa pls_set_param() 自动设置时间参数
+ *@sa pls_set_param() 开放触发前装入时间参数
+ *@sa pls_prepare() 预备下一组时间参数
  *@sa pls_set_mode()  设置工作模式
  *@sa pls_get_mode() 取工作模式
  *@sa pls_set_sta()   设置脉冲状态
@@ -18,9 +19,34 @@
  *@sa pls_get_delay() 取延时数
  *@sa pls_get_width() 取脉宽数
  *@sa pls_strtou()    数字字符串转整型数
+ *@sa pls_get_index() 取自动模式数组下标
+ *@sa pls_set_index() 设置自动模式数组下标
+ *@sa pls_set_itrig() 设置内部触发
+ *@sa pls_get_itrig() 取内部触发剩余次数
+ *@sa pls_emit() 内部触发一次
+ *@sa pls_set_trig() 设置触发条件
+ *@sa pls_trig_idle() 触发端口是否为空闲电平
+ *@sa pls_get_ignored() 取抑制期内忽略的触发次数
+ *@sa pls_set_out() 设置脉冲产生方式
+ *@sa pls_arm() 开放触发
+ *@sa pls_disarm() 关闭触发
+ *@sa pls_set_ovr() 设置溢出触发的处理方式
+ *@sa pls_get_ovr() 取溢出触发的处理方式
+ *@sa pls_get_overrun() 取溢出触发次数
+ *@sa pls_get_dropped() 取丢失的触发次数
+ *@sa pls_get_queued() 取排队等待的触发数
+ *@sa pls_get_qwait() 取排队触发的最长等待时间
+ *@sa pls_set_echo() 设置响应测量
+ *@sa pls_get_echo() 取响应测量结果
+ *@sa pls_get_span() 取触发到脉冲后沿的时间
+ *@sa pls_set_sync() 设置同步角色
+ *@sa pls_get_sync() 取同步角色
  */
 #include <avr/interrupt.h>
 #include "pulse.h"
+#include "sched.h"
+#include "rec.h"
+#include "prof.h"
 
 /**
  * @brief   延迟脉宽结构类型
@@ -32,6 +58,21 @@ typedef struct pls_data
   uint16_t wtd;/**<脉宽数，单位0.1ms*/
 }spls_t;
 
+/**
+ * @brief   定时器寄存器映像类型，开放触发时整体装入
+ * @struct  spreg_t
+ */
+typedef struct pls_reg
+{
+  uint16_t ocr1a;/**<延时数，OCR1A*/
+  uint16_t wtd;/**<脉宽数，延时到后装入OCR1A*/
+  uint8_t ocr0a;/**<时基分频数减1，OCR0A；99为0.1ms，199为0.2ms*/
+  uint16_t icr1;/**<硬件边沿方式的计数周期，ICR1，延时数加脉宽数减1*/
+  uint8_t tccr1a;/**<TCCR1A，比较输出方式及波形模式低位*/
+  uint8_t tccr1b;/**<TCCR1B波形模式高位，时钟在触发时启动*/
+  uint8_t timsk1;/**<TIMSK1，触发时允许的定时器1中断*/
+}spreg_t;
+
 volatile uint8_t pls_mode;/**<模式，0自动，非0手动*/
 
 /**
@@ -43,10 +84,46 @@ volatile uint8_t pls_mode;/**<模式，0自动，非0手动*/
 volatile uint8_t pls_sta;
 
 volatile uint8_t pls_index;/**<延迟脉宽结构类型数组下标*/
-volatile uint16_t delays;/**<预产生延迟时间数*/
-volatile uint16_t widths;/**<预产生脉冲时间数*/
-volatile uint8_t pls_pre;/**<时基分频数减1,时基频率2MHz*/
+
+/**
+ *寄存器映像的两个存储区。主程序只写pls_pub以外的一个，写完后翻转pls_pub发布；触发时中断
+ *记下pls_pub为pls_run，本次脉冲只读该存储区，主程序任何时刻发布都不会使中断读到不完整的映像
+ *@sa pls_publish()
+ */
+volatile spreg_t pls_bank[2];
+volatile uint8_t pls_pub;/**<已发布的存储区下标，下一次触发使用*/
+volatile uint8_t pls_run;/**<当前脉冲使用的存储区下标*/
+spreg_t pls_next;/**<预备的下一个脉冲的寄存器映像，只由主程序访问*/
+uint8_t pls_ready;/**<pls_next已预备好，0需按自动模式数组重新预备*/
+uint8_t pls_out;/**<脉冲产生方式， @ref PLS_OUT_ISR 或 @ref PLS_OUT_HW*/
+volatile uint16_t pls_itrig_period;/**<内部触发周期，单位 @ref PLS_ITRIG_US ，0关闭*/
+volatile uint16_t pls_itrig_cnt;/**<内部触发周期计数*/
+volatile uint16_t pls_itrig_left;/**<内部触发剩余次数， @ref PLS_ITRIG_CONT 连续*/
+volatile uint8_t pls_itrig_pend;/**<内部触发周期已到，等待开放触发*/
+volatile uint8_t pls_emit_pend;/**<等待一次单独的内部触发，不使用内部触发的周期和次数*/
+volatile uint8_t pls_edge;/**<触发沿， @ref PLS_EDGE_FALL 等*/
+volatile uint8_t pls_div;/**<每pls_div次触发产生一个脉冲*/
+volatile uint8_t pls_div_cnt;/**<触发分频计数*/
+volatile uint16_t pls_holdoff;/**<脉冲结束后的触发抑制时间，单位 @ref PLS_ITRIG_US ，0不抑制*/
+uint16_t pls_holdoff_ms;/**<设置的触发抑制时间，ms*/
+volatile uint16_t pls_holdoff_cnt;/**<触发抑制剩余时间*/
+volatile uint16_t pls_ignored;/**<抑制期内忽略的触发次数*/
 volatile uint8_t pls_busy;/**<产生脉冲的工作标志，0未开始，不忙；1在进行，忙*/
+volatile uint8_t pls_armed;/**<已开放触发，下一次有效触发产生脉冲；触发后清零*/
+volatile uint8_t pls_ovr;/**<溢出触发的处理方式， @ref PLS_OVR_DROP 等*/
+volatile uint16_t pls_overrun;/**<未开放触发时到达的有效触发次数*/
+volatile uint16_t pls_dropped;/**<丢失的溢出触发次数*/
+volatile uint16_t pls_clock;/**<排队时间戳时钟，单位 @ref PLS_ITRIG_US ，排队方式时计数*/
+volatile uint16_t pls_queue[PLS_QUEUE_SIZE];/**<排队触发的时间戳*/
+volatile uint8_t pls_qhead;/**<最早的排队触发的下标*/
+volatile uint8_t pls_qlen;/**<排队触发数*/
+volatile uint16_t pls_qwait;/**<排队触发的最长等待时间，单位 @ref PLS_ITRIG_US */
+volatile uint8_t pls_echo_tccr1b;/**<响应测量时的TCCR1B，捕获沿及时钟，0不测量*/
+volatile uint16_t pls_echo_win;/**<响应测量窗口，定时器1计数*/
+uint8_t pls_echo_half;/**<响应测量时定时器1每个计数的0.5us数*/
+volatile uint8_t pls_echo_res;/**<响应测量结果， @ref PLS_ECHO_NONE 等*/
+volatile uint16_t pls_echo_ticks;/**<脉冲后沿到响应的定时器1计数*/
+volatile uint8_t pls_sync;/**<同步角色， @ref PLS_SYNC_MASTER 或 @ref PLS_SYNC_SLAVE */
 /**
  * 自动模式延迟脉宽数据，共20组数据
  */
@@ -114,59 +191,417 @@ __flash const spls_t tims[20] =
   }
 };
 
+/**
+ * @brief 记下已发布的存储区，从中装入本次脉冲的定时器参数，定时器1由T1（D5）的上升沿计数
+ *
+ * 硬件边沿方式开放触发时定时器1已是快速PWM模式14，OCR1A双缓冲，写入要到BOTTOM才生效，而ICR1
+ * 立即生效。开放触发后发布的存储区须先回到一般模式写OCR1A，再设置模式，与 pls_restart() 相同
+ */
+static inline void pls_load(void)
+{
+    volatile spreg_t *img;
+    uint8_t run;
+    run = pls_pub;
+    pls_run = run;
+    img = &pls_bank[run];
+    OCR0A = img->ocr0a;
+    TCCR1B = 0;
+    TCCR1A = _BV(COM1A1);
+    OCR1A = img->ocr1a;
+    ICR1 = img->icr1;
+    TCCR1A = img->tccr1a;
+    TCCR1B = img->tccr1b|_BV(CS12)|_BV(CS11)|_BV(CS10);
+    TIMSK1 = img->timsk1;
+}
+
+/**
+ * @brief 脉冲开始：清除开放触发标志，置工作标志，产生触发事件
+ * @param[in] src 触发源，见 @ref REC_EV_TRIG
+ */
+static inline void pls_start(uint8_t src)
+{
+    pls_armed = 0;
+    LED_PORT &= ~_BV(LED_PIN);
+    pls_busy = 1U;
+    sched_post(SCHED_EV_TRIG);
+    rec_put(REC_EV_TRIG,src);
+}
+
+/**
+ * @brief 触发，外部触发和内部触发共用
+ * @param[in] src 触发源，0外部，1内部，2排队，见 @ref REC_EV_TRIG
+ *
+ * 启动定时器0,产生0.1ms或0.2ms时基，清除开放触发标志，外部中断0保持允许，此后的有效触发按
+ * 溢出触发处理。在中断服务程序或关中断时调用。定时器参数在定时器0启动后第一次比较匹配、
+ * 定时器1第一次计数前装入即可，不增加触发到启动时基的时间
+ */
+static inline void pls_fire(uint8_t src)
+{
+    TCCR0B = _BV(CS01);
+    pls_load();
+    pls_start(src);
+}
+
+/**
+ * @brief 从机开放触发：预先装入定时器参数，等待主机的时基
+ *
+ * 定时器1由主机的时基直接计数，主机触发后的第一个时基边沿即为同步时刻，各台的定时器1相位
+ * 只差T1输入同步的1～2个CPU周期；引脚变化中断只用于记下脉冲开始，中断响应时间不影响输出时刻
+ */
+static inline void pls_sync_arm(void)
+{
+    TCNT1 = 0;
+    TIFR1 = _BV(ICF1)|_BV(OCF1A)|_BV(OCF1B)|_BV(TOV1);
+    pls_load();
+    PCIFR = _BV(PCIF2);
+    PCICR |= _BV(PCIE2);
+}
+
+/**
+ * @brief 引脚变化中断2服务，从机的同步时刻
+ *
+ * 开放触发后D5的第一个边沿，即主机开始输出时基；只响应一次，脉冲期间关闭
+ */
+ISR (PCINT2_vect)
+{
+    PCICR &= ~_BV(PCIE2);
+    pls_start(4U);
+}
+
+/**
+ * @brief 开始触发抑制，脉冲结束时在中断服务程序中调用
+ */
+static inline void pls_holdoff_start(void)
+{
+    if(0 != pls_holdoff)
+    {
+        pls_holdoff_cnt = pls_holdoff;
+        TIMSK2 |= _BV(OCIE2B);
+    }
+}
+
+/**
+ * @brief 饱和计数
+ */
+static inline void pls_count(volatile uint16_t *cnt)
+{
+    if(0xffffU != *cnt)
+    {
+        (*cnt)++;
+    }
+}
+
+/**
+ * @brief 进行中的脉冲从头重新开始，在中断服务程序中调用
+ *
+ * 停止定时器，按一般模式比较匹配清零强制OC1A为低电平，计数器清零后按本次脉冲的存储区
+ * 重新装入延时数并启动，两种脉冲产生方式相同
+ */
+static inline void pls_restart(void)
+{
+    volatile spreg_t *img;
+    img = &pls_bank[pls_run];
+    TCCR0B = 0;
+    TCCR1B = 0;
+    TCCR1A = _BV(COM1A1);
+    TCCR1C = _BV(FOC1A);
+    TCNT0 = 0;
+    TCNT1 = 0;
+    OCR1A = img->ocr1a;
+    TCCR1A = img->tccr1a;
+    TIFR1 = _BV(OCF1A)|_BV(OCF1B)|_BV(TOV1);
+    pls_sta = PULSE_STA_DELAY;
+    TCCR0B = _BV(CS01);
+    TCCR1B = img->tccr1b|_BV(CS12)|_BV(CS11)|_BV(CS10);
+    TIMSK1 = img->timsk1;
+    LED_PORT &= ~_BV(LED_PIN);
+    sched_post(SCHED_EV_TRIG);
+    rec_put(REC_EV_TRIG,3U);
+}
+
+/**
+ * @brief 溢出触发：未开放触发时到达的有效触发，在中断服务程序中调用
+ *
+ * 按处理方式丢弃、带时间戳排队或重新开始进行中的脉冲，不能处理的计为丢失
+ */
+static inline void pls_overflow(void)
+{
+    uint8_t len;
+    pls_count(&pls_overrun);
+    len = pls_qlen;
+    if((PLS_OVR_QUEUE == pls_ovr) && (len < PLS_QUEUE_SIZE))
+    {
+        pls_queue[(uint8_t)(pls_qhead + len) & (PLS_QUEUE_SIZE - 1U)] = pls_clock;
+        pls_qlen = len + 1U;
+    }
+    else if((PLS_OVR_RESTART == pls_ovr) && (0 != pls_busy))
+    {
+        pls_restart();
+    }
+    else
+    {
+        pls_count(&pls_dropped);
+    }
+}
+
 /**
  * @brief 外部中断0服务
  * 
- * 触发端口下降沿响应，启动定时器0,产生0.1ms或0.2ms时基
+ * 按设置的触发沿响应，触发后电平与触发沿不符的视为毛刺不响应；抑制期内的触发只计数，
+ * 其余触发按分频数每pls_div次产生一个脉冲，未开放触发时按溢出触发处理
  */
 ISR (INT0_vect)
 {
-    if(_BV(SPARK_PIN) != (SPARK_PINS & _BV(SPARK_PIN)))
+    uint8_t lvl;
+    uint8_t cnt;
+    PROF_ENTER();
+    lvl = SPARK_PINS & _BV(SPARK_PIN);
+    if(((PLS_EDGE_FALL == pls_edge) && (0 != lvl)) || ((PLS_EDGE_RISE == pls_edge) && (0 == lvl)))
+    {
+        ;/*毛刺*/
+    }
+    else if(0 != pls_holdoff_cnt)
+    {
+        if(0xffffU != pls_ignored)
+        {
+            pls_ignored++;
+        }
+    }
+    else
+    {
+        cnt = pls_div_cnt + 1U;
+        if(cnt >= pls_div)
+        {
+            cnt = 0;
+            if(0 != pls_armed)
+            {
+                pls_fire(0);
+            }
+            else
+            {
+                pls_overflow();
+            }
+        }
+        pls_div_cnt = cnt;
+    }
+    PROF_EXIT(PROF_ID_INT0);
+}
+
+/**
+ * @brief 定时器2比较匹配B中断服务，内部触发及触发抑制计时
+ *
+ * 与显示刷新同一周期，每 @ref PLS_ITRIG_US 一次。抑制时间递减；内部触发周期到时置等待标志，
+ * 已开放触发且不在抑制期时按外部触发同样的路径触发，否则等到条件满足后的第一次中断； pls_emit()
+ * 要求的单次触发同样处理。排队方式时计数排队时间戳时钟。内部触发次数用完、没有单次触发、抑制期
+ * 结束且不是排队方式时关闭本中断
+ */
+ISR (TIMER2_COMPB_vect)
+{
+    uint16_t cnt;
+    pls_clock++;
+    if(0 != pls_holdoff_cnt)
+    {
+        pls_holdoff_cnt--;
+    }
+    if(0 != pls_itrig_left)
+    {
+        cnt = pls_itrig_cnt;
+        if(0 != cnt)
+        {
+            cnt--;
+        }
+        if(0 == cnt)
+        {
+            pls_itrig_pend = 1U;
+            cnt = pls_itrig_period;
+        }
+        pls_itrig_cnt = cnt;
+    }
+    /*周期触发优先，单次触发等下一次；只有一处触发，最坏执行时间只计一次脉冲开始*/
+    if((0 == pls_holdoff_cnt) && (0 != pls_armed) && ((0 != pls_itrig_pend) || (0 != pls_emit_pend)))
+    {
+        if(0 != pls_itrig_pend)
+        {
+            pls_itrig_pend = 0;
+            if(PLS_ITRIG_CONT != pls_itrig_left)
+            {
+                pls_itrig_left--;
+            }
+        }
+        else
+        {
+            pls_emit_pend = 0;
+        }
+        pls_fire(1U);
+    }
+    if((0 == pls_itrig_left) && (0 == pls_emit_pend) && (0 == pls_holdoff_cnt) && (PLS_OVR_QUEUE != pls_ovr))
+    {
+        TIMSK2 &= ~_BV(OCIE2B);
+    }
+}
+
+/**
+ * @brief 脉冲完成，停止时基和定时器1，在中断服务程序中调用
+ */
+static inline void pls_done(void)
+{
+    TCCR0B = 0;
+    TCCR1B &= ~(_BV(CS11)|_BV(CS12)|_BV(CS10));
+    LED_PORT &= ~_BV(LED_PIN);
+    pls_sta = PULSE_STA_COMPLETE;
+    pls_busy = 0;
+    TCNT1 = 0;
+    TCNT0 = 0;
+    TIMSK1 = 0;
+    pls_holdoff_start();
+    sched_post(SCHED_EV_DONE);
+    rec_put(REC_EV_DONE,0);
+}
+
+/**
+ * @brief 开始响应测量，脉冲后沿的中断服务程序中调用
+ *
+ * 定时器1改为一般模式，断开OC1A（输出保持低电平），清零后按测量窗口选择的分频由内部时钟计数，
+ * 输入捕获模拟比较器输出的响应沿，OCR1B为窗口结束。计时从本中断开始，比脉冲后沿晚中断响应时间
+ */
+static inline void pls_echo_start(void)
+{
+    TCCR1B = 0;
+    TCCR0B = 0;
+    TCCR1A = 0;
+    TCNT1 = 0;
+    OCR1B = pls_echo_win;
+    TIFR1 = _BV(ICF1)|_BV(OCF1A)|_BV(OCF1B)|_BV(TOV1);
+    TCCR1B = pls_echo_tccr1b;
+    TIMSK1 = _BV(ICIE1)|_BV(OCIE1B);
+    pls_sta = PULSE_STA_ECHO;
+    LED_PORT &= ~_BV(LED_PIN);
+}
+
+/**
+ * @brief 脉冲后沿，允许响应测量时开始测量，否则脉冲完成
+ */
+static inline void pls_end(void)
+{
+    if(0 != pls_echo_tccr1b)
     {
-        TCCR0B = _BV(CS01);
-        TCCR1B |= _BV(CS12)|_BV(CS11)|_BV(CS10);
-        TIMSK1 |= _BV(OCIE1A);
-        EIMSK &= ~_BV(INT0);
-        LED_PORT &= ~_BV(LED_PIN);
-        pls_busy = 1U;
+        pls_echo_start();
     }
+    else
+    {
+        pls_done();
+    }
+}
+
+/**
+ * @brief 响应测量结束，记录结果后脉冲完成
+ * @param[in] res @ref PLS_ECHO_GOT 或 @ref PLS_ECHO_TIMEOUT
+ */
+static inline void pls_echo_end(uint8_t res)
+{
+    pls_echo_ticks = ICR1;
+    pls_echo_res = res;
+    pls_done();
+}
+
+/**
+ * @brief 定时器1输入捕获中断服务，测得响应
+ */
+ISR (TIMER1_CAPT_vect)
+{
+  pls_echo_end(PLS_ECHO_GOT);
 }
 
 /**
  * @brief 定时器1比较匹配中断服务
  * 
- * 定时器1CTC模式，匹配时改变OC1A管脚的状态产生预期脉冲
+ * 定时器1CTC模式，匹配时改变OC1A管脚的状态产生预期脉冲；延时到后装入脉宽数
  */
 ISR (TIMER1_COMPA_vect)
 {
+  PROF_ENTER();
   if(PULSE_STA_DELAY == pls_sta)
   {
     pls_sta = PULSE_STA_WIDTH;
-    OCR1A = widths;
+    OCR1A = pls_bank[pls_run].wtd;
     LED_PORT |= _BV(LED_PIN);
   }
-  else if(PULSE_STA_WIDTH == pls_sta)
+  else
   {
-    TCCR0B = 0;
-    TCCR1B &= ~(_BV(CS11)|_BV(CS12)|_BV(CS10));
-    LED_PORT &= ~_BV(LED_PIN);
-    pls_sta = PULSE_STA_COMPLETE;
-    pls_busy = 0;
-    TCNT1 = 0;
-    TCNT0 = 0;
-    TIMSK1 = 0;
+    pls_end();
+  }
+  PROF_EXIT(PROF_ID_T1A);
+}
+
+/**
+ * @brief 定时器1比较匹配B中断服务，硬件边沿方式的脉冲结束
+ *
+ * 快速PWM模式14，TCNT1到OCR1A时OC1A置位、到TOP后回到BOTTOM时清零，两个边沿都由定时器产生；
+ * OCR1B为0，回到BOTTOM即匹配，此时脉冲已结束，停止定时器，不影响边沿时刻。响应测量时为测量窗口结束
+ */
+ISR (TIMER1_COMPB_vect)
+{
+  if(PULSE_STA_ECHO == pls_sta)
+  {
+    pls_echo_end(PLS_ECHO_TIMEOUT);
   }
   else
   {
-    TCCR0B = 0;
-    TCCR1B &= ~(_BV(CS11)|_BV(CS12)|_BV(CS10));
-    LED_PORT &= ~_BV(LED_PIN);
-    pls_sta = PULSE_STA_COMPLETE;
-    pls_busy = 0;
-    TCNT1 = 0;
-    TCNT0 = 0;
-    TIMSK1 = 0;
+    pls_end();
+  }
+}
+
+/**
+ *@brief 按脉冲产生方式补全寄存器映像
+ *@param[in,out] img 已设置延时数、脉宽数、时基的映像
+ *
+ *中断方式为CTC模式，OC1A比较匹配翻转，延时到后在中断中装入脉宽数；硬件边沿方式为快速PWM模式14，
+ *TOP为ICR1，OC1A匹配置位、BOTTOM清零，延时数加脉宽数超过16位时改用0.2ms时基
+ */
+static void pls_image(spreg_t *img)
+{
+  if(PLS_OUT_HW == pls_out)
+  {
+    if(((uint32_t)img->ocr1a + img->wtd) > 65536UL)
+    {
+      img->ocr1a /= 2U;
+      img->wtd /= 2U;
+      img->ocr0a = 199U;
+    }
+    img->icr1 = (uint16_t)(img->ocr1a + img->wtd - 1U);
+    img->tccr1a = _BV(COM1A1)|_BV(COM1A0)|_BV(WGM11);
+    img->tccr1b = _BV(WGM13)|_BV(WGM12);
+    img->timsk1 = _BV(OCIE1B);
+  }
+  else
+  {
+    img->icr1 = 0;
+    img->tccr1a = _BV(COM1A0);
+    img->tccr1b = _BV(WGM12);
+    img->timsk1 = _BV(OCIE1A);
+  }
+}
+
+/**
+ *@brief 发布预备区的寄存器映像，下一次触发使用
+ *@return 非零已发布；0另一个存储区正被进行中的脉冲使用（本次脉冲期间已发布过），未发布
+ *
+ *写入未发布的存储区后翻转下标，不关中断。触发时记下的存储区与已发布的相同时，另一个存储区
+ *没有读者；不同时说明本次脉冲期间已发布过，须等脉冲完成
+ */
+static uint8_t pls_publish(void)
+{
+  uint8_t pub;
+  uint8_t ret = 0;
+  pub = pls_pub;
+  if((0 == pls_busy) || (pls_run == pub))
+  {
+    pub ^= 1U;
+    pls_bank[pub] = pls_next;
+    pls_pub = pub;
+    ret = 1U;
   }
+  return ret;
 }
 
 /**
@@ -174,11 +609,29 @@ ISR (TIMER1_COMPA_vect)
  */
 void pls_init(void)
 {
-  /*触发端口及外部中断0初始化*/
+  /*触发端口及外部中断0初始化，下降沿触发*/
   SPARK_DDR &= ~_BV(SPARK_PIN);
   SPARK_PORT |= _BV(SPARK_PIN);
   EICRA = _BV(ISC01);
   EIMSK = 0;
+  pls_edge = PLS_EDGE_FALL;
+  pls_div = 1U;
+  pls_div_cnt = 0;
+  pls_holdoff = 0;
+  pls_holdoff_ms = 0;
+  pls_holdoff_cnt = 0;
+  pls_ignored = 0;
+  pls_armed = 0;
+  pls_ovr = PLS_OVR_DROP;
+  pls_overrun = 0;
+  pls_dropped = 0;
+  pls_qlen = 0;
+  pls_qwait = 0;
+  pls_echo_tccr1b = 0;
+  pls_echo_res = PLS_ECHO_NONE;
+  pls_sync = PLS_SYNC_MASTER;
+  PCICR &= ~_BV(PCIE2);
+  PCMSK2 = _BV(CLKIN_PCINT);
 
   /*脉冲输出端口初始化*/
   PULSE_DDR |= _BV(PULSE_PIN);
@@ -208,9 +661,20 @@ void pls_init(void)
   pls_mode = 0;
   pls_index = 0U;
   pls_busy = 0;
-  pls_pre = 99U;
-  delays = 5000U;
-  widths = 5000U;
+  pls_next.ocr0a = 99U;
+  pls_next.ocr1a = 5000U;
+  pls_next.wtd = 5000U;
+  pls_out = PLS_OUT_ISR;
+  pls_image(&pls_next);
+  pls_bank[0] = pls_next;
+  pls_pub = 0;
+  pls_run = 0;
+  pls_ready = 0;
+  pls_itrig_period = 0;
+  pls_itrig_cnt = 0;
+  pls_itrig_left = 0;
+  pls_itrig_pend = 0;
+  pls_emit_pend = 0;
 }
 
 /**
@@ -218,44 +682,52 @@ void pls_init(void)
   *@param[in] dly 预设置的延时数，单位0.1ms
   *@param[in] wtd 预设置的脉宽数，单位0.1ms
   *
-  *延时数范围5000～99999，脉宽数范围4000～10000。仅在手动模式进行设置
-  *@sa pls_set_param() 自动设置时间参数
+  *延时数范围5000～99999，脉宽数范围4000～10000，超出范围时取边界值；延时数大于65535时时基为0.2ms，
+  *延时、脉宽按偶数取整。换算为寄存器映像存入预备区并发布，已开放触发时下一次触发即按新参数产生
+  *脉冲；脉冲进行期间已发布过时留在预备区，下一次开放触发时发布。仅在手动模式进行设置
+  *@sa pls_set_param() 开放触发前装入时间参数
  */
-void pls_set_pulse(uint32_t dly,uint16_t wtd)
+void pls_set_pulse(uint32_t dly,uint32_t wtd)
 {
+  spreg_t img;
   if(0 != pls_mode )
   {
+    /*先按32位限幅，避免截为16位时回绕*/
+    if(wtd > 10000UL)
+    {
+      wtd = 10000UL;
+    }
     if(dly < 65536UL)
     {
-      delays = (uint16_t)dly;
-      widths = wtd;
-      if(delays < 5000U)
+      img.ocr1a = (uint16_t)dly;
+      img.wtd = (uint16_t)wtd;
+      if(img.ocr1a < 5000U)
       {
-        delays = 5000U;
+        img.ocr1a = 5000U;
       }
-      pls_pre = 99U;
+      img.ocr0a = 99U;
     }
     else if(dly < 100000UL)
     {
-      delays = (uint16_t)(dly / 2);
-      widths = wtd / 2;
-      pls_pre = 199U;
+      img.ocr1a = (uint16_t)(dly / 2);
+      img.wtd = (uint16_t)(wtd / 2);
+      img.ocr0a = 199U;
     }
     else
     {
-      delays = 49999UL;
-      widths = wtd / 2;
-      pls_pre = 199U;
+      img.ocr1a = 49999U;
+      img.wtd = (uint16_t)(wtd / 2);
+      img.ocr0a = 199U;
     }
-    if(pls_pre > 100U)
+    if(img.ocr0a > 100U)
     {
-    	if(widths > 5000U)
+    	if(img.wtd > 5000U)
     	{
-    		widths = 5000U;
+    		img.wtd = 5000U;
     	}
-    	else if(widths < 2000U)
+    	else if(img.wtd < 2000U)
     	{
-    		widths = 2000U;
+    		img.wtd = 2000U;
     	}
     	else
     	{
@@ -264,19 +736,23 @@ void pls_set_pulse(uint32_t dly,uint16_t wtd)
     }
     else
     {
-    	if(widths > 10000U)
+    	if(img.wtd > 10000U)
     	{
-    		widths = 10000U;
+    		img.wtd = 10000U;
     	}
-    	else if(widths < 4000U)
+    	else if(img.wtd < 4000U)
     	{
-    		widths = 4000U;
+    		img.wtd = 4000U;
     	}
     	else
     	{
     		;
     	}
     }
+    pls_image(&img);
+    pls_next = img;
+    pls_ready = 1U;
+    (void)pls_publish();
   }
 }
 
@@ -290,6 +766,10 @@ void pls_set_pulse(uint32_t dly,uint16_t wtd)
 void pls_set_mode(uint8_t mod)
 {
   pls_mode = mod;
+  if(0 == mod)
+  {
+    pls_ready = 0;
+  }
 }
 
 /**
@@ -321,8 +801,7 @@ uint8_t pls_get_busy(void)
  */
 uint8_t pls_get_sta(void)
 {
-  pls_busy = 1U;
-  return pls_sta;  
+  return pls_sta;
 }
 
 /**
@@ -335,39 +814,105 @@ void pls_set_sta(uint8_t sta)
 }
 
 /**
- *@brief 从FLASH存储数据进行设置延时、脉宽参数
+ *@brief 按自动模式数组预备下一组时间参数
+ *
+ *在脉冲进行期间调用，把 @ref tims 当前下标的一组参数换算为寄存器映像存入预备区，开放触发时
+ *只需发布；手动模式时预备区由 pls_set_pulse() 设置，不处理
+ *@sa pls_set_param() 开放触发前装入时间参数
+ */
+void pls_prepare(void)
+{
+  if((0 == pls_mode) && (0 == pls_ready))
+  {
+    pls_next.ocr1a = tims[pls_index].dlys;
+    pls_next.wtd = tims[pls_index].wtd;
+    pls_next.ocr0a = 99U;
+    pls_image(&pls_next);
+    pls_ready = 1U;
+  }
+}
+
+/**
+ *@brief 开放触发前装入时间参数
+ *
+ *发布预备区并按已发布的映像写入定时器0、1；OC1A先强制为低电平，定时器1的时钟在触发时启动。
+ *外部中断0关闭、定时器1停止时调用，没有中断访问定时器1，不需关中断。自动模式下标前进一组，
+ *预备区待 pls_prepare() 重新预备。预备区未准备好时先预备
  *@sa pls_set_pulse() 手动设置时间参数
- *@sa tims
- *@sa pls_index
+ *@sa pls_prepare() 预备下一组时间参数
  */
 void pls_set_param(void)
 {
+  pls_prepare();
+  pls_busy = 0;
+  (void)pls_publish();
+  OCR0A = pls_next.ocr0a;
+  TCCR1B = 0;
+  TCCR1A = _BV(COM1A1);
+  TCCR1C = _BV(FOC1A);
+  TCNT1 = 0;
+  OCR1A = pls_next.ocr1a;
+  OCR1B = 0;
+  ICR1 = pls_next.icr1;
+  TCCR1A = pls_next.tccr1a;
+  TCCR1B = pls_next.tccr1b;
+  TIFR1 = _BV(OCF1A)|_BV(OCF1B)|_BV(TOV1);
+  pls_sta = PULSE_STA_DELAY;
   if(0 == pls_mode)
   {
-    delays = tims[pls_index].dlys;
-    widths = tims[pls_index].wtd;
-    pls_pre = 99U;
+    pls_ready = 0;
     pls_index++;
     if(pls_index >= 20U)
     {
       pls_index = 0;
     }
   }
-  OCR0A = pls_pre;
-  OCR1A = delays;
-  pls_sta = PULSE_STA_DELAY;
-  pls_busy = 0;
+}
+
+/**
+ *@brief 取自动模式数组下标
+ *@return 下一次自动设置使用的 @ref tims 数组下标
+ *@sa pls_set_index() 设置自动模式数组下标
+ */
+uint8_t pls_get_index(void)
+{
+  return pls_index;
+}
+
+/**
+ *@brief 设置自动模式数组下标
+ *@param[in] ind 下标，超出范围时从0开始
+ *@sa pls_get_index() 取自动模式数组下标
+ */
+void pls_set_index(uint8_t ind)
+{
+  if(ind >= 20U)
+  {
+    ind = 0;
+  }
+  pls_index = ind;
+  pls_ready = 0;
 }
 
 /**
  *@brief 得到延时数
- *@return 延时数，单位0.1ms
+ *@return 延时数，单位0.1ms；自动模式为最近开放触发的参数，手动模式为已设置的参数
  */
 uint32_t pls_get_delay(void)
 {
   uint32_t ret;
-  ret = delays;
-  if(pls_pre > 100U)
+  uint8_t pre;
+  if(0 == pls_mode)
+  {
+    ret = pls_bank[pls_pub].ocr1a;
+    pre = pls_bank[pls_pub].ocr0a;
+  }
+  else
+  {
+    ret = pls_next.ocr1a;
+    pre = pls_next.ocr0a;
+  }
+  if(pre > 100U)
   {
     ret *= 2U;
   }
@@ -376,13 +921,23 @@ uint32_t pls_get_delay(void)
 
 /**
  *@brief 得到脉宽数
- *@return 脉宽数，单位0.1ms
+ *@return 脉宽数，单位0.1ms；自动模式为最近开放触发的参数，手动模式为已设置的参数
  */
 uint16_t pls_get_width(void)
 {
   uint16_t ret;
-  ret = widths;
-  if(pls_pre > 100U)
+  uint8_t pre;
+  if(0 == pls_mode)
+  {
+    ret = pls_bank[pls_pub].wtd;
+    pre = pls_bank[pls_pub].ocr0a;
+  }
+  else
+  {
+    ret = pls_next.wtd;
+    pre = pls_next.ocr0a;
+  }
+  if(pre > 100U)
   {
     ret *= 2U;
   }
@@ -392,20 +947,544 @@ uint16_t pls_get_width(void)
 /**
  *@brief 数字字符串转整型数
  *@param str 数字字符串
- *@return 整型数
+ *@return 整型数，最多转换5位，遇到非数字字符结束
  */
 uint32_t pls_strtou(uint8_t str[])
 {
   uint32_t ret = 0;
-  int8_t i = 0;
-  while(str[i] != 0)
+  uint8_t i = 0;
+  while((i < 5U) && (str[i] >= '0') && (str[i] <= '9'))
   {
     ret *= 10U;
-    ret += (uint8_t)(str[i++] - 0x30U);
-    if(i >= 5U)
+    ret += (uint8_t)(str[i] - '0');
+    i++;
+  }
+  return ret;    
+}
+
+/**
+ *@brief 设置内部触发
+ *@param[in] period 触发周期，单位ms，按 @ref PLS_ITRIG_US 取整；0关闭内部触发
+ *@param[in] shots 触发次数， @ref PLS_ITRIG_CONT 连续触发
+ *
+ *内部触发由定时器2比较匹配B中断产生，与外部触发走同一路径，只在开放触发后有效，周期短于
+ *脉冲及重新开放触发所需时间时，开放后立即触发
+ *@sa pls_get_itrig() 取内部触发剩余次数
+ */
+void pls_set_itrig(uint16_t period,uint16_t shots)
+{
+  uint32_t ticks;
+  uint8_t sreg;
+  ticks = ((uint32_t)period * 1000UL) / PLS_ITRIG_US;
+  if(ticks > 0xffffUL)
+  {
+    ticks = 0xffffUL;
+  }
+  sreg = SREG;
+  cli();
+  if((0 != period) && (0 != shots))
+  {
+    if(0 == ticks)
     {
-      break;
+      ticks = 1U;
     }
+    pls_itrig_period = (uint16_t)ticks;
+    pls_itrig_cnt = (uint16_t)ticks;
+    pls_itrig_left = shots;
+    pls_itrig_pend = 0;
+    OCR2B = 0;
+    TIMSK2 |= _BV(OCIE2B);
   }
-  return ret;    
+  else
+  {
+    /*抑制计时仍由本中断完成，中断自行关闭*/
+    pls_itrig_period = 0;
+    pls_itrig_left = 0;
+    pls_itrig_pend = 0;
+  }
+  SREG = sreg;
+}
+
+/**
+ *@brief 取内部触发剩余次数
+ *@return 剩余次数，0内部触发已关闭， @ref PLS_ITRIG_CONT 连续触发
+ *@sa pls_set_itrig() 设置内部触发
+ */
+uint16_t pls_get_itrig(void)
+{
+  uint16_t ret;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_itrig_left;
+  SREG = sreg;
+  return ret;
+}
+
+/**
+ *@brief 内部触发一次
+ *
+ *在开放触发后调用，由定时器2比较匹配B中断按内部触发的路径触发一次，抑制期内顺延。不改变
+ * pls_set_itrig() 设置的周期和次数；关闭触发时取消
+ */
+void pls_emit(void)
+{
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  pls_emit_pend = 1U;
+  TIMSK2 |= _BV(OCIE2B);
+  SREG = sreg;
+}
+
+/**
+ *@brief 设置触发条件
+ *@param[in] edge 触发沿， @ref PLS_EDGE_FALL 下降沿， @ref PLS_EDGE_RISE 上升沿，
+ * @ref PLS_EDGE_BOTH 双沿
+ *@param[in] div 分频数，每div次触发产生一个脉冲，0按1处理
+ *@param[in] holdoff 脉冲结束后的触发抑制时间，单位ms，按 @ref PLS_ITRIG_US 取整，0不抑制
+ *
+ *触发沿、分频和抑制全部在中断服务程序中处理，抑制期内的触发计数后忽略，内部触发顺延
+ *@sa pls_get_trig() 取触发条件
+ *@sa pls_trig_idle() 触发端口是否为空闲电平
+ *@sa pls_get_ignored() 取抑制期内忽略的触发次数
+ */
+void pls_set_trig(uint8_t edge,uint8_t div,uint16_t holdoff)
+{
+  uint32_t ticks;
+  uint8_t sreg;
+  uint8_t isc;
+  ticks = ((uint32_t)holdoff * 1000UL) / PLS_ITRIG_US;
+  if(ticks > 0xffffUL)
+  {
+    ticks = 0xffffUL;
+  }
+  if((0 != holdoff) && (0 == ticks))
+  {
+    ticks = 1U;
+  }
+  if(PLS_EDGE_RISE == edge)
+  {
+    isc = _BV(ISC01)|_BV(ISC00);
+  }
+  else if(PLS_EDGE_BOTH == edge)
+  {
+    isc = _BV(ISC00);
+  }
+  else
+  {
+    edge = PLS_EDGE_FALL;
+    isc = _BV(ISC01);
+  }
+  sreg = SREG;
+  cli();
+  pls_edge = edge;
+  pls_div = (0 == div) ? 1U : div;
+  pls_div_cnt = 0;
+  pls_holdoff = (uint16_t)ticks;
+  pls_holdoff_ms = holdoff;
+  pls_ignored = 0;
+  EICRA = (uint8_t)((EICRA & ~(_BV(ISC01)|_BV(ISC00))) | isc);
+  /*改变触发沿可能置位中断标志*/
+  EIFR = _BV(INTF0);
+  SREG = sreg;
+}
+
+/**
+ *@brief 取触发条件
+ *@param[out] div 分频数
+ *@param[out] holdoff 触发抑制时间，ms
+ *@return 触发沿， @ref PLS_EDGE_FALL 等
+ *@sa pls_set_trig() 设置触发条件
+ */
+uint8_t pls_get_trig(uint8_t *div,uint16_t *holdoff)
+{
+  *div = pls_div;
+  *holdoff = pls_holdoff_ms;
+  return pls_edge;
+}
+
+/**
+ *@brief 触发端口是否为空闲电平
+ *@return 非零空闲，可以开放触发；0触发端口处于有效电平
+ *
+ *下降沿触发时高电平为空闲，上升沿触发时低电平为空闲，双沿触发时总为空闲
+ */
+uint8_t pls_trig_idle(void)
+{
+  uint8_t ret;
+  uint8_t lvl;
+  lvl = SPARK_PINS & _BV(SPARK_PIN);
+  if(PLS_EDGE_FALL == pls_edge)
+  {
+    ret = (0 != lvl) ? 1U : 0;
+  }
+  else if(PLS_EDGE_RISE == pls_edge)
+  {
+    ret = (0 == lvl) ? 1U : 0;
+  }
+  else
+  {
+    ret = 1U;
+  }
+  return ret;
+}
+
+/**
+ *@brief 取抑制期内忽略的触发次数
+ *@return 次数，最大65535，设置触发条件时清零
+ */
+uint16_t pls_get_ignored(void)
+{
+  uint16_t ret;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_ignored;
+  SREG = sreg;
+  return ret;
+}
+
+/**
+ *@brief 设置脉冲产生方式
+ *@param[in] out 方式
+ *- @ref PLS_OUT_ISR 中断方式，缺省值，延时边沿后由定时器1比较匹配中断装入脉宽数
+ *- @ref PLS_OUT_HW 硬件边沿方式，两个边沿都由定时器1产生，边沿之间不需要中断服务
+ *
+ *手动模式已设置的参数按新方式重新换算，自动模式在下一次开放触发前重新预备
+ */
+void pls_set_out(uint8_t out)
+{
+  pls_out = (PLS_OUT_HW == out) ? PLS_OUT_HW : PLS_OUT_ISR;
+  pls_image(&pls_next);
+  (void)pls_publish();
+  if(0 == pls_mode)
+  {
+    pls_ready = 0;
+  }
+}
+
+/**
+ *@brief 开放触发
+ *
+ *在 pls_set_param() 之后调用。有排队的触发时取出最早的一个立即产生脉冲，记录等待时间；否则置开放
+ *触发标志。外部中断0原来关闭时先清除关闭期间置位的中断标志。从机不响应触发，装入定时器参数
+ *等待主机的时基
+ *@sa pls_disarm() 关闭触发
+ */
+void pls_arm(void)
+{
+  uint8_t sreg;
+  uint8_t head;
+  uint16_t wait;
+  sreg = SREG;
+  cli();
+  if(PLS_SYNC_SLAVE == pls_sync)
+  {
+    pls_sync_arm();
+  }
+  else
+  {
+    if(0 == (EIMSK & _BV(INT0)))
+    {
+      EIFR = _BV(INTF0);
+      EIMSK |= _BV(INT0);
+    }
+    if(0 != pls_qlen)
+    {
+      head = pls_qhead;
+      wait = pls_clock - pls_queue[head];
+      if(wait > pls_qwait)
+      {
+        pls_qwait = wait;
+      }
+      pls_qhead = (uint8_t)(head + 1U) & (PLS_QUEUE_SIZE - 1U);
+      pls_qlen--;
+      pls_fire(2U);
+    }
+    else
+    {
+      pls_armed = 1U;
+    }
+  }
+  SREG = sreg;
+}
+
+/**
+ *@brief 未在产生脉冲时关闭触发
+ *@return 0正在产生脉冲，不能关闭；非零已关闭
+ *
+ *关中断确认未触发后关闭外部中断0，此后的触发不计为溢出；排队的触发计为丢失。从机停止定时器1，
+ *不再等待主机的时基
+ *@sa pls_arm() 开放触发
+ */
+uint8_t pls_disarm(void)
+{
+  uint8_t ret = 0;
+  uint8_t sreg;
+  uint16_t cnt;
+  sreg = SREG;
+  cli();
+  if(0 == pls_busy)
+  {
+    EIMSK &= ~_BV(INT0);
+    PCICR &= ~_BV(PCIE2);
+    if(PLS_SYNC_SLAVE == pls_sync)
+    {
+      TCCR1B = 0;
+      TIMSK1 = 0;
+      TCNT1 = 0;
+    }
+    pls_armed = 0;
+    pls_emit_pend = 0;
+    cnt = pls_dropped + pls_qlen;
+    pls_dropped = (cnt < pls_dropped) ? 0xffffU : cnt;
+    pls_qlen = 0;
+    ret = 1U;
+  }
+  SREG = sreg;
+  return ret;
+}
+
+/**
+ *@brief 设置溢出触发的处理方式
+ *@param[in] policy 处理方式
+ *- @ref PLS_OVR_DROP 丢弃，缺省值
+ *- @ref PLS_OVR_QUEUE 排队，最多 @ref PLS_QUEUE_SIZE 个，开放触发时按到达顺序立即产生脉冲，
+ *  排满后计为丢失
+ *- @ref PLS_OVR_RESTART 脉冲进行期间的触发使脉冲从头重新开始，脉冲完成到开放触发之间的计为丢失
+ *
+ *溢出触发指脉冲进行期间及完成后到再次开放触发之间到达的有效触发。计数及排队清零
+ */
+void pls_set_ovr(uint8_t policy)
+{
+  uint8_t sreg;
+  if(policy > PLS_OVR_RESTART)
+  {
+    policy = PLS_OVR_DROP;
+  }
+  sreg = SREG;
+  cli();
+  pls_ovr = policy;
+  pls_overrun = 0;
+  pls_dropped = 0;
+  pls_qlen = 0;
+  pls_qwait = 0;
+  if(PLS_OVR_QUEUE == policy)
+  {
+    TIMSK2 |= _BV(OCIE2B);
+  }
+  SREG = sreg;
+}
+
+/**
+ *@brief 取溢出触发的处理方式
+ *@return @ref PLS_OVR_DROP 等
+ */
+uint8_t pls_get_ovr(void)
+{
+  return pls_ovr;
+}
+
+/**
+ *@brief 取溢出触发次数
+ *@return 未开放触发时到达的有效触发次数，最大65535，设置处理方式时清零
+ */
+uint16_t pls_get_overrun(void)
+{
+  uint16_t ret;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_overrun;
+  SREG = sreg;
+  return ret;
+}
+
+/**
+ *@brief 取丢失的触发次数
+ *@return 没有产生脉冲的溢出触发次数，最大65535，设置处理方式时清零
+ */
+uint16_t pls_get_dropped(void)
+{
+  uint16_t ret;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_dropped;
+  SREG = sreg;
+  return ret;
+}
+
+/**
+ *@brief 取排队等待的触发数
+ *@return 0～ @ref PLS_QUEUE_SIZE
+ */
+uint8_t pls_get_queued(void)
+{
+  return pls_qlen;
+}
+
+/**
+ *@brief 取排队触发的最长等待时间
+ *@return 从到达到产生脉冲的最长时间，单位ms，设置处理方式时清零
+ */
+uint16_t pls_get_qwait(void)
+{
+  uint32_t ret;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_qwait;
+  SREG = sreg;
+  ret = (ret * PLS_ITRIG_US) / 1000UL;
+  return (ret > 0xffffUL) ? 0xffffU : (uint16_t)ret;
+}
+
+/**
+ *@brief 设置响应测量
+ *@param[in] edge 响应沿， @ref PLS_EDGE_RISE 上升沿，其它按下降沿
+ *@param[in] window_ms 测量窗口，ms，最长 @ref PLS_ECHO_MAX_MS ；0不测量
+ *
+ *脉冲后沿起在窗口内测量到响应输入第一个有效沿的时间，窗口结束前脉冲不算完成。响应信号接board.h的
+ *响应输入（Nano、Pro Mini为A7），没有响应输入的开发板不测量；模拟比较器以1.1V带隙基准为门限，输出接
+ *定时器1输入捕获，门限不合适时用分压调整。分辨率随窗口：
+ *32ms以内0.5us，262ms以内4us，1048ms以内16us，其余64us
+ *@sa pls_get_echo() 取响应测量结果
+ */
+void pls_set_echo(uint8_t edge,uint16_t window_ms)
+{
+  uint32_t us;
+  uint8_t tccr1b = 0;
+  uint8_t half = 1U;
+  uint8_t sreg;
+  us = (uint32_t)window_ms * 1000UL;
+  if((0 == window_ms) || (ECHO_MUX_NONE == ECHO_MUX))
+  {
+    ACSR = _BV(ACD);
+  }
+  else
+  {
+    if(us <= 32767UL)
+    {
+      tccr1b = _BV(CS11);
+    }
+    else if(us <= 262140UL)
+    {
+      tccr1b = _BV(CS11)|_BV(CS10);
+      half = 8U;
+    }
+    else if(us <= 1048560UL)
+    {
+      tccr1b = _BV(CS12);
+      half = 32U;
+    }
+    else
+    {
+      tccr1b = _BV(CS12)|_BV(CS10);
+      half = 128U;
+      if(us > 4194240UL)
+      {
+        us = 4194240UL;
+      }
+    }
+    /*响应输入高于门限时比较器输出为0，上升沿对应比较器输出的下降沿*/
+    tccr1b |= _BV(ICNC1);
+    if(PLS_EDGE_RISE != edge)
+    {
+      tccr1b |= _BV(ICES1);
+    }
+    /*比较器正输入为带隙基准，负输入经ADC多路开关接响应输入，ADC须关闭*/
+    ADCSRA &= ~_BV(ADEN);
+    ADCSRB |= _BV(ACME);
+    ADMUX = (uint8_t)((ADMUX & 0xf0U) | ECHO_MUX);
+    ACSR = _BV(ACBG)|_BV(ACIC);
+  }
+  us = (us * 2U) / half;
+  sreg = SREG;
+  cli();
+  pls_echo_tccr1b = tccr1b;
+  pls_echo_win = (0 == us) ? 1U : (uint16_t)us;
+  pls_echo_half = half;
+  pls_echo_res = PLS_ECHO_NONE;
+  SREG = sreg;
+}
+
+/**
+ *@brief 取响应测量结果
+ *@param[out] us 测得响应时为脉冲后沿到响应的时间，us
+ *@return @ref PLS_ECHO_NONE 没有新结果； @ref PLS_ECHO_GOT 测得响应； @ref PLS_ECHO_TIMEOUT 窗口内没有响应
+ *
+ *脉冲完成后调用，结果读出后清除
+ *@sa pls_set_echo() 设置响应测量
+ */
+uint8_t pls_get_echo(uint32_t *us)
+{
+  uint8_t ret;
+  uint16_t ticks;
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  ret = pls_echo_res;
+  ticks = pls_echo_ticks;
+  pls_echo_res = PLS_ECHO_NONE;
+  SREG = sreg;
+  *us = ((uint32_t)ticks * pls_echo_half) / 2U;
+  return ret;
+}
+
+/**
+ *@brief 取最近一个脉冲从触发到脉冲后沿的时间
+ *@return 延时数加脉宽数，us
+ */
+uint32_t pls_get_span(void)
+{
+  volatile spreg_t *img;
+  uint32_t ret;
+  img = &pls_bank[pls_run];
+  ret = ((uint32_t)img->ocr1a + img->wtd) * 100UL;
+  if(img->ocr0a > 100U)
+  {
+    ret *= 2U;
+  }
+  return ret;
+}
+
+/**
+ *@brief 设置同步角色
+ *@param[in] role @ref PLS_SYNC_MASTER 或 @ref PLS_SYNC_SLAVE
+ *
+ *多台同步时各台的D6连在一起，D5仍与本台D6相连：主机触发后D6输出时基，从机D6为输入，定时器1
+ *由主机的时基计数，开放触发后在主机下一次触发时与主机同时开始。从机的延时数、脉宽数按主机的
+ *时基计数，应与主机使用同一时基（不超过16位）。在关闭触发后调用
+ *@sa pls_arm() 开放触发
+ */
+void pls_set_sync(uint8_t role)
+{
+  uint8_t sreg;
+  sreg = SREG;
+  cli();
+  if(PLS_SYNC_SLAVE == role)
+  {
+    pls_sync = PLS_SYNC_SLAVE;
+    TCCR0A = 0;
+    CLKOUT_DDR &= ~_BV(CLKOUT_PIN);
+  }
+  else
+  {
+    pls_sync = PLS_SYNC_MASTER;
+    PCICR &= ~_BV(PCIE2);
+    TCCR0A = _BV(COM0A0)|_BV(WGM01);
+    CLKOUT_DDR |= _BV(CLKOUT_PIN);
+  }
+  SREG = sreg;
+}
+
+/**
+ *@brief 取同步角色
+ *@return @ref PLS_SYNC_MASTER 或 @ref PLS_SYNC_SLAVE
+ */
+uint8_t pls_get_sync(void)
+{
+  return pls_sync;
 }
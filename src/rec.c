@@ -0,0 +1,98 @@
+/**
+ * @brief 运行记录器
+ * @file rec.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 运行记录保存在.noinit段，启动代码不清零，看门狗复位、外部复位后仍然保留；上电、掉电复位或
+ * 有效标志不符时清空。复位原因在.init3段从MCUSR读出并关闭看门狗，避免复位后看门狗仍在运行\n
+ * 函数列表：
+ *@sa rec_init() 初始化
+ *@sa rec_put() 记录一个事件
+ *@sa rec_get_cause() 取复位原因
+ *@sa rec_dump() 发送复位原因及记录
+ */
+#include <avr/wdt.h>
+#include "rec.h"
+#include "uart.h"
+#include "msg.h"
+
+srec_t rec_ring[REC_SIZE] __attribute__ ((section (".noinit")));/**<循环记录缓冲区*/
+uint8_t rec_index __attribute__ ((section (".noinit")));/**<下一条记录的下标*/
+uint16_t rec_magic __attribute__ ((section (".noinit")));/**<记录有效标志*/
+uint8_t rec_mcusr __attribute__ ((section (".noinit")));/**<复位原因，MCUSR*/
+
+/**
+ *@brief 读取复位原因并关闭看门狗
+ *
+ *在.init3段执行，早于全局变量初始化和main()
+ */
+void rec_get_mcusr(void) __attribute__ ((naked)) __attribute__ ((section (".init3")));
+void rec_get_mcusr(void)
+{
+  rec_mcusr = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+/**
+ *@brief 初始化
+ *
+ *上电、掉电复位或记录无效时清空记录，然后记录本次复位
+ */
+void rec_init(void)
+{
+  uint8_t i;
+  if((REC_MAGIC != rec_magic) || (0 != (rec_mcusr & (_BV(PORF)|_BV(BORF)))))
+  {
+    for(i = 0;i < REC_SIZE;i++)
+    {
+      rec_ring[i].tag = 0;
+      rec_ring[i].data = 0;
+    }
+    rec_index = 0;
+    rec_magic = REC_MAGIC;
+  }
+  rec_index &= (REC_SIZE - 1U);
+  rec_put(REC_EV_BOOT,rec_mcusr);
+}
+
+/**
+ *@brief 取复位原因
+ *@return MCUSR的复位标志，WDRF看门狗复位、BORF掉电复位、EXTRF外部复位、PORF上电复位
+ */
+uint8_t rec_get_cause(void)
+{
+  return rec_mcusr;
+}
+
+/**
+ *@brief 发送复位原因及记录
+ *@param[in] all 非零时总是发送记录
+ *
+ *按“Reset xx”发送复位原因，看门狗复位或要求发送时再从最早的一条起按“事件 数据”逐行发送全部记录
+ */
+void rec_dump(uint8_t all)
+{
+  uint8_t i;
+  uint8_t ind;
+  msg_put_args(MSG_RESET,rec_mcusr,0);
+  if((0 != all) || (0 != (rec_mcusr & _BV(WDRF))))
+  {
+    msg_put(MSG_LOG);
+    ind = rec_index;
+    for(i = 0;i < REC_SIZE;i++)
+    {
+      if(0 != rec_ring[ind].tag)
+      {
+        uart_write_hex(rec_ring[ind].tag);
+        uart_send(' ');
+        uart_write_hex(rec_ring[ind].data);
+        uart_send('\n');
+        uart_send('\r');
+      }
+      ind = (uint8_t)((ind + 1U) & (REC_SIZE - 1U));
+    }
+  }
+}
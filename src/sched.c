@@ -0,0 +1,93 @@
+/**
+ * @brief 事件驱动协作式调度器
+ * @file sched.c
+ * @author shenxf 380406785@@qq.com
+ * @version V1.2.0
+ * @date 2016-10-24
+ *
+ * 各中断服务程序以 @ref sched_post 置事件标志，主循环调用 @ref sched_run 取出并清除全部事件，
+ * 依次调用任务表中响应该事件的任务；无事件时进入空闲睡眠，由下一个中断唤醒。\n
+ * 函数列表：
+ *@sa sched_init() 初始化
+ *@sa sched_set_tasks() 设置任务表
+ *@sa sched_run() 分派一次事件
+ */
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "sched.h"
+#include "prof.h"
+
+static const __flash stask_t *sched_tasks;/**<当前任务表*/
+static uint8_t sched_ntasks;/**<当前任务表的任务数*/
+
+/**
+ *@brief 初始化
+ *
+ *清除事件标志，睡眠方式设置为空闲模式，定时器、串口在空闲模式下继续工作
+ */
+void sched_init(void)
+{
+  SCHED_EVENTS = 0;
+  sched_tasks = 0;
+  sched_ntasks = 0;
+  set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+/**
+ *@brief 设置任务表
+ *@param[in] tasks 存在FLASH的任务表
+ *@param[in] n 任务数
+ *
+ *工作模式以任务表的形式给出，切换模式即切换任务表，可在任务中调用
+ */
+void sched_set_tasks(const __flash stask_t tasks[],uint8_t n)
+{
+  sched_tasks = tasks;
+  sched_ntasks = n;
+}
+
+/**
+ *@brief 分派一次事件
+ *
+ *关中断取出并清除全部事件标志；无事件时开中断并立即睡眠（sei后的一条指令先于中断执行，
+ *不会丢失唤醒），否则按任务表顺序调用响应事件的任务。看门狗只在这里复位
+ */
+void sched_run(void)
+{
+  uint8_t ev;
+  uint8_t i;
+  uint8_t n;
+  const __flash stask_t *tasks;
+
+  cli();
+  ev = SCHED_EVENTS;
+  if(0 == ev)
+  {
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+  else
+  {
+    SCHED_EVENTS = 0;
+    sei();
+    /*只在分派节拍事件时喂狗，节拍中断或主循环任一停止都将导致看门狗复位*/
+    if(0 != (ev & SCHED_EV_TICK))
+    {
+      wdt_reset();
+    }
+    tasks = sched_tasks;
+    n = sched_ntasks;
+    for(i = 0;i < n;i++)
+    {
+      if(0 != (tasks[i].mask & ev))
+      {
+        PROF_ENTER();
+        tasks[i].fn(ev);
+        PROF_EXIT(PROF_ID_TASK + i);
+      }
+    }
+  }
+}
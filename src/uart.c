@@ -5,23 +5,95 @@
  * @version V1.1.0
  * @date 2016-10-17
  *
- * 串口接口驱动程序，中断接收，查询发送\n
+ * 串口接口驱动程序，中断接收，中断发送。多机方式的地址选择在接收中断中完成，未选中时接收的
+ * 字节不入队、不产生串口接收事件\n
  * 函数列表：
  *@sa uart_init() 初始化
  *@sa uart_send() 发送一个字符
  *@sa uart_getchar() 接收一个字符
+ *@sa uart_peek() 读取队头字符
  *@sa uart_getnum()  接收数字字符串
+ *@sa uart_readnum() 非阻塞接收数字字符串
  *@sa uart_putsn_P() 发送FLASH的字符串
+ *@sa uart_puts_P() 发送FLASH中以'\0'结束的字符串
  *@sa uart_flush() 清空接收缓冲区
  *@sa uart_received() 是否已接收了数据／字符
  *@sa uart_write_times() 发送时间参数数据
+ *@sa uart_write_hex() 发送十六进制数
+ *@sa uart_write_dec() 发送十进制数
+ *@sa uart_set_addr() 设置本机地址
+ *@sa uart_get_addr() 取本机地址
  */
 #include <avr/interrupt.h>
 #include "uart.h"
+#include "sched.h"
+#include "prof.h"
 
 uint8_t uart_rxbuf[16];      /**<接收循环队列缓冲区*/
 volatile uint8_t uart_head;  /**<队头*/
 volatile uint8_t uart_end;   /**<队尾*/
+static uint8_t uart_numlen;  /**<非阻塞接收的数字字符串当前长度*/
+
+#define UART_RX_SEL   0x01U /**<已选中，接收的数据入队*/
+#define UART_RX_MARK  0x02U /**<已收到 @ref UART_ADDR_MARK ，下一字节为地址*/
+#define UART_RX_ESC   0x04U /**<已收到 @ref UART_ADDR_ESC ，下一字节为数据*/
+
+volatile uint8_t uart_addr;  /**<本机地址，0单机方式*/
+volatile uint8_t uart_rxsta; /**<多机方式的接收状态， @ref UART_RX_SEL 等*/
+volatile uint8_t uart_talk;  /**<允许发送，多机方式下只在被单独选中时非零*/
+
+uint8_t uart_txbuf[UART_TXSIZE]; /**<发送循环队列缓冲区*/
+volatile uint8_t uart_txhead;    /**<发送队头*/
+volatile uint8_t uart_txend;     /**<发送队尾*/
+
+/**
+ *@brief 多机方式的接收字节，在接收中断中调用
+ *@param[in] ch 接收的字节
+ *@return 非零为选中时的数据字节，应入队；0为地址选择字节或未选中
+ *
+ *地址字节等于本机地址时选中并允许发送，打开发送器；为广播地址时选中但不允许发送；其它地址
+ *取消选中，由发送中断丢弃发送队列，已写入UDR的字符发送完（TXC）后关闭发送器
+ */
+static inline uint8_t uart_rx_addr(uint8_t ch)
+{
+  uint8_t sta;
+  uint8_t ret = 0;
+  sta = uart_rxsta;
+  if(0 != (sta & UART_RX_MARK))
+  {
+    if(ch == uart_addr)
+    {
+      uart_talk = 1U;
+      UCSRB |= _BV(TXEN);
+      sta = UART_RX_SEL;
+    }
+    else
+    {
+      uart_talk = 0;
+      UCSRB |= _BV(UDRIE);
+      sta = (UART_ADDR_ALL == ch) ? UART_RX_SEL : 0;
+    }
+  }
+  else if(0 != (sta & UART_RX_ESC))
+  {
+    sta &= ~UART_RX_ESC;
+    ret = sta;
+  }
+  else if(UART_ADDR_MARK == ch)
+  {
+    sta |= UART_RX_MARK;
+  }
+  else if(UART_ADDR_ESC == ch)
+  {
+    sta |= UART_RX_ESC;
+  }
+  else
+  {
+    ret = sta;
+  }
+  uart_rxsta = sta;
+  return ret;
+}
 
 /**
  *@brief 中断接收服务程序
@@ -29,14 +101,78 @@ volatile uint8_t uart_end;   /**<队尾*/
 ISR(USART_RX_vect)
 {
   uint8_t ind;
-  ind = uart_end;
-  uart_rxbuf[ind] = UDR;
-  ind++;
-  if(ind >= 16U)
+  uint8_t ch;
+  PROF_ENTER();
+  ch = UDR;
+  if((0 == uart_addr) || (0 != uart_rx_addr(ch)))
   {
-    ind = 0;
+    ind = uart_end;
+    uart_rxbuf[ind] = ch;
+    ind++;
+    if(ind >= 16U)
+    {
+      ind = 0;
+    }
+    uart_end = ind;
+    sched_post(SCHED_EV_UART);
+  }
+  PROF_EXIT(PROF_ID_URX);
+}
+
+/**
+ *@brief 发送数据寄存器空中断服务程序
+ *
+ *从发送队列取一个字符发送，队列空时禁止本中断。不允许发送时丢弃队列中的字符，不再发给
+ *已选中其它从机的总线；写入UDR的字符尚未发送完（ @ref TXCIE 已置位）时由发送完成中断
+ *关闭发送器，否则立即关闭，TXD成为输入，释放多机总线
+ */
+ISR(USART_UDRE_vect)
+{
+  uint8_t ind;
+  PROF_ENTER();
+  ind = uart_txhead;
+  if(0 == uart_talk)
+  {
+    uart_txhead = uart_txend;
+    if(0 != (UCSRB & _BV(TXCIE)))
+    {
+      UCSRB &= ~_BV(UDRIE);
+    }
+    else
+    {
+      UCSRB &= ~(_BV(UDRIE)|_BV(TXEN));
+    }
+  }
+  else if(ind == uart_txend)
+  {
+    UCSRB &= ~_BV(UDRIE);
+  }
+  else
+  {
+    /*清除TXC（写1清零，FE、DOR、UPE须写0），本字符移出后才置位*/
+    UCSRA = (uint8_t)((UCSRA & _BV(U2X)) | _BV(TXC));
+    UDR = uart_txbuf[ind];
+    uart_txhead = (uint8_t)((ind + 1U) & (UART_TXSIZE - 1U));
+    UCSRB |= _BV(TXCIE);
+  }
+  PROF_EXIT(PROF_ID_UDRE);
+}
+
+/**
+ *@brief 发送完成中断服务程序
+ *
+ *移位寄存器中的字符已发送完且UDR空（TXC），不允许发送时关闭发送器
+ */
+ISR(USART_TX_vect)
+{
+  if(0 == uart_talk)
+  {
+    UCSRB &= ~(_BV(TXCIE)|_BV(TXEN));
+  }
+  else
+  {
+    UCSRB &= ~_BV(TXCIE);
   }
-  uart_end = ind;
 }
 
 /**
@@ -103,6 +239,27 @@ void uart_putsn_P(const __flash char str[],uint8_t n)
 	}
 }
 
+/**
+ *@brief 发送FLASH中以'\0'结束的字符串
+ *@param[in] str 字符串
+ *@sa uart_putsn_P() 发送FLASH的字符串
+ */
+void uart_puts_P(const __flash char *str)
+{
+  uint8_t ch;
+  ch = (uint8_t)*str;
+  while('\0' != ch)
+  {
+    if('\n' == ch)
+    {
+      uart_send('\r');
+    }
+    uart_send(ch);
+    str++;
+    ch = (uint8_t)*str;
+  }
+}
+
 /**
  *@brief 接收一个字符
  *@return  接收的字符 
@@ -118,7 +275,7 @@ uint8_t uart_getchar(void)
 	uint8_t ret;
 	while(uart_head == uart_end)
 	{
-		__builtin_avr_wdr();
+		__builtin_avr_nop();
 	}
 	ret = uart_rxbuf[uart_head];
 	uart_head++;
@@ -129,9 +286,19 @@ uint8_t uart_getchar(void)
 	return ret;
 }
 
+/**
+ *@brief 读取接收队列的队头字符，不从队列中取出
+ *@return 队头字符，应先以 uart_received() 确认已接收
+ *@sa uart_getchar() 接收一个字符
+*/
+uint8_t uart_peek(void)
+{
+	return uart_rxbuf[uart_head];
+}
+
 /**
  *@brief 接收1-5位十进制数字符串
- *@param[out] str 字符串
+ *@param[out] str 字符串，至少6字节，以0结尾
  *@return 遇非数字字符返回0，返回不大于5的数字字符串长度
  *@sa uart_send() 发送一个字符
  *@sa uart_getchar() 接收一个字符
@@ -150,7 +317,7 @@ int8_t uart_getnum(uint8_t str[])
 	{
 		if((ch >= '0')&&(ch <= '9'))
 		{
-			if(ret < 5U)
+			if(ret < 5)
 			{
 			    str[ret] = ch;
 				ret++;
@@ -158,7 +325,7 @@ int8_t uart_getnum(uint8_t str[])
 			}
 			else
 			{
-			    ret = 5U;
+			    ret = 5;
 			}
 		}
 		else if(0x08U == ch)
@@ -175,12 +342,60 @@ int8_t uart_getnum(uint8_t str[])
 		}
         ch = uart_getchar();
 	}
+	str[ret] = 0;
 	return ret;
 }
 
+/**
+ *@brief 非阻塞接收1-5位十进制数字符串
+ *@param[out] str 字符串，至少6字节，接收完毕时以0结尾
+ *@return 未接收到结束字符返回-1；接收完毕返回不大于5的数字字符串长度
+ *
+ *只处理缓冲区中已接收的字符，不等待。回车或非数字字符结束接收，退格删除一位
+ *@sa uart_getnum()  接收数字字符串
+*/
+int8_t uart_readnum(uint8_t str[])
+{
+  int8_t ret = -1;
+  uint8_t ch;
+  while((ret < 0) && (uart_received() != 0))
+  {
+    ch = uart_getchar();
+    if((ch >= '0')&&(ch <= '9'))
+    {
+      if(uart_numlen < 5U)
+      {
+        str[uart_numlen] = ch;
+        uart_numlen++;
+        uart_send(ch);
+      }
+    }
+    else if(0x08U == ch)
+    {
+      if(uart_numlen > 0)
+      {
+        uart_numlen--;
+        uart_send(ch);
+      }
+    }
+    else
+    {
+      ret = (int8_t)uart_numlen;
+    }
+  }
+  if(ret >= 0)
+  {
+    str[uart_numlen] = 0;
+    uart_numlen = 0;
+  }
+  return ret;
+}
+
 /**
  *@brief 串口初始化
  *@param[in] baud 波特率
+ *
+ *多机方式（已由 uart_set_addr() 设置本机地址）时上电未选中，发送器关闭
 */
 void uart_init(uint32_t baud)
 {
@@ -196,13 +411,29 @@ void uart_init(uint32_t baud)
 	}		
 	UBRRH = (uint8_t)(pri >> 8);
 	UBRRL = (uint8_t)pri;
-	UCSRB = _BV(RXEN) | _BV(TXEN) | _BV(RXCIE);
+	uart_txhead = 0;
+	uart_txend = 0;
+	if(0 == uart_addr)
+	{
+		uart_rxsta = UART_RX_SEL;
+		uart_talk = 1U;
+		UCSRB = _BV(RXEN) | _BV(TXEN) | _BV(RXCIE);
+	}
+	else
+	{
+		uart_rxsta = 0;
+		uart_talk = 0;
+		UCSRB = _BV(RXEN) | _BV(RXCIE);
+	}
 	UCSRC = _BV(UCSZ1) | _BV(UCSZ0);
 }
 
 /**
  *@brief 发送一个字符数据
  *@param byte 预发送的字符
+ *
+ *字符存入发送队列由中断发送，队列未满时立即返回；多机方式下未被单独选中时丢弃。UCSR0B不能
+ *按位操作，读改写须关中断，否则可能覆盖接收中断在其间对TXEN、UDRIE的修改
  *@sa uart_getchar() 接收一个字符
  *@sa uart_getnum()  接收数字字符串
  *@sa uart_putsn_P() 发送FLASH的字符串
@@ -212,11 +443,24 @@ void uart_init(uint32_t baud)
 */
 void uart_send(uint8_t byte)
 {
-	while(_BV(UDRE) != (UCSRA & _BV(UDRE)))
-	{
-	  __builtin_avr_nop();
-	} 
-	UDR = byte;
+  uint8_t ind;
+  uint8_t sreg;
+  if(0 == uart_talk)
+  {
+    return;
+  }
+  ind = (uint8_t)((uart_txend + 1U) & (UART_TXSIZE - 1U));
+  /*发送队列满时等待*/
+  while(ind == uart_txhead)
+  {
+    __builtin_avr_nop();
+  }
+  uart_txbuf[uart_txend] = byte;
+  uart_txend = ind;
+  sreg = SREG;
+  cli();
+  UCSRB |= _BV(UDRIE);
+  SREG = sreg;
 }
 
 /**
@@ -234,6 +478,7 @@ void uart_write_times(uint32_t num)
   uint8_t str[6];
   uint8_t i,dgt;
   uint32_t n;
+  PROF_ENTER();
   for(i = 0;i < 6;i++)
   {
     str[i] = '0';
@@ -260,4 +505,86 @@ void uart_write_times(uint32_t num)
        uart_send(str[i]);
     }
   }
+  PROF_EXIT(PROF_ID_WRT);
+}
+
+/**
+ *@brief 按两位十六进制数发送一个字节
+ *@param byte 预发送的字节
+ *@sa uart_send() 发送一个字符
+*/
+void uart_write_hex(uint8_t byte)
+{
+  uint8_t i;
+  uint8_t dgt;
+  for(i = 0;i < 2U;i++)
+  {
+    dgt = (uint8_t)((byte >> 4) & 0x0fU);
+    if(dgt < 10U)
+    {
+      uart_send((uint8_t)('0' + dgt));
+    }
+    else
+    {
+      uart_send((uint8_t)('a' + dgt - 10U));
+    }
+    byte = (uint8_t)(byte << 4);
+  }
+}
+
+/**
+ *@brief 发送十进制数，不补零
+ *@param num 预发送的数
+ *@sa uart_send() 发送一个字符
+*/
+void uart_write_dec(uint32_t num)
+{
+  uint8_t str[10];
+  uint8_t i = 0;
+  do
+  {
+    str[i] = (uint8_t)('0' + (num % 10U));
+    num /= 10U;
+    i++;
+  }while(0 != num);
+  while(0 != i)
+  {
+    i--;
+    uart_send(str[i]);
+  }
+}
+
+/**
+ *@brief 设置本机地址
+ *@param addr 1～ @ref UART_ADDR_MAX 为多机方式的地址；0为单机方式，接收全部字节并发送
+ *
+ *在 uart_init() 之前调用时为上电恢复的地址；运行中改变地址时保持当前的选中状态，
+ *改为单机方式时立即选中并打开发送器
+ */
+void uart_set_addr(uint8_t addr)
+{
+  uint8_t sreg;
+  if(addr > UART_ADDR_MAX)
+  {
+    addr = 0;
+  }
+  sreg = SREG;
+  cli();
+  uart_addr = addr;
+  if(0 == addr)
+  {
+    uart_rxsta = UART_RX_SEL;
+    uart_talk = 1U;
+    UCSRB |= _BV(TXEN);
+  }
+  SREG = sreg;
+}
+
+/**
+ *@brief 取本机地址
+ *@return 0单机方式，否则为多机方式的地址
+ */
+uint8_t uart_get_addr(void)
+{
+  return uart_addr;
 }